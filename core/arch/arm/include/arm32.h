@@ -179,7 +179,7 @@ static inline void dsb(void)
 
 static inline void dsb_ish(void)
 {
-	asm volatile ("dsb ish");
+	asm volatile ("dsb ish" : : : "memory");
 }
 
 static inline void dsb_ishst(void)
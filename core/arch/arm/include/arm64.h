@@ -207,7 +207,7 @@ static inline void dsb(void)
 
 static inline void dsb_ish(void)
 {
-	asm volatile ("dsb ish");
+	asm volatile ("dsb ish" : : : "memory");
 }
 
 static inline void dsb_ishst(void)
@@ -328,6 +328,8 @@ DEFINE_U64_REG_READ_FUNC(midr_el1)
 /* Alias for reading this register to avoid ifdefs in code */
 #define read_midr() read_midr_el1()
 DEFINE_U64_REG_READ_FUNC(par_el1)
+DEFINE_U64_REG_READ_FUNC(elr_el1)
+DEFINE_U64_REG_READ_FUNC(spsr_el1)
 
 DEFINE_U64_REG_WRITE_FUNC(mair_el1)
 
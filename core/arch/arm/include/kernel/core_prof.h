@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2019, agent
+ */
+#ifndef KERNEL_CORE_PROF_H
+#define KERNEL_CORE_PROF_H
+
+#include <compiler.h>
+#include <pta_core_prof.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+#ifdef CFG_CORE_PROF
+/* Arms the sampling timer on the current CPU if sampling is started */
+void core_prof_pc_arm_cpu(void);
+TEE_Result core_prof_pc_start(uint32_t period_us);
+void core_prof_pc_stop(void);
+TEE_Result core_prof_pc_get(void *buf, size_t *len);
+
+/* Records a syscall of @ticks counter ticks */
+void core_prof_syscall_done(size_t scn, uint64_t ticks);
+TEE_Result core_prof_syscall_get(void *buf, size_t *len, bool reset);
+#else
+static inline void core_prof_pc_arm_cpu(void)
+{
+}
+
+static inline void core_prof_syscall_done(size_t scn __unused,
+					  uint64_t ticks __unused)
+{
+}
+#endif
+
+#endif /*KERNEL_CORE_PROF_H*/
@@ -13,6 +13,11 @@ struct mutex {
 	unsigned spin_lock;	/* used when operating on this struct */
 	struct wait_queue wq;
 	short state;		/* -1: write, 0: unlocked, > 0: readers */
+	short owner;		/* Thread ID of the writer if state == -1 */
+#ifdef CFG_LOCK_STAT
+	struct lock_stat_site *stat_site; /* Where write locked */
+	uint64_t stat_ts;		/* When write locked */
+#endif
 };
 #define MUTEX_INITIALIZER { .wq = WAIT_QUEUE_INITIALIZER }
 
@@ -21,6 +26,24 @@ TAILQ_HEAD(mutex_head, mutex);
 void mutex_init(struct mutex *m);
 void mutex_destroy(struct mutex *m);
 
+#define MUTEX_WAIT_BUCKETS	16
+
+/*
+ * struct mutex_wait_stats - statistics of contended mutex acquisitions
+ * @spun:	Number of acquisitions which only had to spin
+ * @slept:	Number of acquisitions which had to sleep in normal world
+ * @buckets:	Histogram of the wait times, buckets[0] counts waits below
+ *		1 us, buckets[n] waits in [2^(n-1), 2^n) us and the last
+ *		bucket all longer waits
+ */
+struct mutex_wait_stats {
+	uint32_t spun;
+	uint32_t slept;
+	uint32_t buckets[MUTEX_WAIT_BUCKETS];
+};
+
+void mutex_get_wait_stats(struct mutex_wait_stats *stats, bool reset);
+
 #ifdef CFG_MUTEX_DEBUG
 void mutex_unlock_debug(struct mutex *m, const char *fname, int lineno);
 #define mutex_unlock(m) mutex_unlock_debug((m), __FILE__, __LINE__)
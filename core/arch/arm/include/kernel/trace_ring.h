@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2019, agent
+ */
+#ifndef KERNEL_TRACE_RING_H
+#define KERNEL_TRACE_RING_H
+
+#include <compiler.h>
+#include <pta_trace_ring.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+/*
+ * Static tracepoints recording into per-CPU rings in secure memory. An
+ * event is a timestamp, an ID (TRACE_RING_* in <pta_trace_ring.h>), the
+ * current thread and a 32-bit argument. When recording isn't started a
+ * tracepoint costs a load and a branch.
+ */
+#ifdef CFG_CORE_TRACE_RING
+extern bool trace_ring_active;
+
+void __trace_ring_emit(uint16_t id, uint32_t arg);
+
+static inline void trace_ring_emit(uint16_t id, uint32_t arg)
+{
+	if (trace_ring_active)
+		__trace_ring_emit(id, arg);
+}
+
+void trace_ring_start(void);
+void trace_ring_stop(void);
+/*
+ * Copies the header and the rings into @buf, on TEE_ERROR_SHORT_BUFFER
+ * @len is updated with the required size.
+ */
+TEE_Result trace_ring_dump(void *buf, size_t *len);
+#else
+static inline void trace_ring_emit(uint16_t id __unused,
+				   uint32_t arg __unused)
+{
+}
+#endif
+
+#endif /*KERNEL_TRACE_RING_H*/
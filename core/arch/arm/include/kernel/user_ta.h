@@ -6,6 +6,7 @@
 #define KERNEL_USER_TA_H
 
 #include <assert.h>
+#include <kernel/mutex.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
 #include <mm/file.h>
@@ -40,6 +41,12 @@ SLIST_HEAD(load_seg_head, load_seg);
  * @ta_time_offs:	Time reference used by the TA
  * @areas:		Memory areas registered by pager
  * @vfp:		State of VFP registers
+ * @mu:			Protects the VM map, the segments and the lists of
+ *			handles of a concurrent TA
+ * @mu_owner:		Thread holding @mu or THREAD_ID_INVALID
+ * @num_threads:	Number of threads executing a concurrent TA
+ * @threads:		Per thread state of a concurrent TA, indexed with
+ *			the thread ID
  * @ctx:		Generic TA context
  */
 struct user_ta_ctx {
@@ -67,11 +74,45 @@ struct user_ta_ctx {
 	struct load_seg_head segs;
 #if defined(CFG_WITH_VFP)
 	struct thread_user_vfp_state vfp;
+#endif
+#if defined(CFG_TA_CONCURRENT)
+	struct mutex mu;
+	int mu_owner;
+	unsigned int num_threads;
+	struct user_ta_thread *threads;
 #endif
 	struct tee_ta_ctx ctx;
 
 };
 
+/*
+ * struct user_ta_thread - state of a thread executing a concurrent TA
+ * @stack_ptr:	Initial stack pointer of the user stack of the thread, 0 if
+ *		not allocated yet
+ * @vfp:	State of VFP registers
+ * @syscall_seq: Sequence number of the current syscall, never 0
+ * @claimed:	True if handles were claimed during the current syscall
+ */
+struct user_ta_thread {
+	vaddr_t stack_ptr;
+#if defined(CFG_WITH_VFP)
+	struct thread_user_vfp_state vfp;
+#endif
+	unsigned int syscall_seq;
+	bool claimed;
+};
+
+/*
+ * struct user_ta_claim - claim of a handle of a concurrent TA
+ * @thread:	Thread which claimed the handle
+ * @seq:	Syscall of @thread during which the handle was claimed, 0 if
+ *		never claimed
+ */
+struct user_ta_claim {
+	int thread;
+	unsigned int seq;
+};
+
 #ifdef CFG_WITH_USER_TA
 bool is_user_ta_ctx(struct tee_ta_ctx *ctx);
 #else
@@ -87,6 +128,58 @@ static inline struct user_ta_ctx *to_user_ta_ctx(struct tee_ta_ctx *ctx)
 	return container_of(ctx, struct user_ta_ctx, ctx);
 }
 
+#if defined(CFG_WITH_VFP)
+static inline struct thread_user_vfp_state *
+user_ta_get_vfp(struct user_ta_ctx *utc)
+{
+#if defined(CFG_TA_CONCURRENT)
+	if (utc->threads)
+		return &utc->threads[thread_get_id()].vfp;
+#endif
+	return &utc->vfp;
+}
+#endif
+
+#if defined(CFG_TA_CONCURRENT)
+/*
+ * The VM map and the lists of cryp states, objects and storage
+ * enumerators of a TA executing sessions concurrently are protected by
+ * user_ta_lock(). It returns true if the lock was taken, in which case
+ * user_ta_unlock() must be called, and false if the TA isn't concurrent
+ * or the lock is already held by the current thread.
+ */
+bool user_ta_lock(struct user_ta_ctx *utc);
+void user_ta_unlock(struct user_ta_ctx *utc);
+
+/*
+ * A handle looked up by a syscall is claimed with user_ta_claim(), with
+ * the lock held, until the syscall is done. Another thread can't claim
+ * it meanwhile and gets TEE_ERROR_BUSY, so a handle isn't freed while
+ * in use. user_ta_syscall_done() releases the claims of the syscall.
+ */
+TEE_Result user_ta_claim(struct user_ta_ctx *utc, struct user_ta_claim *c);
+void user_ta_syscall_done(void);
+#else
+static inline bool user_ta_lock(struct user_ta_ctx *utc __unused)
+{
+	return false;
+}
+
+static inline void user_ta_unlock(struct user_ta_ctx *utc __unused)
+{
+}
+
+static inline TEE_Result user_ta_claim(struct user_ta_ctx *utc __unused,
+				       struct user_ta_claim *c __unused)
+{
+	return TEE_SUCCESS;
+}
+
+static inline void user_ta_syscall_done(void)
+{
+}
+#endif
+
 struct user_ta_store_ops;
 
 #ifdef CFG_WITH_USER_TA
@@ -158,6 +251,25 @@ static inline TEE_Result user_ta_remap(struct user_ta_ctx *utc __unused,
 }
 #endif
 
+/*
+ * user_ta_get_file() - Get the file backing a mapped address
+ * @utc:	User TA context
+ * @va:		Address in a segment mapped with user_ta_map()
+ *
+ * Returns the file supplied to user_ta_map() when the segment covering
+ * @va was mapped, or NULL if there's no such segment or file. The file is
+ * valid as long as the segment is mapped.
+ */
+#ifdef CFG_WITH_USER_TA
+struct file *user_ta_get_file(struct user_ta_ctx *utc, vaddr_t va);
+#else
+static inline struct file *user_ta_get_file(struct user_ta_ctx *utc __unused,
+					    vaddr_t va __unused)
+{
+	return NULL;
+}
+#endif
+
 /*
  * Registers a TA storage.
  *
@@ -128,6 +128,35 @@ static inline size_t mobj_get_phys_granule(struct mobj *mobj)
 struct mobj *mobj_mm_alloc(struct mobj *mobj_parent, size_t size,
 			   tee_mm_pool_t *pool);
 
+/*
+ * struct mobj_bounce_stats - statistics of the bounce buffer pool
+ * @hits:		Number of allocations served from the pool
+ * @misses:		Number of allocations from secure DDR
+ * @evictions:		Number of pooled buffers released to secure DDR
+ * @cached_bytes:	Size of the buffers currently held by the pool
+ */
+struct mobj_bounce_stats {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+	size_t cached_bytes;
+};
+
+/*
+ * mobj_bounce_alloc() - allocate a temporary buffer in secure DDR
+ * @size:	Minimal size of the buffer
+ *
+ * Small buffers are recycled by mobj_bounce_free() instead of being
+ * returned to the secure DDR pool, repeated allocations of similar sizes
+ * are then served without tee_mm_alloc().
+ */
+struct mobj *mobj_bounce_alloc(size_t size);
+/* Wipes and returns a buffer from mobj_bounce_alloc() */
+void mobj_bounce_free(struct mobj *mobj);
+/* Releases all pooled buffers, returns true if any was released */
+bool mobj_bounce_evict(void);
+void mobj_bounce_get_stats(struct mobj_bounce_stats *stats);
+
 struct mobj *mobj_phys_alloc(paddr_t pa, size_t size, uint32_t cattr,
 			     enum buf_is_attr battr);
 
@@ -227,4 +256,23 @@ struct mobj *mobj_seccpy_shm_alloc(size_t size);
 
 struct mobj *mobj_with_fobj_alloc(struct fobj *fobj);
 
+/*
+ * mobj_ta_share_alloc() - share pages of a TA with another TA
+ * @src:	Unpaged mobj holding the pages
+ * @src_offs:	Page aligned offset in @src of the first page to share
+ * @num_pages:	Number of pages to share
+ * @head:	If true a private zeroed page is added before the shared pages
+ * @tail:	If true a private zeroed page is added after the shared pages
+ * @readonly:	If true the mobj is mapped read-only in user space
+ *
+ * The private head and tail pages hold the unaligned fragments of a
+ * buffer which must not expose the rest of their pages, they are the
+ * only pages accessible with mobj_get_va(). @src must outlive the
+ * returned mobj.
+ */
+struct mobj *mobj_ta_share_alloc(struct mobj *src, size_t src_offs,
+				 size_t num_pages, bool head, bool tail,
+				 bool readonly);
+bool mobj_is_readonly(struct mobj *mobj);
+
 #endif /*__MM_MOBJ_H*/
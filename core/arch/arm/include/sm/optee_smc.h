@@ -277,6 +277,10 @@
  * secure world accepts command buffers located in any parts of non-secure RAM
  */
 #define OPTEE_SMC_SEC_CAP_DYNAMIC_SHM		(1 << 2)
+/* Secure world supports OPTEE_MSG_CMD_REGISTER_QUEUE and friends */
+#define OPTEE_SMC_SEC_CAP_MSG_QUEUE		(1 << 3)
+/* Secure world supports OPTEE_SMC_CALL_INVOKE_WITH_REGS */
+#define OPTEE_SMC_SEC_CAP_INVOKE_WITH_REGS	(1 << 4)
 
 #define OPTEE_SMC_FUNCID_EXCHANGE_CAPABILITIES	9
 #define OPTEE_SMC_EXCHANGE_CAPABILITIES \
@@ -449,6 +453,39 @@
 #define OPTEE_SMC_GET_THREAD_COUNT \
 	OPTEE_SMC_FAST_CALL_VAL(OPTEE_SMC_FUNCID_GET_THREAD_COUNT)
 
+/*
+ * Invoke a command of an open session with the parameters in registers,
+ * without any struct optee_msg_arg. The Trusted Application gets two
+ * value parameters:
+ * param[0]: TEE_PARAM_TYPE_VALUE_INOUT
+ * param[1]: TEE_PARAM_TYPE_VALUE_INPUT
+ * param[2-3]: TEE_PARAM_TYPE_NONE
+ *
+ * Call register usage:
+ * a0	SMC Function ID, OPTEE_SMC_CALL_INVOKE_WITH_REGS
+ * a1	Session id
+ * a2	Trusted Application function
+ * a3	param[0].value.a
+ * a4	param[0].value.b
+ * a5	param[1].value.a
+ * a6	param[1].value.b
+ * a7	Hypervisor Client ID register
+ *
+ * Normal return register usage:
+ * a0	OPTEE_SMC_RETURN_OK
+ * a1	Return value, TEE_Result
+ * a2	param[0].value.a if a1 is TEE_SUCCESS, else the origin of the
+ *	return value, TEE_ORIGIN_*
+ * a3	param[0].value.b if a1 is TEE_SUCCESS, else 0
+ *
+ * The other return register usages and the possible return values are
+ * the same as for OPTEE_SMC_CALL_WITH_ARG above. Only available if
+ * OPTEE_SMC_SEC_CAP_INVOKE_WITH_REGS is reported.
+ */
+#define OPTEE_SMC_FUNCID_CALL_INVOKE_WITH_REGS	16
+#define OPTEE_SMC_CALL_INVOKE_WITH_REGS \
+	OPTEE_SMC_STD_CALL_VAL(OPTEE_SMC_FUNCID_CALL_INVOKE_WITH_REGS)
+
 /*
  * Resume from RPC (for example after processing a foreign interrupt)
  *
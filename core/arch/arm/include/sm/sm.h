@@ -37,6 +37,10 @@ struct sm_unbanked_regs {
 #ifdef CFG_SM_NO_CYCLE_COUNTING
 	uint32_t pmcr;
 #endif
+#ifdef CFG_TA_FTRACE_SUPPORT
+	/* Not banked, normal world may clear the EL0 counter access */
+	uint32_t cntkctl;
+#endif
 };
 
 struct sm_nsec_ctx {
@@ -79,12 +83,20 @@ struct sm_sec_ctx {
 	uint32_t mon_spsr;
 };
 
+/*
+ * The padding keeps sec.r0 and nsec.r0 8-byte aligned, where it goes
+ * depends on whether struct sm_unbanked_regs has an even number of words.
+ */
+#if defined(CFG_SM_NO_CYCLE_COUNTING) != defined(CFG_TA_FTRACE_SUPPORT)
+#define SM_UNBANKED_REGS_EVEN
+#endif
+
 struct sm_ctx {
-#ifndef CFG_SM_NO_CYCLE_COUNTING
+#ifndef SM_UNBANKED_REGS_EVEN
 	uint32_t pad;
 #endif
 	struct sm_sec_ctx sec;
-#ifdef CFG_SM_NO_CYCLE_COUNTING
+#ifdef SM_UNBANKED_REGS_EVEN
 	uint32_t pad;
 #endif
 	struct sm_nsec_ctx nsec;
@@ -373,7 +373,7 @@ static void handle_user_ta_vfp(void)
 	if (tee_ta_get_current_session(&s) != TEE_SUCCESS)
 		panic();
 
-	thread_user_enable_vfp(&to_user_ta_ctx(s->ctx)->vfp);
+	thread_user_enable_vfp(user_ta_get_vfp(to_user_ta_ctx(s->ctx)));
 }
 #endif /*CFG_WITH_VFP*/
 
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2019, agent
+ */
+
+#include <arm.h>
+#include <keep.h>
+#include <kernel/core_prof.h>
+#include <kernel/interrupt.h>
+#include <kernel/misc.h>
+#include <kernel/mutex.h>
+#include <kernel/thread.h>
+#include <mm/core_memprot.h>
+#include <mm/core_mmu.h>
+#include <mm/tee_mm.h>
+#include <string.h>
+#include <tee_syscall_numbers.h>
+#include <util.h>
+
+#include "thread_private.h"
+
+/*
+ * Syscall latencies are updated without locking, concurrent syscalls on
+ * different CPUs may occasionally lose an update.
+ */
+static struct core_prof_syscall syscall_lat[TEE_SCN_MAX + 1];
+
+void core_prof_syscall_done(size_t scn, uint64_t ticks)
+{
+	struct core_prof_syscall *s = NULL;
+	size_t b = 0;
+
+	if (scn >= ARRAY_SIZE(syscall_lat))
+		return;
+
+	if (ticks > 1)
+		b = MIN(63 - __builtin_clzll(ticks),
+			CORE_PROF_SYSCALL_BUCKETS - 1);
+
+	s = syscall_lat + scn;
+	s->count++;
+	s->total += ticks;
+	if (ticks > s->max)
+		s->max = ticks;
+	s->buckets[b]++;
+}
+
+TEE_Result core_prof_syscall_get(void *buf, size_t *len, bool reset)
+{
+	struct core_prof_syscall_hdr hdr = {
+		.freq = read_cntfrq(),
+		.num_syscalls = ARRAY_SIZE(syscall_lat),
+	};
+	size_t sz = sizeof(hdr) + sizeof(syscall_lat);
+
+	if (*len < sz) {
+		*len = sz;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	memcpy(buf, &hdr, sizeof(hdr));
+	memcpy((uint8_t *)buf + sizeof(hdr), syscall_lat, sizeof(syscall_lat));
+	if (reset)
+		memset(syscall_lat, 0, sizeof(syscall_lat));
+	*len = sz;
+
+	return TEE_SUCCESS;
+}
+
+#ifdef ARM64
+/*
+ * The program counter is sampled with the secure physical timer, which is
+ * banked per CPU. It's armed on each CPU as it enters secure world while
+ * sampling is started and disarmed on the next expiry once stopped.
+ *
+ * Samples are binned into 1 << PC_BUCKET_SHIFT bytes wide buckets of the
+ * whole TEE core virtual memory range. Like the syscall latencies they're
+ * updated without locking.
+ */
+#define PC_BUCKET_SHIFT		4
+#define PC_START_VA		TEE_RAM_VA_START
+#define PC_NUM_BUCKETS		(TEE_RAM_VA_SIZE >> PC_BUCKET_SHIFT)
+
+static struct mutex pc_mu = MUTEX_INITIALIZER;
+static tee_mm_entry_t *pc_mm;
+static uint32_t *pc_buckets;
+static struct core_prof_pc_hdr pc_hdr;
+static uint32_t pc_period_ticks;
+static bool pc_active;
+static bool pc_armed[CFG_TEE_CORE_NB_CORE];
+
+static bool spsr_is_user(uint64_t spsr)
+{
+	if (((spsr >> SPSR_MODE_RW_SHIFT) & SPSR_MODE_RW_MASK) ==
+	    SPSR_MODE_RW_32)
+		return true;
+	return !((spsr >> SPSR_64_MODE_EL_SHIFT) & SPSR_64_MODE_EL_MASK);
+}
+
+static enum itr_return pc_itr_cb(struct itr_handler *h __unused)
+{
+	struct thread_core_local *l = thread_get_core_local();
+	uint64_t spsr = 0;
+	vaddr_t pc = 0;
+
+	write_cntps_ctl(0);
+	if (!pc_active) {
+		pc_armed[get_core_pos()] = false;
+		return ITRR_HANDLED;
+	}
+
+	/*
+	 * The flags tell whether the interrupt was taken in secure world
+	 * or delivered by the secure monitor while in normal world.
+	 */
+	if (!(l->flags & (THREAD_CLF_IRQ | THREAD_CLF_FIQ))) {
+		pc_hdr.ns_samples++;
+	} else {
+		/* Not clobbered until the exception returns */
+		spsr = read_spsr_el1();
+		pc = read_elr_el1();
+
+		if (spsr_is_user(spsr))
+			pc_hdr.user_samples++;
+		else if (pc >= PC_START_VA &&
+			 pc < PC_START_VA + TEE_RAM_VA_SIZE)
+			pc_buckets[(pc - PC_START_VA) >> PC_BUCKET_SHIFT]++;
+		else
+			pc_hdr.other_samples++;
+	}
+
+	write_cntps_tval(pc_period_ticks);
+	write_cntps_ctl(1);
+
+	return ITRR_HANDLED;
+}
+
+static struct itr_handler pc_itr = {
+	.it = CFG_CORE_PROF_TIMER_IT,
+	.flags = ITRF_TRIGGER_LEVEL,
+	.handler = pc_itr_cb,
+};
+KEEP_PAGER(pc_itr);
+
+void core_prof_pc_arm_cpu(void)
+{
+	uint32_t exceptions = 0;
+	size_t pos = 0;
+
+	if (!pc_active)
+		return;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	pos = get_core_pos();
+	if (!pc_armed[pos]) {
+		pc_armed[pos] = true;
+		/* The timer interrupt is private to each CPU */
+		itr_enable(pc_itr.it);
+		write_cntps_tval(pc_period_ticks);
+		write_cntps_ctl(1);
+	}
+	thread_unmask_exceptions(exceptions);
+}
+
+TEE_Result core_prof_pc_start(uint32_t period_us)
+{
+	uint64_t ticks = ((uint64_t)read_cntfrq() * period_us) / 1000000;
+	size_t sz = PC_NUM_BUCKETS * sizeof(*pc_buckets);
+
+	if (!ticks || ticks > UINT32_MAX)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&pc_mu);
+
+	/* Kept once allocated, the handler may still run on another CPU */
+	if (!pc_mm) {
+		pc_mm = tee_mm_alloc(&tee_mm_sec_ddr, sz);
+		if (!pc_mm) {
+			mutex_unlock(&pc_mu);
+			return TEE_ERROR_OUT_OF_MEMORY;
+		}
+		pc_buckets = phys_to_virt(tee_mm_get_smem(pc_mm),
+					  MEM_AREA_TA_RAM);
+		itr_add(&pc_itr);
+	}
+
+	memset(pc_buckets, 0, sz);
+	pc_hdr = (struct core_prof_pc_hdr){
+		.start_va = PC_START_VA,
+		.bucket_shift = PC_BUCKET_SHIFT,
+		.num_buckets = PC_NUM_BUCKETS,
+	};
+	pc_period_ticks = ticks;
+	pc_active = true;
+
+	mutex_unlock(&pc_mu);
+
+	core_prof_pc_arm_cpu();
+
+	return TEE_SUCCESS;
+}
+
+void core_prof_pc_stop(void)
+{
+	pc_active = false;
+}
+
+TEE_Result core_prof_pc_get(void *buf, size_t *len)
+{
+	size_t sz = sizeof(pc_hdr) + PC_NUM_BUCKETS * sizeof(*pc_buckets);
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&pc_mu);
+
+	if (!pc_buckets) {
+		res = TEE_ERROR_BAD_STATE;
+		goto out;
+	}
+	if (*len < sz) {
+		*len = sz;
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
+	}
+
+	memcpy(buf, &pc_hdr, sizeof(pc_hdr));
+	memcpy((uint8_t *)buf + sizeof(pc_hdr), pc_buckets,
+	       sz - sizeof(pc_hdr));
+	*len = sz;
+out:
+	mutex_unlock(&pc_mu);
+	return res;
+}
+#else
+void core_prof_pc_arm_cpu(void)
+{
+}
+
+TEE_Result core_prof_pc_start(uint32_t period_us __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+void core_prof_pc_stop(void)
+{
+}
+
+TEE_Result core_prof_pc_get(void *buf __unused, size_t *len __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
@@ -3,21 +3,118 @@
  * Copyright (c) 2015-2017, Linaro Limited
  */
 
+#include <io.h>
+#include <kernel/delay.h>
+#include <kernel/lock_stat.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <trace.h>
+#include <util.h>
 
 #include "mutex_lockdep.h"
+#include "thread_private.h"
+
+/*
+ * State of a contended acquisition
+ * @start:	Counter value when the wait started, 0 if not contended
+ * @spin_until:	Counter value when to stop spinning and sleep instead
+ * @slept:	True if the wait has involved sleeping in normal world
+ */
+struct mutex_wait {
+	uint64_t start;
+	uint64_t spin_until;
+	bool slept;
+};
+
+static unsigned int wait_stats_lock = SPINLOCK_UNLOCK;
+static struct mutex_wait_stats wait_stats;
 
 void mutex_init(struct mutex *m)
 {
 	*m = (struct mutex)MUTEX_INITIALIZER;
 }
 
+static void wait_begin(struct mutex_wait *w)
+{
+	if (!w->start) {
+		w->start = read_cntpct();
+		w->spin_until = w->start +
+				arm_cnt_us2cnt(CFG_CORE_MUTEX_SPIN_US);
+	}
+}
+
+static bool owner_is_running(struct mutex *m)
+{
+	short owner = READ_ONCE(m->owner);
+
+	/* Only a hint, the owner may change as soon as it's been read */
+	return owner >= 0 && owner < CFG_NUM_THREADS &&
+	       READ_ONCE(threads[owner].state) == THREAD_STATE_ACTIVE;
+}
+
+/*
+ * Returns true if it's worth spinning on @m instead of sleeping, that is
+ * while the thread holding the write lock is running on another CPU and
+ * CFG_CORE_MUTEX_SPIN_US hasn't elapsed. Since a thread holding a read
+ * lock isn't known readers are always waited for in normal world.
+ *
+ * Called with m->spin_lock held.
+ */
+static bool may_spin(struct mutex *m, struct mutex_wait *w)
+{
+	if (!CFG_CORE_MUTEX_SPIN_US || m->state != -1)
+		return false;
+
+	return owner_is_running(m) && !timeout_elapsed(w->spin_until);
+}
+
+static void spin_on_owner(struct mutex *m, struct mutex_wait *w)
+{
+	while (READ_ONCE(m->state) == -1 && owner_is_running(m) &&
+	       !timeout_elapsed(w->spin_until))
+		;
+}
+
+static void wait_done(struct mutex *m, struct mutex_wait *w,
+		      const char *fname, int lineno, bool write)
+{
+	uint32_t exceptions = 0;
+	uint64_t us = 0;
+	size_t b = 0;
+
+	lock_stat_mutex_acquired(m, fname, lineno, w->start, write);
+	if (!w->start)
+		return;
+
+	us = ((read_cntpct() - w->start) * 1000000) / read_cntfrq();
+	if (us)
+		b = MIN(64 - __builtin_clzll(us), MUTEX_WAIT_BUCKETS - 1);
+
+	exceptions = cpu_spin_lock_xsave(&wait_stats_lock);
+	if (w->slept)
+		wait_stats.slept++;
+	else
+		wait_stats.spun++;
+	wait_stats.buckets[b]++;
+	cpu_spin_unlock_xrestore(&wait_stats_lock, exceptions);
+}
+
+void mutex_get_wait_stats(struct mutex_wait_stats *stats, bool reset)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&wait_stats_lock);
+
+	*stats = wait_stats;
+	if (reset)
+		wait_stats = (struct mutex_wait_stats){ };
+	cpu_spin_unlock_xrestore(&wait_stats_lock, exceptions);
+}
+
 static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 {
+	struct mutex_wait w = { };
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != -1);
 	assert(thread_is_in_normal_mode());
@@ -27,12 +124,14 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 	while (true) {
 		uint32_t old_itr_status;
 		bool can_lock;
+		bool spin = false;
 		struct wait_queue_elem wqe;
 
 		/*
 		 * If the mutex is locked we need to initialize the wqe
 		 * before releasing the spinlock to guarantee that we don't
-		 * miss the wakeup from mutex_unlock().
+		 * miss the wakeup from mutex_unlock(), unless we're going
+		 * to spin until the owner releases it instead.
 		 *
 		 * If the mutex is unlocked we don't need to use the wqe at
 		 * all.
@@ -42,21 +141,39 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 
 		can_lock = !m->state;
 		if (!can_lock) {
-			wq_wait_init(&m->wq, &wqe, false /* wait_read */);
+			wait_begin(&w);
+			spin = may_spin(m, &w);
+			if (!spin)
+				wq_wait_init(&m->wq, &wqe,
+					     false /* wait_read */);
 		} else {
 			m->state = -1; /* write locked */
+			m->owner = thread_get_id();
 		}
 
 		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-		if (!can_lock) {
+		if (can_lock) {
+			wait_done(m, &w, fname, lineno, true /* write */);
+			return;
+		}
+
+		if (spin) {
+			/*
+			 * The owner is running on another CPU and will
+			 * likely release the lock before a sleep and
+			 * wakeup round trip to normal world would
+			 * complete.
+			 */
+			spin_on_owner(m, &w);
+		} else {
 			/*
 			 * Someone else is holding the lock, wait in normal
 			 * world for the lock to become available.
 			 */
+			w.slept = true;
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
-		} else
-			return;
+		}
 	}
 }
 
@@ -68,6 +185,7 @@ static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 	assert(thread_get_id_may_fail() != -1);
 
 	mutex_unlock_check(m);
+	lock_stat_mutex_released(m);
 
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
@@ -81,8 +199,7 @@ static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 	wq_wake_next(&m->wq, m, fname, lineno);
 }
 
-static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
-			int lineno __unused)
+static bool __mutex_trylock(struct mutex *m, const char *fname, int lineno)
 {
 	uint32_t old_itr_status;
 	bool can_lock_write;
@@ -93,13 +210,17 @@ static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 	can_lock_write = !m->state;
-	if (can_lock_write)
+	if (can_lock_write) {
 		m->state = -1;
+		m->owner = thread_get_id();
+	}
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-	if (can_lock_write)
+	if (can_lock_write) {
 		mutex_trylock_check(m);
+		lock_stat_mutex_acquired(m, fname, lineno, 0, true /* write */);
+	}
 
 	return can_lock_write;
 }
@@ -128,6 +249,8 @@ static void __mutex_read_unlock(struct mutex *m, const char *fname, int lineno)
 
 static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 {
+	struct mutex_wait w = { };
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != -1);
 	assert(thread_is_in_normal_mode());
@@ -135,12 +258,14 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 	while (true) {
 		uint32_t old_itr_status;
 		bool can_lock;
+		bool spin = false;
 		struct wait_queue_elem wqe;
 
 		/*
 		 * If the mutex is locked we need to initialize the wqe
 		 * before releasing the spinlock to guarantee that we don't
-		 * miss the wakeup from mutex_unlock().
+		 * miss the wakeup from mutex_unlock(), unless we're going
+		 * to spin until the owner releases it instead.
 		 *
 		 * If the mutex is unlocked we don't need to use the wqe at
 		 * all.
@@ -150,26 +275,37 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 
 		can_lock = m->state != -1;
 		if (!can_lock) {
-			wq_wait_init(&m->wq, &wqe, true /* wait_read */);
+			wait_begin(&w);
+			spin = may_spin(m, &w);
+			if (!spin)
+				wq_wait_init(&m->wq, &wqe,
+					     true /* wait_read */);
 		} else {
 			m->state++; /* read_locked */
 		}
 
 		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-		if (!can_lock) {
+		if (can_lock) {
+			wait_done(m, &w, fname, lineno, false /* write */);
+			return;
+		}
+
+		if (spin) {
+			spin_on_owner(m, &w);
+		} else {
 			/*
 			 * Someone else is holding the lock, wait in normal
 			 * world for the lock to become available.
 			 */
+			w.slept = true;
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
-		} else
-			return;
+		}
 	}
 }
 
-static bool __mutex_read_trylock(struct mutex *m, const char *fname __unused,
-				 int lineno __unused)
+static bool __mutex_read_trylock(struct mutex *m, const char *fname,
+				 int lineno)
 {
 	uint32_t old_itr_status;
 	bool can_lock;
@@ -186,6 +322,10 @@ static bool __mutex_read_trylock(struct mutex *m, const char *fname __unused,
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
+	if (can_lock)
+		lock_stat_mutex_acquired(m, fname, lineno, 0,
+					 false /* write */);
+
 	return can_lock;
 }
 
@@ -324,6 +464,7 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 	short new_state;
 
 	mutex_unlock_check(m);
+	lock_stat_mutex_released(m);
 
 	/* Link this condvar to this mutex until reinitialized */
 	old_itr_status = cpu_spin_lock_xsave(&cv->spin_lock);
@@ -359,9 +500,9 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 	wq_wait_final(&m->wq, &wqe, m, fname, lineno);
 
 	if (old_state > 0)
-		mutex_read_lock(m);
+		__mutex_read_lock(m, fname, lineno);
 	else
-		mutex_lock(m);
+		__mutex_lock(m, fname, lineno);
 }
 
 #ifdef CFG_MUTEX_DEBUG
@@ -302,6 +302,8 @@ TEE_Result tee_ta_init_pseudo_ta_session(const TEE_UUID *uuid,
 	stc->pseudo_ta = ta;
 	ctx->uuid = ta->uuid;
 	ctx->ops = &pseudo_ta_ops;
+	mutex_init(&ctx->busy_mu);
+	condvar_init(&ctx->busy_cv);
 	TAILQ_INSERT_TAIL(&tee_ctxes, ctx, link);
 
 	DMSG("%s : %pUl", stc->pseudo_ta->name, (void *)&ctx->uuid);
@@ -8,6 +8,7 @@
 #include <kernel/thread.h>
 #include <kernel/user_ta_store.h>
 #include <mm/core_memprot.h>
+#include <mm/file.h>
 #include <mm/tee_mm.h>
 #include <mm/mobj.h>
 #include <optee_rpc_cmd.h>
@@ -17,10 +18,14 @@
 #include <tee_api_types.h>
 #include <tee/uuid.h>
 #include <utee_defines.h>
+#include <util.h>
 
 struct ree_fs_ta_handle {
-	struct shdr *nw_ta; /* Non-secure (shared memory) */
+	TEE_UUID uuid;
+	uint8_t *nw_ta; /* Non-secure (shared memory) */
 	size_t nw_ta_size;
+	size_t chunk_offs; /* Offset in the TA binary of @nw_ta */
+	size_t chunk_len; /* Number of bytes of the TA binary in @nw_ta */
 	struct mobj *mobj;
 	size_t offs;
 	struct shdr *shdr; /* Verified secure copy of @nw_ta's signed header */
@@ -29,51 +34,105 @@ struct ree_fs_ta_handle {
 };
 
 /*
- * Load a TA via RPC with UUID defined by input param @uuid. The virtual
- * address of the raw TA binary is received in out parameter @ta.
+ * Load the chunk of the TA binary starting at @offs into the payload
+ * buffer of @h via RPC.
  */
-static TEE_Result rpc_load(const TEE_UUID *uuid, struct shdr **ta,
-			   size_t *ta_size, struct mobj **mobj)
+static TEE_Result rpc_load_chunk(struct ree_fs_ta_handle *h, size_t offs)
 {
-	TEE_Result res;
-	struct thread_param params[2];
+	size_t len = MIN(h->mobj->size, h->nw_ta_size - offs);
+	struct thread_param params[3] = { };
+	TEE_Result res = TEE_SUCCESS;
 
-	if (!uuid || !ta || !mobj || !ta_size)
-		return TEE_ERROR_BAD_PARAMETERS;
+	params[0].attr = THREAD_PARAM_ATTR_VALUE_IN;
+	tee_uuid_to_octets((void *)&params[0].u.value, &h->uuid);
+	params[1] = THREAD_PARAM_MEMREF(OUT, h->mobj, 0, len);
+	params[2] = THREAD_PARAM_VALUE(IN, offs, 0, 0);
+
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_LOAD_TA, 3, params);
+	if (res)
+		return res;
+	if (params[1].u.memref.size != len)
+		return TEE_ERROR_SECURITY;
+
+	h->chunk_offs = offs;
+	h->chunk_len = len;
+	return TEE_SUCCESS;
+}
+
+/*
+ * Load a TA via RPC with UUID @h->uuid. On success @h->nw_ta holds the
+ * first @h->chunk_len bytes of the raw TA binary.
+ *
+ * If the TA binary is larger than CFG_REE_FS_TA_CHUNK_SIZE only a
+ * payload buffer of that size is allocated and the binary is streamed
+ * through it, one chunk at a time, as it is read. If tee-supplicant
+ * doesn't support loading a chunk at an offset the whole binary is
+ * loaded at once instead.
+ */
+static TEE_Result rpc_load(struct ree_fs_ta_handle *h)
+{
+	struct thread_param params[2] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t ta_size = 0;
 
-	memset(params, 0, sizeof(params));
 	params[0].attr = THREAD_PARAM_ATTR_VALUE_IN;
-	tee_uuid_to_octets((void *)&params[0].u.value, uuid);
+	tee_uuid_to_octets((void *)&params[0].u.value, &h->uuid);
 	params[1].attr = THREAD_PARAM_ATTR_MEMREF_OUT;
 
 	res = thread_rpc_cmd(OPTEE_RPC_CMD_LOAD_TA, 2, params);
 	if (res != TEE_SUCCESS)
 		return res;
+	ta_size = params[1].u.memref.size;
+	h->nw_ta_size = ta_size;
+
+	if (CFG_REE_FS_TA_CHUNK_SIZE && ta_size > CFG_REE_FS_TA_CHUNK_SIZE) {
+		h->mobj = thread_rpc_alloc_payload(CFG_REE_FS_TA_CHUNK_SIZE);
+		if (!h->mobj)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		h->nw_ta = mobj_get_va(h->mobj, 0);
+		/*
+		 * We don't expect NULL as thread_rpc_alloc_payload() was
+		 * successful
+		 */
+		assert(h->nw_ta);
+
+		res = rpc_load_chunk(h, 0);
+		if (res != TEE_ERROR_BAD_PARAMETERS &&
+		    res != TEE_ERROR_NOT_SUPPORTED)
+			goto exit;
 
-	*mobj = thread_rpc_alloc_payload(params[1].u.memref.size);
-	if (!*mobj)
+		DMSG("Chunked load not supported, loading whole TA");
+		thread_rpc_free_payload(h->mobj);
+	}
+
+	h->mobj = thread_rpc_alloc_payload(ta_size);
+	if (!h->mobj)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
-	if ((*mobj)->size < params[1].u.memref.size) {
+	if (h->mobj->size < ta_size) {
 		res = TEE_ERROR_SHORT_BUFFER;
 		goto exit;
 	}
 
-	*ta = mobj_get_va(*mobj, 0);
+	h->nw_ta = mobj_get_va(h->mobj, 0);
 	/* We don't expect NULL as thread_rpc_alloc_payload() was successful */
-	assert(*ta);
-	*ta_size = params[1].u.memref.size;
+	assert(h->nw_ta);
 
 	params[0].attr = THREAD_PARAM_ATTR_VALUE_IN;
-	tee_uuid_to_octets((void *)&params[0].u.value, uuid);
+	tee_uuid_to_octets((void *)&params[0].u.value, &h->uuid);
 	params[1].attr = THREAD_PARAM_ATTR_MEMREF_OUT;
 	params[1].u.memref.offs = 0;
-	params[1].u.memref.mobj = *mobj;
+	params[1].u.memref.size = ta_size;
+	params[1].u.memref.mobj = h->mobj;
 
 	res = thread_rpc_cmd(OPTEE_RPC_CMD_LOAD_TA, 2, params);
+	h->chunk_offs = 0;
+	h->chunk_len = ta_size;
 exit:
-	if (res != TEE_SUCCESS)
-		thread_rpc_free_payload(*mobj);
+	if (res != TEE_SUCCESS) {
+		thread_rpc_free_payload(h->mobj);
+		h->mobj = NULL;
+	}
 
 	return res;
 }
@@ -83,10 +142,9 @@ static TEE_Result ree_fs_ta_open(const TEE_UUID *uuid,
 {
 	struct ree_fs_ta_handle *handle;
 	struct shdr *shdr = NULL;
-	struct mobj *mobj = NULL;
 	void *hash_ctx = NULL;
 	uint32_t hash_algo = 0;
-	struct shdr *ta = NULL;
+	uint8_t *ta = NULL;
 	size_t ta_size = 0;
 	TEE_Result res;
 	size_t offs;
@@ -94,14 +152,17 @@ static TEE_Result ree_fs_ta_open(const TEE_UUID *uuid,
 	handle = calloc(1, sizeof(*handle));
 	if (!handle)
 		return TEE_ERROR_OUT_OF_MEMORY;
+	handle->uuid = *uuid;
 
 	/* Request TA from tee-supplicant */
-	res = rpc_load(uuid, &ta, &ta_size, &mobj);
+	res = rpc_load(handle);
 	if (res != TEE_SUCCESS)
 		goto error;
+	ta = handle->nw_ta;
+	ta_size = handle->nw_ta_size;
 
 	/* Make secure copy of signed header */
-	shdr = shdr_alloc_and_copy(ta, ta_size);
+	shdr = shdr_alloc_and_copy((struct shdr *)ta, handle->chunk_len);
 	if (!shdr) {
 		res = TEE_ERROR_SECURITY;
 		goto error_free_payload;
@@ -137,12 +198,12 @@ static TEE_Result ree_fs_ta_open(const TEE_UUID *uuid,
 		TEE_UUID bs_uuid;
 		struct shdr_bootstrap_ta bs_hdr;
 
-		if (ta_size < SHDR_GET_SIZE(shdr) + sizeof(bs_hdr)) {
+		if (handle->chunk_len < SHDR_GET_SIZE(shdr) + sizeof(bs_hdr)) {
 			res = TEE_ERROR_SECURITY;
 			goto error_free_hash;
 		}
 
-		memcpy(&bs_hdr, ((uint8_t *)ta + offs), sizeof(bs_hdr));
+		memcpy(&bs_hdr, ta + offs, sizeof(bs_hdr));
 
 		/*
 		 * There's a check later that the UUID embedded inside the
@@ -168,20 +229,17 @@ static TEE_Result ree_fs_ta_open(const TEE_UUID *uuid,
 		goto error_free_hash;
 	}
 
-	handle->nw_ta = ta;
-	handle->nw_ta_size = ta_size;
 	handle->offs = offs;
 	handle->hash_algo = hash_algo;
 	handle->hash_ctx = hash_ctx;
 	handle->shdr = shdr;
-	handle->mobj = mobj;
 	*h = (struct user_ta_store_handle *)handle;
 	return TEE_SUCCESS;
 
 error_free_hash:
 	crypto_hash_free_ctx(hash_ctx, hash_algo);
 error_free_payload:
-	thread_rpc_free_payload(mobj);
+	thread_rpc_free_payload(handle->mobj);
 error:
 	shdr_free(shdr);
 	free(handle);
@@ -238,21 +296,42 @@ static TEE_Result ree_fs_ta_read(struct user_ta_store_handle *h, void *data,
 				 size_t len)
 {
 	struct ree_fs_ta_handle *handle = (struct ree_fs_ta_handle *)h;
-
-	uint8_t *src = (uint8_t *)handle->nw_ta + handle->offs;
-	uint8_t *dst = src;
-	TEE_Result res;
+	size_t chunk_end = 0;
+	uint8_t *src = NULL;
+	uint8_t *dst = data;
+	TEE_Result res = TEE_SUCCESS;
+	size_t l = 0;
 
 	if (handle->offs + len > handle->nw_ta_size)
 		return TEE_ERROR_BAD_PARAMETERS;
-	if (data) {
-		dst = data; /* Hash secure buffer (shm might be modified) */
-		memcpy(dst, src, len);
+
+	while (len) {
+		chunk_end = handle->chunk_offs + handle->chunk_len;
+		if (handle->offs >= chunk_end) {
+			res = rpc_load_chunk(handle, handle->offs);
+			if (res)
+				return res;
+			chunk_end = handle->chunk_offs + handle->chunk_len;
+		}
+
+		src = handle->nw_ta + handle->offs - handle->chunk_offs;
+		l = MIN(len, chunk_end - handle->offs);
+		if (dst) {
+			/* Hash secure buffer (shm might be modified) */
+			res = crypto_hash_copy_update(handle->hash_ctx,
+						      handle->hash_algo, dst,
+						      src, l);
+			dst += l;
+		} else {
+			res = crypto_hash_update(handle->hash_ctx,
+						 handle->hash_algo, src, l);
+		}
+		if (res != TEE_SUCCESS)
+			return TEE_ERROR_SECURITY;
+		handle->offs += l;
+		len -= l;
 	}
-	res = crypto_hash_update(handle->hash_ctx, handle->hash_algo, dst, len);
-	if (res != TEE_SUCCESS)
-		return TEE_ERROR_SECURITY;
-	handle->offs += len;
+
 	if (handle->offs == handle->nw_ta_size) {
 		/*
 		 * Last read: time to check if our digest matches the expected
@@ -275,6 +354,34 @@ static void ree_fs_ta_close(struct user_ta_store_handle *h)
 	free(handle);
 }
 
+static TEE_Result ree_fs_ta_prefetch(const TEE_UUID *uuids, size_t num_uuids)
+{
+	struct thread_param params = { };
+	TEE_Result res = TEE_SUCCESS;
+	struct mobj *mobj = NULL;
+	uint8_t *buf = NULL;
+	size_t sz = 0;
+	size_t n = 0;
+
+	if (MUL_OVERFLOW(num_uuids, sizeof(TEE_UUID), &sz) || !sz)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mobj = thread_rpc_alloc_payload(sz);
+	if (!mobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	buf = mobj_get_va(mobj, 0);
+	/* We don't expect NULL as thread_rpc_alloc_payload() was successful */
+	assert(buf);
+
+	for (n = 0; n < num_uuids; n++)
+		tee_uuid_to_octets(buf + n * sizeof(TEE_UUID), uuids + n);
+
+	params = THREAD_PARAM_MEMREF(IN, mobj, 0, sz);
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_PREFETCH_TA, 1, &params);
+	thread_rpc_free_payload(mobj);
+	return res;
+}
+
 #ifndef CFG_REE_FS_TA_BUFFERED
 TEE_TA_REGISTER_TA_STORE(9) = {
 	.description = "REE",
@@ -283,6 +390,7 @@ TEE_TA_REGISTER_TA_STORE(9) = {
 	.get_tag = ree_fs_ta_get_tag,
 	.read = ree_fs_ta_read,
 	.close = ree_fs_ta_close,
+	.prefetch = ree_fs_ta_prefetch,
 };
 #endif
 
@@ -336,6 +444,8 @@ static TEE_Result buf_ta_open(const TEE_UUID *uuid,
 		goto err;
 
 	handle->mm = tee_mm_alloc(&tee_mm_sec_ddr, handle->ta_size);
+	while (!handle->mm && file_cache_evict())
+		handle->mm = tee_mm_alloc(&tee_mm_sec_ddr, handle->ta_size);
 	if (!handle->mm) {
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto err;
@@ -416,6 +526,7 @@ TEE_TA_REGISTER_TA_STORE(9) = {
 	.get_tag = buf_ta_get_tag,
 	.read = buf_ta_read,
 	.close = buf_ta_close,
+	.prefetch = ree_fs_ta_prefetch,
 };
 
 #endif /* CFG_REE_FS_TA_BUFFERED */
@@ -40,6 +40,8 @@ srcs-$(CFG_ARM64_core) += misc_a64.S
 srcs-y += mutex.c
 srcs-$(CFG_LOCKDEP) += mutex_lockdep.c
 srcs-y += wait_queue.c
+srcs-$(CFG_CORE_TRACE_RING) += trace_ring.c
+srcs-$(CFG_CORE_PROF) += core_prof.c
 srcs-$(CFG_PM_STUBS) += pm_stubs.c
 cflags-pm_stubs.c-y += -Wno-suggest-attribute=noreturn
 
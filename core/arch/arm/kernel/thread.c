@@ -19,6 +19,7 @@
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread_defs.h>
 #include <kernel/thread.h>
+#include <kernel/trace_ring.h>
 #include <kernel/virtualization.h>
 #include <mm/core_memprot.h>
 #include <mm/mobj.h>
@@ -1075,6 +1076,15 @@ void thread_init_per_cpu(void)
 	set_abt_stack(l, GET_STACK(stack_abt[pos]));
 
 	thread_init_vbar(get_excp_vect());
+
+#ifdef CFG_TA_FTRACE_SUPPORT
+	/*
+	 * Let instrumented TAs timestamp function entries and exits. On
+	 * ARM32 the secure monitor switches CNTKCTL along with the world,
+	 * on ARM64 it's done by TF-A.
+	 */
+	write_cntkctl(read_cntkctl() | CNTKCTL_PL0PCTEN);
+#endif
 }
 
 struct thread_specific_data *thread_get_tsd(void)
@@ -1594,7 +1604,9 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 		return ret;
 
 	reg_pair_from_64(carg, rpc_args + 1, rpc_args + 2);
+	trace_ring_emit(TRACE_RING_RPC_BEGIN, cmd);
 	thread_rpc(rpc_args);
+	trace_ring_emit(TRACE_RING_RPC_END, cmd);
 
 	return get_rpc_arg_res(arg, num_params, params);
 }
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2019, agent
+ */
+
+#include <arm.h>
+#include <kernel/misc.h>
+#include <kernel/thread.h>
+#include <kernel/trace_ring.h>
+#include <string.h>
+#include <util.h>
+
+#define NUM_EVENTS	CFG_CORE_TRACE_RING_EVENTS
+
+struct cpu_ring {
+	struct trace_ring_cpu cpu;
+	struct trace_ring_event events[NUM_EVENTS];
+};
+
+static struct cpu_ring rings[CFG_TEE_CORE_NB_CORE];
+
+bool trace_ring_active;
+
+void __trace_ring_emit(uint16_t id, uint32_t arg)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	struct cpu_ring *r = rings + get_core_pos();
+	struct trace_ring_event *ev = r->events +
+				      (r->cpu.head & (NUM_EVENTS - 1));
+	int thread = thread_get_core_local()->curr_thread;
+
+	ev->ts = read_cntpct();
+	ev->id = id;
+	ev->thread = thread < 0 ? TRACE_RING_NO_THREAD : thread;
+	ev->arg = arg;
+	r->cpu.head++;
+
+	thread_unmask_exceptions(exceptions);
+}
+
+void trace_ring_start(void)
+{
+	COMPILE_TIME_ASSERT(IS_POWER_OF_TWO(NUM_EVENTS));
+
+	trace_ring_active = true;
+}
+
+void trace_ring_stop(void)
+{
+	trace_ring_active = false;
+}
+
+TEE_Result trace_ring_dump(void *buf, size_t *len)
+{
+	struct trace_ring_hdr hdr = {
+		.magic = TRACE_RING_MAGIC,
+		.version = TRACE_RING_VERSION,
+		.num_cpus = CFG_TEE_CORE_NB_CORE,
+		.num_events = NUM_EVENTS,
+		.freq = read_cntfrq(),
+	};
+	uint8_t *b = buf;
+	size_t n = 0;
+
+	if (*len < sizeof(hdr) + sizeof(rings)) {
+		*len = sizeof(hdr) + sizeof(rings);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	memcpy(b, &hdr, sizeof(hdr));
+	b += sizeof(hdr);
+	for (n = 0; n < ARRAY_SIZE(rings); n++) {
+		memcpy(b, rings + n, sizeof(rings[n]));
+		b += sizeof(rings[n]);
+	}
+	*len = sizeof(hdr) + sizeof(rings);
+
+	return TEE_SUCCESS;
+}
@@ -5,12 +5,14 @@
  */
 
 #include <assert.h>
+#include <atomic.h>
 #include <compiler.h>
 #include <crypto/crypto.h>
 #include <ctype.h>
 #include <elf_common.h>
 #include <initcall.h>
 #include <keep.h>
+#include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/tee_misc.h>
 #include <kernel/tee_ta_manager.h>
@@ -141,10 +143,261 @@ static void update_from_utee_param(struct tee_ta_param *p,
 static void clear_vfp_state(struct user_ta_ctx *utc __unused)
 {
 #ifdef CFG_WITH_VFP
-	thread_user_clear_vfp(&utc->vfp);
+	thread_user_clear_vfp(user_ta_get_vfp(utc));
 #endif
 }
 
+#ifdef CFG_TA_CONCURRENT
+/*
+ * A TA with TA_FLAG_CONCURRENT may be entered by several threads at the
+ * same time, each with its own user stack and VFP state. utc->mu is held
+ * while entering and leaving the TA and by syscalls while they access the
+ * VM map, the segments or the lists of handles of the TA, but not while
+ * the TA executes in user mode.
+ */
+static bool is_concurrent(struct user_ta_ctx *utc)
+{
+	return utc->threads;
+}
+
+static void lock_utc(struct user_ta_ctx *utc)
+{
+	mutex_lock(&utc->mu);
+	atomic_store_int(&utc->mu_owner, thread_get_id());
+}
+
+static void unlock_utc(struct user_ta_ctx *utc)
+{
+	atomic_store_int(&utc->mu_owner, THREAD_ID_INVALID);
+	mutex_unlock(&utc->mu);
+}
+
+static bool holds_utc_lock(struct user_ta_ctx *utc)
+{
+	/* Only this thread can set the owner to its own ID */
+	return atomic_load_int(&utc->mu_owner) == thread_get_id();
+}
+
+bool user_ta_lock(struct user_ta_ctx *utc)
+{
+	if (!is_concurrent(utc) || holds_utc_lock(utc))
+		return false;
+
+	lock_utc(utc);
+	return true;
+}
+
+void user_ta_unlock(struct user_ta_ctx *utc)
+{
+	unlock_utc(utc);
+}
+
+TEE_Result user_ta_claim(struct user_ta_ctx *utc, struct user_ta_claim *c)
+{
+	struct user_ta_thread *thr = NULL;
+	int id = thread_get_id();
+
+	if (!is_concurrent(utc))
+		return TEE_SUCCESS;
+
+	assert(holds_utc_lock(utc));
+	/* A claim is stale once the syscall of its thread is done */
+	if (c->thread != id && c->seq &&
+	    c->seq == utc->threads[c->thread].syscall_seq)
+		return TEE_ERROR_BUSY;
+
+	thr = utc->threads + id;
+	c->thread = id;
+	c->seq = thr->syscall_seq;
+	thr->claimed = true;
+
+	return TEE_SUCCESS;
+}
+
+void user_ta_syscall_done(void)
+{
+	struct tee_ta_session *s = NULL;
+	struct user_ta_thread *thr = NULL;
+	struct user_ta_ctx *utc = NULL;
+
+	if (tee_ta_get_current_session(&s) || !is_user_ta_ctx(s->ctx))
+		return;
+
+	utc = to_user_ta_ctx(s->ctx);
+	if (!is_concurrent(utc))
+		return;
+
+	thr = utc->threads + thread_get_id();
+	if (!thr->claimed)
+		return;
+
+	lock_utc(utc);
+	thr->syscall_seq++;
+	if (!thr->syscall_seq)
+		thr->syscall_seq++;
+	thr->claimed = false;
+	unlock_utc(utc);
+}
+
+static TEE_Result init_concurrent(struct user_ta_ctx *utc)
+{
+	size_t n = 0;
+
+	/* Only useful if several sessions can be opened to the instance */
+	if (!(utc->ctx.flags & TA_FLAG_MULTI_SESSION)) {
+		utc->ctx.flags &= ~TA_FLAG_CONCURRENT;
+		return TEE_SUCCESS;
+	}
+
+	utc->threads = calloc(CFG_NUM_THREADS, sizeof(*utc->threads));
+	if (!utc->threads)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	for (n = 0; n < CFG_NUM_THREADS; n++)
+		utc->threads[n].syscall_seq = 1;
+	mutex_init(&utc->mu);
+	utc->mu_owner = THREAD_ID_INVALID;
+
+	return TEE_SUCCESS;
+}
+
+/* Allocates a stack sized like the one allocated by ldelf */
+static TEE_Result alloc_thread_stack(struct user_ta_ctx *utc, vaddr_t *sp)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct vm_region *r = NULL;
+	struct fobj *fobj = NULL;
+	vaddr_t va = 0;
+
+	TAILQ_FOREACH(r, &utc->vm_info->regions, link)
+		if (utc->stack_ptr > r->va &&
+		    utc->stack_ptr - r->va <= r->size)
+			break;
+	if (!r)
+		return TEE_ERROR_GENERIC;
+
+	fobj = fobj_ta_mem_alloc(r->size / SMALL_PAGE_SIZE);
+	if (!fobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	/* Keep an unmapped page below to catch stack overflows */
+	res = user_ta_map(utc, &va, fobj, TEE_MATTR_URW | TEE_MATTR_PRW,
+			  NULL, SMALL_PAGE_SIZE, 0);
+	fobj_put(fobj);
+	if (res)
+		return res;
+
+	*sp = va + (utc->stack_ptr - r->va);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_thread_stack(struct user_ta_ctx *utc, vaddr_t *sp)
+{
+	struct user_ta_thread *thr = utc->threads + thread_get_id();
+	size_t n = 0;
+
+	if (!thr->stack_ptr) {
+		/* The stack allocated by ldelf goes to the first thread */
+		for (n = 0; n < CFG_NUM_THREADS; n++)
+			if (utc->threads[n].stack_ptr == utc->stack_ptr)
+				break;
+		if (n == CFG_NUM_THREADS) {
+			thr->stack_ptr = utc->stack_ptr;
+		} else {
+			TEE_Result res = alloc_thread_stack(utc,
+							    &thr->stack_ptr);
+
+			if (res)
+				return res;
+		}
+	}
+
+	*sp = thr->stack_ptr;
+	return TEE_SUCCESS;
+}
+
+static TEE_Result begin_entry(struct user_ta_ctx *utc, vaddr_t *sp)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!is_concurrent(utc)) {
+		*sp = utc->stack_ptr;
+		return TEE_SUCCESS;
+	}
+
+	/* Called again from a syscall of this TA, can't wait for ourselves */
+	if (holds_utc_lock(utc))
+		return TEE_ERROR_BUSY;
+
+	lock_utc(utc);
+	res = get_thread_stack(utc, sp);
+	if (res)
+		unlock_utc(utc);
+	else
+		utc->num_threads++;
+
+	return res;
+}
+
+static void suspend_entry(struct user_ta_ctx *utc)
+{
+	if (is_concurrent(utc))
+		unlock_utc(utc);
+}
+
+static void resume_entry(struct user_ta_ctx *utc)
+{
+	if (is_concurrent(utc))
+		lock_utc(utc);
+}
+
+static void end_entry(struct user_ta_ctx *utc)
+{
+	if (is_concurrent(utc)) {
+		utc->num_threads--;
+		unlock_utc(utc);
+	}
+}
+
+/*
+ * Other threads may have the mappings of a concurrent TA in their page
+ * tables, they can only be removed or changed by the only thread
+ * executing the TA.
+ */
+static bool can_change_mapping(struct user_ta_ctx *utc)
+{
+	return !is_concurrent(utc) || utc->num_threads <= 1;
+}
+#else
+static TEE_Result init_concurrent(struct user_ta_ctx *utc)
+{
+	utc->ctx.flags &= ~TA_FLAG_CONCURRENT;
+	return TEE_SUCCESS;
+}
+
+static TEE_Result begin_entry(struct user_ta_ctx *utc, vaddr_t *sp)
+{
+	*sp = utc->stack_ptr;
+	return TEE_SUCCESS;
+}
+
+static void suspend_entry(struct user_ta_ctx *utc __unused)
+{
+}
+
+static void resume_entry(struct user_ta_ctx *utc __unused)
+{
+}
+
+static void end_entry(struct user_ta_ctx *utc __unused)
+{
+}
+
+static bool can_change_mapping(struct user_ta_ctx *utc __unused)
+{
+	return true;
+}
+#endif /*CFG_TA_CONCURRENT*/
+
 static TEE_Result user_ta_enter(TEE_ErrorOrigin *err,
 			struct tee_ta_session *session,
 			enum utee_entry_func func, uint32_t cmd,
@@ -158,24 +411,29 @@ static TEE_Result user_ta_enter(TEE_ErrorOrigin *err,
 	struct tee_ta_session *s __maybe_unused = NULL;
 	void *param_va[TEE_NUM_PARAMS] = { NULL };
 
+	res = begin_entry(utc, &usr_stack);
+	if (res != TEE_SUCCESS)
+		goto cleanup_return;
+
 	/* Map user space memory */
 	res = tee_mmu_map_param(utc, param, param_va);
 	if (res != TEE_SUCCESS)
-		goto cleanup_return;
+		goto cleanup_end_entry;
 
 	/* Switch to user ctx */
 	tee_ta_push_current_session(session);
 
 	/* Make room for usr_params at top of stack */
-	usr_stack = utc->stack_ptr;
 	usr_stack -= ROUNDUP(sizeof(struct utee_params), STACK_ALIGNMENT);
 	usr_params = (struct utee_params *)usr_stack;
 	init_utee_param(usr_params, param, param_va);
 
+	suspend_entry(utc);
 	res = thread_enter_user_mode(func, tee_svc_kaddr_to_uref(session),
 				     (vaddr_t)usr_params, cmd, usr_stack,
 				     utc->entry_func, utc->is_32bit,
 				     &utc->ctx.panicked, &utc->ctx.panic_code);
+	resume_entry(utc);
 
 	clear_vfp_state(utc);
 	/*
@@ -203,6 +461,8 @@ static TEE_Result user_ta_enter(TEE_ErrorOrigin *err,
 
 	s = tee_ta_pop_current_session();
 	assert(s == session);
+cleanup_end_entry:
+	end_entry(utc);
 cleanup_return:
 
 	/*
@@ -304,6 +564,9 @@ static TEE_Result init_with_ldelf(struct tee_ta_session *sess,
 	utc->ftrace_entry_func = arg->ftrace_entry;
 #endif
 
+	if (utc->ctx.flags & TA_FLAG_CONCURRENT)
+		res = init_concurrent(utc);
+
 out:
 	s = tee_ta_pop_current_session();
 	assert(s == sess);
@@ -548,7 +811,7 @@ static TEE_Result dump_ftrace(struct user_ta_ctx *utc, void *buf, size_t *blen)
 	return res;
 }
 
-static void user_ta_dump_ftrace(struct tee_ta_ctx *ctx)
+static void dump_ftrace_rpc(struct tee_ta_ctx *ctx)
 {
 	uint32_t prot = TEE_MATTR_URW | TEE_MATTR_EPHEMERAL;
 	struct user_ta_ctx *utc = to_user_ta_ctx(ctx);
@@ -605,6 +868,17 @@ out_unmap_pl:
 out_free_pl:
 	thread_rpc_free_payload(mobj);
 }
+
+static void user_ta_dump_ftrace(struct tee_ta_ctx *ctx)
+{
+	struct user_ta_ctx *utc = to_user_ta_ctx(ctx);
+	/* The ldelf stack is shared by all threads */
+	bool locked = user_ta_lock(utc);
+
+	dump_ftrace_rpc(ctx);
+	if (locked)
+		user_ta_unlock(utc);
+}
 #endif /*CFG_TA_FTRACE_SUPPORT*/
 
 static void free_utc(struct user_ta_ctx *utc)
@@ -623,6 +897,12 @@ static void free_utc(struct user_ta_ctx *utc)
 
 	vm_info_final(utc);
 	free_segs(&utc->segs);
+#ifdef CFG_TA_CONCURRENT
+	if (utc->threads) {
+		mutex_destroy(&utc->mu);
+		free(utc->threads);
+	}
+#endif
 
 	/* Free cryp states created by this TA */
 	tee_svc_cryp_free_states(utc);
@@ -787,6 +1067,7 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 		goto err;
 
 	utc->ctx.ref_count = 1;
+	mutex_init(&utc->ctx.busy_mu);
 	condvar_init(&utc->ctx.busy_cv);
 	TAILQ_INSERT_TAIL(&tee_ctxes, &utc->ctx, link);
 
@@ -807,6 +1088,7 @@ TEE_Result user_ta_map(struct user_ta_ctx *utc, vaddr_t *va, struct fobj *f,
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	struct load_seg *seg = calloc(1, sizeof(*seg));
+	bool locked = false;
 
 	if (!seg)
 		return TEE_ERROR_OUT_OF_MEMORY;
@@ -826,7 +1108,10 @@ TEE_Result user_ta_map(struct user_ta_ctx *utc, vaddr_t *va, struct fobj *f,
 
 	seg->va = *va;
 	seg->file = file_get(file);
+	locked = user_ta_lock(utc);
 	SLIST_INSERT_HEAD(&utc->segs, seg, link);
+	if (locked)
+		user_ta_unlock(utc);
 
 	return TEE_SUCCESS;
 
@@ -849,13 +1134,34 @@ static struct load_seg *find_exact_seg(struct load_seg_head *segs, vaddr_t va,
 	return NULL;
 }
 
-TEE_Result user_ta_unmap(struct user_ta_ctx *utc, vaddr_t va, size_t len)
+struct file *user_ta_get_file(struct user_ta_ctx *utc, vaddr_t va)
+{
+	struct load_seg *seg = NULL;
+	struct file *f = NULL;
+	bool locked = user_ta_lock(utc);
+
+	SLIST_FOREACH(seg, &utc->segs, link) {
+		if (va >= seg->va && va - seg->va < seg->size) {
+			f = seg->file;
+			break;
+		}
+	}
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return f;
+}
+
+static TEE_Result unmap_seg(struct user_ta_ctx *utc, vaddr_t va, size_t len)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	struct load_seg *seg = find_exact_seg(&utc->segs, va, len);
 
 	if (!seg)
 		return TEE_ERROR_ITEM_NOT_FOUND;
+	if (!can_change_mapping(utc))
+		return TEE_ERROR_BUSY;
 
 	res = vm_unmap(utc, va, len);
 	if (res)
@@ -867,14 +1173,27 @@ TEE_Result user_ta_unmap(struct user_ta_ctx *utc, vaddr_t va, size_t len)
 	return TEE_SUCCESS;
 }
 
-TEE_Result user_ta_set_prot(struct user_ta_ctx *utc, vaddr_t va, size_t len,
-			    uint32_t prot)
+TEE_Result user_ta_unmap(struct user_ta_ctx *utc, vaddr_t va, size_t len)
+{
+	bool locked = user_ta_lock(utc);
+	TEE_Result res = unmap_seg(utc, va, len);
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
+}
+
+static TEE_Result set_seg_prot(struct user_ta_ctx *utc, vaddr_t va,
+			       size_t len, uint32_t prot)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	struct load_seg *seg = find_exact_seg(&utc->segs, va, len);
 
 	if (!seg)
 		return TEE_ERROR_ITEM_NOT_FOUND;
+	if (!can_change_mapping(utc))
+		return TEE_ERROR_BUSY;
 
 	/*
 	 * If the segment is a mapping of a part of a file (seg->file !=
@@ -894,9 +1213,21 @@ TEE_Result user_ta_set_prot(struct user_ta_ctx *utc, vaddr_t va, size_t len,
 	return TEE_SUCCESS;
 }
 
-TEE_Result user_ta_remap(struct user_ta_ctx *utc, vaddr_t *new_va,
-			 vaddr_t old_va, size_t len, size_t pad_begin,
-			 size_t pad_end)
+TEE_Result user_ta_set_prot(struct user_ta_ctx *utc, vaddr_t va, size_t len,
+			    uint32_t prot)
+{
+	bool locked = user_ta_lock(utc);
+	TEE_Result res = set_seg_prot(utc, va, len, prot);
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
+}
+
+static TEE_Result remap_seg(struct user_ta_ctx *utc, vaddr_t *new_va,
+			    vaddr_t old_va, size_t len, size_t pad_begin,
+			    size_t pad_end)
 {
 	TEE_Result r2 = TEE_SUCCESS;
 	TEE_Result res = TEE_ERROR_GENERIC;
@@ -905,6 +1236,8 @@ TEE_Result user_ta_remap(struct user_ta_ctx *utc, vaddr_t *new_va,
 
 	if (!seg)
 		return TEE_ERROR_ITEM_NOT_FOUND;
+	if (!can_change_mapping(utc))
+		return TEE_ERROR_BUSY;
 
 	res = vm_unmap(utc, seg->va, seg->size);
 	if (res)
@@ -926,3 +1259,17 @@ err:
 		panic("Cannot restore mapping");
 	return res;
 }
+
+TEE_Result user_ta_remap(struct user_ta_ctx *utc, vaddr_t *new_va,
+			 vaddr_t old_va, size_t len, size_t pad_begin,
+			 size_t pad_end)
+{
+	bool locked = user_ta_lock(utc);
+	TEE_Result res = remap_seg(utc, new_va, old_va, len, pad_begin,
+				   pad_end);
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
+}
@@ -5,6 +5,7 @@
 #include <compiler.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <kernel/trace_ring.h>
 #include <kernel/wait_queue.h>
 #include <optee_rpc_cmd.h>
 #include <string.h>
@@ -81,6 +82,7 @@ void wq_wait_final(struct wait_queue *wq, struct wait_queue_elem *wqe,
 	uint32_t old_itr_status;
 	unsigned done;
 
+	trace_ring_emit(TRACE_RING_WAIT_BEGIN, (vaddr_t)sync_obj);
 	do {
 		__wq_rpc(OPTEE_RPC_WAIT_QUEUE_SLEEP, wqe->handle,
 			 sync_obj, fname, lineno);
@@ -93,6 +95,7 @@ void wq_wait_final(struct wait_queue *wq, struct wait_queue_elem *wqe,
 
 		cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
 	} while (!done);
+	trace_ring_emit(TRACE_RING_WAIT_END, (vaddr_t)sync_obj);
 }
 
 void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
@@ -1630,7 +1630,8 @@ void core_mmu_populate_user_map(struct core_mmu_table_info *dir_info,
 	core_mmu_set_info_table(&pg_info, dir_info->level + 1, 0, NULL);
 
 	TAILQ_FOREACH(r, &utc->vm_info->regions, link)
-		set_pg_region(dir_info, r, &pgt, &pg_info);
+		if (!tee_mmu_is_foreign_region(r))
+			set_pg_region(dir_info, r, &pgt, &pg_info);
 }
 
 bool core_mmu_add_mapping(enum teecore_memtypes type, paddr_t addr, size_t len)
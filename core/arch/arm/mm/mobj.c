@@ -19,6 +19,8 @@
 #include <optee_msg.h>
 #include <sm/optee_smc.h>
 #include <stdlib.h>
+#include <string.h>
+#include <string_ext.h>
 #include <tee_api_types.h>
 #include <types_ext.h>
 #include <util.h>
@@ -296,6 +298,118 @@ struct mobj *mobj_mm_alloc(struct mobj *mobj_parent, size_t size,
 	return &m->mobj;
 }
 
+/*
+ * Pool of secure DDR bounce buffers in power of 2 page size classes,
+ * BOUNCE_NUM_CLASSES classes from one page. Larger buffers are allocated
+ * and freed directly. Cached buffers are wiped and hold at most
+ * CFG_TA_BOUNCE_POOL_SIZE bytes in total.
+ */
+#define BOUNCE_NUM_CLASSES	5
+#define BOUNCE_SLOTS		8
+
+static struct mobj *bounce_pool[BOUNCE_NUM_CLASSES][BOUNCE_SLOTS];
+static size_t bounce_num_free[BOUNCE_NUM_CLASSES];
+static unsigned int bounce_lock = SPINLOCK_UNLOCK;
+static struct mobj_bounce_stats bounce_stats;
+
+static size_t bounce_class(size_t size)
+{
+	size_t cls = 0;
+
+	while (cls < BOUNCE_NUM_CLASSES &&
+	       size > ((size_t)SMALL_PAGE_SIZE << cls))
+		cls++;
+
+	return cls;
+}
+
+struct mobj *mobj_bounce_alloc(size_t size)
+{
+	size_t cls = bounce_class(size);
+	struct mobj *mobj = NULL;
+	uint32_t exceptions = 0;
+
+	exceptions = cpu_spin_lock_xsave(&bounce_lock);
+	if (cls < BOUNCE_NUM_CLASSES && bounce_num_free[cls]) {
+		bounce_num_free[cls]--;
+		mobj = bounce_pool[cls][bounce_num_free[cls]];
+		bounce_stats.cached_bytes -= mobj->size;
+		bounce_stats.hits++;
+	} else {
+		bounce_stats.misses++;
+	}
+	cpu_spin_unlock_xrestore(&bounce_lock, exceptions);
+
+	if (mobj)
+		return mobj;
+
+	if (cls < BOUNCE_NUM_CLASSES)
+		size = (size_t)SMALL_PAGE_SIZE << cls;
+
+	mobj = mobj_mm_alloc(mobj_sec_ddr, size, &tee_mm_sec_ddr);
+	if (!mobj && mobj_bounce_evict())
+		mobj = mobj_mm_alloc(mobj_sec_ddr, size, &tee_mm_sec_ddr);
+
+	return mobj;
+}
+
+void mobj_bounce_free(struct mobj *mobj)
+{
+	uint32_t exceptions = 0;
+	size_t cls = 0;
+
+	if (!mobj)
+		return;
+
+	memzero_explicit(mobj_get_va(mobj, 0), mobj->size);
+
+	cls = bounce_class(mobj->size);
+	exceptions = cpu_spin_lock_xsave(&bounce_lock);
+	if (cls < BOUNCE_NUM_CLASSES &&
+	    bounce_num_free[cls] < BOUNCE_SLOTS &&
+	    bounce_stats.cached_bytes + mobj->size <=
+	    CFG_TA_BOUNCE_POOL_SIZE) {
+		bounce_pool[cls][bounce_num_free[cls]] = mobj;
+		bounce_num_free[cls]++;
+		bounce_stats.cached_bytes += mobj->size;
+		mobj = NULL;
+	}
+	cpu_spin_unlock_xrestore(&bounce_lock, exceptions);
+
+	mobj_free(mobj);
+}
+
+bool mobj_bounce_evict(void)
+{
+	struct mobj *mobjs[BOUNCE_NUM_CLASSES * BOUNCE_SLOTS] = { };
+	uint32_t exceptions = 0;
+	size_t num = 0;
+	size_t cls = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&bounce_lock);
+	for (cls = 0; cls < BOUNCE_NUM_CLASSES; cls++) {
+		for (n = 0; n < bounce_num_free[cls]; n++)
+			mobjs[num++] = bounce_pool[cls][n];
+		bounce_num_free[cls] = 0;
+	}
+	bounce_stats.cached_bytes = 0;
+	bounce_stats.evictions += num;
+	cpu_spin_unlock_xrestore(&bounce_lock, exceptions);
+
+	for (n = 0; n < num; n++)
+		mobj_free(mobjs[n]);
+
+	return num;
+}
+
+void mobj_bounce_get_stats(struct mobj_bounce_stats *stats)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&bounce_lock);
+
+	*stats = bounce_stats;
+	cpu_spin_unlock_xrestore(&bounce_lock, exceptions);
+}
 
 /*
  * mobj_shm implementation. mobj_shm represents buffer in predefined shm region
@@ -616,6 +730,170 @@ static const struct mobj_ops mobj_with_fobj_ops __rodata_unpaged = {
 	.get_pa = mobj_with_fobj_get_pa,
 };
 
+struct mobj_ta_share {
+	tee_mm_entry_t *frag_mm;
+	uint8_t *frag_va;
+	size_t num_frags;
+	bool head;
+	bool readonly;
+	struct mobj mobj;
+	paddr_t pages[];
+};
+
+static const struct mobj_ops mobj_ta_share_ops;
+
+static struct mobj_ta_share *to_mobj_ta_share(struct mobj *mobj)
+{
+	assert(mobj && mobj->ops == &mobj_ta_share_ops);
+
+	return container_of(mobj, struct mobj_ta_share, mobj);
+}
+
+struct mobj *mobj_ta_share_alloc(struct mobj *src, size_t src_offs,
+				 size_t num_pages, bool head, bool tail,
+				 bool readonly)
+{
+	struct mobj_ta_share *m = NULL;
+	size_t num_frags = !!head + !!tail;
+	size_t tot_pages = 0;
+	paddr_t pa = 0;
+	size_t n = 0;
+
+	if (ADD_OVERFLOW(num_pages, num_frags, &tot_pages) ||
+	    MUL_OVERFLOW(tot_pages, sizeof(paddr_t), &n) ||
+	    ADD_OVERFLOW(n, sizeof(*m), &n))
+		return NULL;
+
+	m = calloc(1, n);
+	if (!m)
+		return NULL;
+
+	m->mobj.ops = &mobj_ta_share_ops;
+	m->mobj.size = tot_pages * SMALL_PAGE_SIZE;
+	m->mobj.phys_granule = SMALL_PAGE_SIZE;
+	m->head = head;
+	m->readonly = readonly;
+	m->num_frags = num_frags;
+
+	if (num_frags) {
+		m->frag_mm = tee_mm_alloc(&tee_mm_sec_ddr,
+					  num_frags * SMALL_PAGE_SIZE);
+		if (!m->frag_mm)
+			goto err;
+		pa = tee_mm_get_smem(m->frag_mm);
+		m->frag_va = phys_to_virt(pa, MEM_AREA_TA_RAM);
+		if (!m->frag_va)
+			goto err;
+		/* The rest of the fragment pages is visible to the callee */
+		memset(m->frag_va, 0, num_frags * SMALL_PAGE_SIZE);
+		if (head)
+			m->pages[0] = pa;
+		if (tail)
+			m->pages[tot_pages - 1] = pa + (num_frags - 1) *
+						       SMALL_PAGE_SIZE;
+	}
+
+	for (n = 0; n < num_pages; n++) {
+		if (mobj_get_pa(src, src_offs + n * SMALL_PAGE_SIZE, 0, &pa) ||
+		    (pa & SMALL_PAGE_MASK))
+			goto err;
+		m->pages[n + !!head] = pa;
+	}
+
+	return &m->mobj;
+err:
+	tee_mm_free(m->frag_mm);
+	free(m);
+	return NULL;
+}
+
+static void *mobj_ta_share_get_va(struct mobj *mobj, size_t offs)
+{
+	struct mobj_ta_share *m = to_mobj_ta_share(mobj);
+	size_t pidx = offs / SMALL_PAGE_SIZE;
+	size_t tail_pidx = mobj->size / SMALL_PAGE_SIZE - 1;
+
+	if (offs >= mobj->size)
+		return NULL;
+	if (m->head && !pidx)
+		return m->frag_va + offs;
+	if (m->num_frags > !!m->head && pidx == tail_pidx)
+		return m->frag_va + (m->num_frags - 1) * SMALL_PAGE_SIZE +
+		       (offs & SMALL_PAGE_MASK);
+
+	/* The shared pages are only accessible through the source mobj */
+	return NULL;
+}
+
+static TEE_Result mobj_ta_share_get_pa(struct mobj *mobj, size_t offs,
+				       size_t granule, paddr_t *pa)
+{
+	struct mobj_ta_share *m = to_mobj_ta_share(mobj);
+	paddr_t p = 0;
+
+	if (!pa || offs >= mobj->size)
+		return TEE_ERROR_GENERIC;
+
+	p = m->pages[offs / SMALL_PAGE_SIZE];
+	switch (granule) {
+	case 0:
+		p += offs & SMALL_PAGE_MASK;
+		break;
+	case SMALL_PAGE_SIZE:
+		break;
+	default:
+		return TEE_ERROR_GENERIC;
+	}
+	*pa = p;
+
+	return TEE_SUCCESS;
+}
+KEEP_PAGER(mobj_ta_share_get_pa);
+
+static TEE_Result mobj_ta_share_get_cattr(struct mobj *mobj __unused,
+					  uint32_t *cattr)
+{
+	if (!cattr)
+		return TEE_ERROR_GENERIC;
+
+	*cattr = TEE_MATTR_CACHE_CACHED;
+
+	return TEE_SUCCESS;
+}
+
+static bool mobj_ta_share_matches(struct mobj *mobj __maybe_unused,
+				  enum buf_is_attr attr)
+{
+	assert(to_mobj_ta_share(mobj));
+
+	return attr == CORE_MEM_SEC;
+}
+
+static void mobj_ta_share_free(struct mobj *mobj)
+{
+	struct mobj_ta_share *m = to_mobj_ta_share(mobj);
+
+	if (m->frag_mm) {
+		memset(m->frag_va, 0, m->num_frags * SMALL_PAGE_SIZE);
+		tee_mm_free(m->frag_mm);
+	}
+	free(m);
+}
+
+static const struct mobj_ops mobj_ta_share_ops __rodata_unpaged = {
+	.get_va = mobj_ta_share_get_va,
+	.get_pa = mobj_ta_share_get_pa,
+	.get_cattr = mobj_ta_share_get_cattr,
+	.matches = mobj_ta_share_matches,
+	.free = mobj_ta_share_free,
+};
+
+bool mobj_is_readonly(struct mobj *mobj)
+{
+	return mobj && mobj->ops == &mobj_ta_share_ops &&
+	       to_mobj_ta_share(mobj)->readonly;
+}
+
 #ifdef CFG_PAGED_USER_TA
 bool mobj_is_paged(struct mobj *mobj)
 {
@@ -284,6 +284,8 @@ TEE_Result vm_map_pad(struct user_ta_ctx *utc, vaddr_t *va, size_t len,
 	reg->va = *va;
 	reg->size = ROUNDUP(len, SMALL_PAGE_SIZE);
 	reg->attr = attr | prot;
+	if (prot & TEE_MATTR_EPHEMERAL)
+		reg->owner = thread_get_id();
 
 	res = umap_add_region(utc->vm_info, reg, pad_begin, pad_end);
 	if (res)
@@ -473,7 +475,8 @@ void tee_mmu_clean_param(struct user_ta_ctx *utc)
 	struct vm_region *r;
 
 	TAILQ_FOREACH_SAFE(r, &utc->vm_info->regions, link, next_r) {
-		if (r->attr & TEE_MATTR_EPHEMERAL) {
+		if ((r->attr & TEE_MATTR_EPHEMERAL) &&
+		    !tee_mmu_is_foreign_region(r)) {
 			if (mobj_is_paged(r->mobj))
 				tee_pager_rem_uta_region(utc, r->va, r->size);
 			maybe_free_pgt(utc, r);
@@ -487,7 +490,8 @@ static void check_param_map_empty(struct user_ta_ctx *utc __maybe_unused)
 	struct vm_region *r = NULL;
 
 	TAILQ_FOREACH(r, &utc->vm_info->regions, link)
-		assert(!(r->attr & TEE_MATTR_EPHEMERAL));
+		assert(!(r->attr & TEE_MATTR_EPHEMERAL) ||
+		       tee_mmu_is_foreign_region(r));
 }
 
 static TEE_Result param_mem_to_user_va(struct user_ta_ctx *utc,
@@ -499,7 +503,8 @@ static TEE_Result param_mem_to_user_va(struct user_ta_ctx *utc,
 		vaddr_t va;
 		size_t phys_offs;
 
-		if (!(region->attr & TEE_MATTR_EPHEMERAL))
+		if (!(region->attr & TEE_MATTR_EPHEMERAL) ||
+		    tee_mmu_is_foreign_region(region))
 			continue;
 		if (mem->mobj != region->mobj)
 			continue;
@@ -606,8 +611,13 @@ TEE_Result tee_mmu_map_param(struct user_ta_ctx *utc,
 
 	for (n = 0; n < m; n++) {
 		vaddr_t va = 0;
-		const uint32_t prot = TEE_MATTR_PRW | TEE_MATTR_URW |
-				      TEE_MATTR_EPHEMERAL | TEE_MATTR_SHAREABLE;
+		uint32_t prot = TEE_MATTR_PRW | TEE_MATTR_URW |
+				TEE_MATTR_EPHEMERAL | TEE_MATTR_SHAREABLE;
+
+		/* Input pages shared by the calling TA */
+		if (mobj_is_readonly(mem[n].mobj))
+			prot = TEE_MATTR_PR | TEE_MATTR_UR |
+			       TEE_MATTR_EPHEMERAL | TEE_MATTR_SHAREABLE;
 
 		res = vm_map(utc, &va, mem[n].size, prot, mem[n].mobj,
 			     mem[n].offs);
@@ -702,50 +712,71 @@ void vm_info_final(struct user_ta_ctx *utc)
 	utc->vm_info = NULL;
 }
 
+/*
+ * The VM map of a concurrent TA may be changed by the other threads
+ * executing it, the functions below looking it up take user_ta_lock().
+ */
+
 /* return true only if buffer fits inside TA private memory */
-bool tee_mmu_is_vbuf_inside_ta_private(const struct user_ta_ctx *utc,
-				  const void *va, size_t size)
+bool tee_mmu_is_vbuf_inside_ta_private(struct user_ta_ctx *utc,
+				       const void *va, size_t size)
 {
 	struct vm_region *r;
 	uint32_t nonpriv_attrs = TEE_MATTR_EPHEMERAL | TEE_MATTR_PERMANENT |
 				 TEE_MATTR_SHAREABLE;
+	bool locked = user_ta_lock(utc);
+	bool rc = false;
 
 	TAILQ_FOREACH(r, &utc->vm_info->regions, link) {
 		if (r->attr & nonpriv_attrs)
 			continue;
-		if (core_is_buffer_inside(va, size, r->va, r->size))
-			return true;
+		if (core_is_buffer_inside(va, size, r->va, r->size)) {
+			rc = true;
+			break;
+		}
 	}
 
-	return false;
+	if (locked)
+		user_ta_unlock(utc);
+
+	return rc;
 }
 
 /* return true only if buffer intersects TA private memory */
-bool tee_mmu_is_vbuf_intersect_ta_private(const struct user_ta_ctx *utc,
+bool tee_mmu_is_vbuf_intersect_ta_private(struct user_ta_ctx *utc,
 					  const void *va, size_t size)
 {
 	struct vm_region *r;
 	uint32_t nonpriv_attrs = TEE_MATTR_EPHEMERAL | TEE_MATTR_PERMANENT |
 				 TEE_MATTR_SHAREABLE;
+	bool locked = user_ta_lock(utc);
+	bool rc = false;
 
 	TAILQ_FOREACH(r, &utc->vm_info->regions, link) {
 		if (r->attr & nonpriv_attrs)
 			continue;
-		if (core_is_buffer_intersect(va, size, r->va, r->size))
-			return true;
+		if (core_is_buffer_intersect(va, size, r->va, r->size)) {
+			rc = true;
+			break;
+		}
 	}
 
-	return false;
+	if (locked)
+		user_ta_unlock(utc);
+
+	return rc;
 }
 
-TEE_Result tee_mmu_vbuf_to_mobj_offs(const struct user_ta_ctx *utc,
+TEE_Result tee_mmu_vbuf_to_mobj_offs(struct user_ta_ctx *utc,
 				     const void *va, size_t size,
 				     struct mobj **mobj, size_t *offs)
 {
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	bool locked = user_ta_lock(utc);
 	struct vm_region *r;
 
 	TAILQ_FOREACH(r, &utc->vm_info->regions, link) {
-		if (!r->mobj)
+		if (!r->mobj || tee_mmu_is_foreign_region(r))
 			continue;
 		if (core_is_buffer_inside(va, size, r->va, r->size)) {
 			size_t poffs;
@@ -754,19 +785,26 @@ TEE_Result tee_mmu_vbuf_to_mobj_offs(const struct user_ta_ctx *utc,
 						   CORE_MMU_USER_PARAM_SIZE);
 			*mobj = r->mobj;
 			*offs = (vaddr_t)va - r->va + r->offset - poffs;
-			return TEE_SUCCESS;
+			res = TEE_SUCCESS;
+			break;
 		}
 	}
 
-	return TEE_ERROR_BAD_PARAMETERS;
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
 }
 
-static TEE_Result tee_mmu_user_va2pa_attr(const struct user_ta_ctx *utc,
+/* Called with user_ta_lock() held */
+static TEE_Result tee_mmu_user_va2pa_attr(struct user_ta_ctx *utc,
 			void *ua, paddr_t *pa, uint32_t *attr)
 {
 	struct vm_region *region;
 
 	TAILQ_FOREACH(region, &utc->vm_info->regions, link) {
+		if (tee_mmu_is_foreign_region(region))
+			continue;
 		if (!core_is_buffer_inside(ua, 1, region->va, region->size))
 			continue;
 
@@ -806,15 +844,20 @@ static TEE_Result tee_mmu_user_va2pa_attr(const struct user_ta_ctx *utc,
 	return TEE_ERROR_ACCESS_DENIED;
 }
 
-TEE_Result tee_mmu_user_va2pa_helper(const struct user_ta_ctx *utc, void *ua,
+TEE_Result tee_mmu_user_va2pa_helper(struct user_ta_ctx *utc, void *ua,
 				     paddr_t *pa)
 {
-	return tee_mmu_user_va2pa_attr(utc, ua, pa, NULL);
+	bool locked = user_ta_lock(utc);
+	TEE_Result res = tee_mmu_user_va2pa_attr(utc, ua, pa, NULL);
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
 }
 
-/* */
-TEE_Result tee_mmu_user_pa2va_helper(const struct user_ta_ctx *utc,
-				      paddr_t pa, void **va)
+static TEE_Result user_pa2va_unlocked(struct user_ta_ctx *utc, paddr_t pa,
+				      void **va)
 {
 	TEE_Result res;
 	paddr_t p;
@@ -863,9 +906,21 @@ TEE_Result tee_mmu_user_pa2va_helper(const struct user_ta_ctx *utc,
 	return TEE_ERROR_ACCESS_DENIED;
 }
 
-TEE_Result tee_mmu_check_access_rights(const struct user_ta_ctx *utc,
-				       uint32_t flags, uaddr_t uaddr,
-				       size_t len)
+TEE_Result tee_mmu_user_pa2va_helper(struct user_ta_ctx *utc,
+				     paddr_t pa, void **va)
+{
+	bool locked = user_ta_lock(utc);
+	TEE_Result res = user_pa2va_unlocked(utc, pa, va);
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
+}
+
+static TEE_Result check_access_rights_unlocked(struct user_ta_ctx *utc,
+					       uint32_t flags, uaddr_t uaddr,
+					       size_t len)
 {
 	uaddr_t a;
 	uaddr_t end_addr = 0;
@@ -912,6 +967,19 @@ TEE_Result tee_mmu_check_access_rights(const struct user_ta_ctx *utc,
 	return TEE_SUCCESS;
 }
 
+TEE_Result tee_mmu_check_access_rights(struct user_ta_ctx *utc,
+				       uint32_t flags, uaddr_t uaddr,
+				       size_t len)
+{
+	bool locked = user_ta_lock(utc);
+	TEE_Result res = check_access_rights_unlocked(utc, flags, uaddr, len);
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
+}
+
 void tee_mmu_set_ctx(struct tee_ta_ctx *ctx)
 {
 	struct thread_specific_data *tsd = thread_get_tsd();
@@ -930,8 +998,11 @@ void tee_mmu_set_ctx(struct tee_ta_ctx *ctx)
 	if (is_user_ta_ctx(ctx)) {
 		struct core_mmu_user_map map;
 		struct user_ta_ctx *utc = to_user_ta_ctx(ctx);
+		bool locked = user_ta_lock(utc);
 
 		core_mmu_create_user_map(utc, &map);
+		if (locked)
+			user_ta_unlock(utc);
 		core_mmu_set_user_map(&map);
 		tee_pager_assign_uta_tables(utc);
 	}
@@ -1008,8 +1079,12 @@ void teecore_init_pub_ram(void)
 uint32_t tee_mmu_user_get_cache_attr(struct user_ta_ctx *utc, void *va)
 {
 	uint32_t attr;
+	bool locked = user_ta_lock(utc);
+	TEE_Result res = tee_mmu_user_va2pa_attr(utc, va, NULL, &attr);
 
-	if (tee_mmu_user_va2pa_attr(utc, va, NULL, &attr) != TEE_SUCCESS)
+	if (locked)
+		user_ta_unlock(utc);
+	if (res != TEE_SUCCESS)
 		panic("cannot get attr");
 
 	return (attr >> TEE_MATTR_CACHE_SHIFT) & TEE_MATTR_CACHE_MASK;
@@ -17,6 +17,7 @@
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
 #include <kernel/tlb_helpers.h>
+#include <kernel/trace_ring.h>
 #include <mm/core_memprot.h>
 #include <mm/fobj.h>
 #include <mm/tee_mm.h>
@@ -1319,6 +1320,8 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 	 * and once everything is ready we map it.
 	 */
 	exceptions = pager_lock(ai);
+	trace_ring_emit(TRACE_RING_PAGER_FAULT_BEGIN,
+			page_va >> SMALL_PAGE_SHIFT);
 
 	stat_handle_fault();
 
@@ -1441,6 +1444,8 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 	tee_pager_hide_pages();
 	ret = true;
 out:
+	trace_ring_emit(TRACE_RING_PAGER_FAULT_END,
+			page_va >> SMALL_PAGE_SHIFT);
 	pager_unlock(exceptions);
 	return ret;
 }
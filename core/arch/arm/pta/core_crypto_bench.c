@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2019, agent
+ */
+
+#include <crypto/crypto.h>
+#include <kernel/tee_time.h>
+#include <pta_invoke_tests.h>
+#include <string.h>
+#include <trace.h>
+#include <utee_defines.h>
+
+#include "core_self_tests.h"
+
+static uint32_t elapsed_ms(const TEE_Time *start)
+{
+	TEE_Time now = { };
+	TEE_Time d = { };
+
+	if (tee_time_get_sys_time(&now))
+		return 0;
+	TEE_TIME_SUB(now, *start, d);
+	return d.seconds * TEE_TIME_MILLIS_BASE + d.millis;
+}
+
+static uint32_t ops_per_sec(uint32_t n, uint32_t ms)
+{
+	if (!ms)
+		ms = 1;
+	return ((uint64_t)n * TEE_TIME_MILLIS_BASE) / ms;
+}
+
+static uint32_t ecc_curve_to_algo(uint32_t curve, size_t *bits)
+{
+	switch (curve) {
+	case TEE_ECC_CURVE_NIST_P192:
+		*bits = 192;
+		return TEE_ALG_ECDSA_P192;
+	case TEE_ECC_CURVE_NIST_P224:
+		*bits = 224;
+		return TEE_ALG_ECDSA_P224;
+	case TEE_ECC_CURVE_NIST_P256:
+		*bits = 256;
+		return TEE_ALG_ECDSA_P256;
+	case TEE_ECC_CURVE_NIST_P384:
+		*bits = 384;
+		return TEE_ALG_ECDSA_P384;
+	case TEE_ECC_CURVE_NIST_P521:
+		*bits = 521;
+		return TEE_ALG_ECDSA_P521;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * [in]  value[0].a	Curve, TEE_ECC_CURVE_NIST_*
+ * [in]  value[0].b	Number of iterations of each operation
+ * [out] value[1].a	Key generations per second
+ * [out] value[1].b	Signatures per second
+ * [out] value[2].a	Verifications per second
+ */
+TEE_Result core_ecc_bench(uint32_t param_types,
+			  TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	struct ecc_public_key pub = { };
+	struct ecc_keypair key = { };
+	uint8_t msg[TEE_SHA256_HASH_SIZE] = { 0 };
+	uint8_t sig[2 * 66] = { 0 };
+	size_t sig_len = 0;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Time start = { };
+	uint32_t algo = 0;
+	size_t bits = 0;
+	uint32_t n = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	algo = ecc_curve_to_algo(params[0].value.a, &bits);
+	if (!algo || !params[0].value.b)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = crypto_acipher_alloc_ecc_keypair(&key, bits);
+	if (res)
+		return res;
+	res = crypto_acipher_alloc_ecc_public_key(&pub, bits);
+	if (res)
+		goto out;
+	key.curve = params[0].value.a;
+	pub.curve = params[0].value.a;
+
+	res = tee_time_get_sys_time(&start);
+	if (res)
+		goto out;
+	for (n = 0; n < params[0].value.b; n++) {
+		res = crypto_acipher_gen_ecc_key(&key);
+		if (res)
+			goto out;
+	}
+	params[1].value.a = ops_per_sec(n, elapsed_ms(&start));
+
+	res = tee_time_get_sys_time(&start);
+	if (res)
+		goto out;
+	for (n = 0; n < params[0].value.b; n++) {
+		sig_len = sizeof(sig);
+		res = crypto_acipher_ecc_sign(algo, &key, msg, sizeof(msg),
+					      sig, &sig_len);
+		if (res)
+			goto out;
+	}
+	params[1].value.b = ops_per_sec(n, elapsed_ms(&start));
+
+	crypto_bignum_copy(pub.x, key.x);
+	crypto_bignum_copy(pub.y, key.y);
+	res = tee_time_get_sys_time(&start);
+	if (res)
+		goto out;
+	for (n = 0; n < params[0].value.b; n++) {
+		res = crypto_acipher_ecc_verify(algo, &pub, msg, sizeof(msg),
+						sig, sig_len);
+		if (res)
+			goto out;
+	}
+	params[2].value.a = ops_per_sec(n, elapsed_ms(&start));
+
+	IMSG("ECC curve %#"PRIx32": %"PRIu32" keygen/s %"PRIu32" sign/s %"
+	     PRIu32" verify/s", params[0].value.a, params[1].value.a,
+	     params[1].value.b, params[2].value.a);
+out:
+	crypto_acipher_free_ecc_public_key(&pub);
+	crypto_bignum_free(key.d);
+	crypto_bignum_free(key.x);
+	crypto_bignum_free(key.y);
+	return res;
+}
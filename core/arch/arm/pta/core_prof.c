@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2019, agent
+ */
+
+#include <kernel/core_prof.h>
+#include <kernel/pseudo_ta.h>
+#include <pta_core_prof.h>
+
+#define TA_NAME		"core_prof.pta"
+
+static TEE_Result pc_start(uint32_t param_types,
+			   TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	return core_prof_pc_start(params[0].value.a);
+}
+
+static TEE_Result pc_get(uint32_t param_types,
+			 TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_SUCCESS;
+	size_t len = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	len = params[0].memref.size;
+	res = core_prof_pc_get(params[0].memref.buffer, &len);
+	params[0].memref.size = len;
+
+	return res;
+}
+
+static TEE_Result syscall_get(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_SUCCESS;
+	size_t len = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	len = params[0].memref.size;
+	res = core_prof_syscall_get(params[0].memref.buffer, &len,
+				    params[1].value.a);
+	params[0].memref.size = len;
+
+	return res;
+}
+
+static TEE_Result invoke_command(void *session_ctx __unused, uint32_t cmd_id,
+				 uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t no_params = TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+					     TEE_PARAM_TYPE_NONE,
+					     TEE_PARAM_TYPE_NONE,
+					     TEE_PARAM_TYPE_NONE);
+
+	switch (cmd_id) {
+	case PTA_CORE_PROF_PC_START:
+		return pc_start(param_types, params);
+	case PTA_CORE_PROF_PC_STOP:
+		if (param_types != no_params)
+			return TEE_ERROR_BAD_PARAMETERS;
+		core_prof_pc_stop();
+		return TEE_SUCCESS;
+	case PTA_CORE_PROF_PC_GET:
+		return pc_get(param_types, params);
+	case PTA_CORE_PROF_SYSCALL_GET:
+		return syscall_get(param_types, params);
+	default:
+		break;
+	}
+
+	return TEE_ERROR_BAD_PARAMETERS;
+}
+
+pseudo_ta_register(.uuid = PTA_CORE_PROF_UUID, .name = TA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .invoke_command_entry_point = invoke_command);
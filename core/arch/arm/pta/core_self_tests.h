@@ -31,4 +31,16 @@ static inline TEE_Result core_lockdep_tests(
 }
 #endif
 
+#ifdef CFG_CRYPTO_ECC
+TEE_Result core_ecc_bench(uint32_t nParamTypes,
+			  TEE_Param pParams[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_ecc_bench(
+		uint32_t nParamTypes __unused,
+		TEE_Param pParams[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 #endif /*CORE_SELF_TESTS_H*/
@@ -223,6 +223,20 @@ static TEE_Result test_entry_params(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	return TEE_ERROR_BAD_PARAMETERS;
 }
 
+static TEE_Result test_echo(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INOUT,
+			    TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	p[0].value.a += p[1].value.a;
+	p[0].value.b += p[1].value.b;
+
+	return TEE_SUCCESS;
+}
+
 /*
  * Test access to Secure Data Path memory from pseudo TAs
  */
@@ -410,6 +424,10 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 		return core_mutex_tests(nParamTypes, pParams);
 	case PTA_INVOKE_TESTS_CMD_LOCKDEP:
 		return core_lockdep_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_ECC_BENCH:
+		return core_ecc_bench(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_ECHO:
+		return test_echo(nParamTypes, pParams);
 	default:
 		break;
 	}
@@ -108,8 +108,8 @@ static TEE_Result install_ta(struct shdr *shdr, const uint8_t *nw,
 	while (offs < nw_size) {
 		size_t l = MIN(buf_size, nw_size - offs);
 
-		memcpy(buf, nw + offs, l);
-		res = crypto_hash_update(hash_ctx, hash_algo, buf, l);
+		res = crypto_hash_copy_update(hash_ctx, hash_algo, buf,
+					      nw + offs, l);
 		if (res)
 			goto err_ta_finalize;
 		res = tee_tadb_ta_write(ta, buf, l);
@@ -3,9 +3,15 @@
  * Copyright (c) 2015, Linaro Limited
  */
 #include <compiler.h>
+#include <crypto/crypto.h>
 #include <stdio.h>
 #include <trace.h>
+#include <kernel/interrupt.h>
+#include <kernel/lock_stat.h>
+#include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
+#include <mm/file.h>
+#include <mm/mobj.h>
 #include <mm/tee_pager.h>
 #include <mm/tee_mm.h>
 #include <string.h>
@@ -21,6 +27,12 @@
 #define STATS_CMD_PAGER_STATS		0
 #define STATS_CMD_ALLOC_STATS		1
 #define STATS_CMD_MEMLEAK_STATS		2
+#define STATS_CMD_RNG_STATS		3
+#define STATS_CMD_INTERRUPT_STATS	4
+#define STATS_CMD_TA_CACHE_STATS	5
+#define STATS_CMD_LOCK_STATS		6
+#define STATS_CMD_MUTEX_WAIT_STATS	7
+#define STATS_CMD_BOUNCE_STATS		8
 
 #define STATS_NB_POOLS			4
 
@@ -137,6 +149,165 @@ static TEE_Result get_memleak_stats(uint32_t type,
 	return TEE_SUCCESS;
 }
 
+#ifdef CFG_WITH_SOFTWARE_PRNG
+static TEE_Result get_rng_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct crypto_rng_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	crypto_rng_get_stats(&stats);
+	p[0].value.a = stats.buf_reads;
+	p[0].value.b = stats.buf_refills;
+	p[1].value.a = stats.direct_reads;
+	p[1].value.b = stats.reseeds;
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result get_rng_stats(uint32_t type __unused,
+				TEE_Param p[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+static TEE_Result get_interrupt_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	size_t num_stats = 0;
+	size_t count = 0;
+
+	/*
+	 * p[0].value.a = 0 if no reset of the stats
+	 * p[1].memref.buffer = output buffer to an array of struct itr_stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	num_stats = p[1].memref.size / sizeof(struct itr_stats);
+	count = itr_get_stats(NULL, 0, false);
+	p[1].memref.size = count * sizeof(struct itr_stats);
+	if (count > num_stats)
+		return TEE_ERROR_SHORT_BUFFER;
+
+	itr_get_stats(p[1].memref.buffer, count, !!p[0].value.a);
+
+	return TEE_SUCCESS;
+}
+
+static uint32_t avg_ms(uint64_t total_ms, uint32_t count)
+{
+	if (!count)
+		return 0;
+	return total_ms / count;
+}
+
+static TEE_Result get_ta_cache_stats(uint32_t type,
+				     TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct file_cache_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	file_cache_get_stats(&stats);
+	p[0].value.a = stats.warm_loads;
+	p[0].value.b = stats.cold_loads;
+	p[1].value.a = stats.evictions;
+	p[1].value.b = stats.cached_bytes;
+	p[2].value.a = avg_ms(stats.warm_load_ms, stats.warm_loads);
+	p[2].value.b = avg_ms(stats.cold_load_ms, stats.cold_loads);
+
+	return TEE_SUCCESS;
+}
+
+#ifdef CFG_LOCK_STAT
+static TEE_Result get_lock_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	size_t num_stats = 0;
+	size_t count = 0;
+
+	/*
+	 * p[0].value.a = 0 if no reset of the stats
+	 * p[1].memref.buffer = output buffer to an array of struct lock_stat
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	num_stats = p[1].memref.size / sizeof(struct lock_stat);
+	count = lock_stat_get(NULL, 0, false);
+	p[1].memref.size = count * sizeof(struct lock_stat);
+	if (count > num_stats)
+		return TEE_ERROR_SHORT_BUFFER;
+
+	lock_stat_get(p[1].memref.buffer, count, !!p[0].value.a);
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result get_lock_stats(uint32_t type __unused,
+				 TEE_Param p[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+static TEE_Result get_mutex_wait_stats(uint32_t type,
+				       TEE_Param p[TEE_NUM_PARAMS])
+{
+	/*
+	 * p[0].value.a = 0 if no reset of the stats
+	 * p[1].memref.buffer = output buffer to struct mutex_wait_stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[1].memref.size < sizeof(struct mutex_wait_stats)) {
+		p[1].memref.size = sizeof(struct mutex_wait_stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[1].memref.size = sizeof(struct mutex_wait_stats);
+	mutex_get_wait_stats(p[1].memref.buffer, !!p[0].value.a);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_bounce_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct mobj_bounce_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mobj_bounce_get_stats(&stats);
+	p[0].value.a = stats.hits;
+	p[0].value.b = stats.misses;
+	p[1].value.a = stats.evictions;
+	p[1].value.b = stats.cached_bytes;
+
+	return TEE_SUCCESS;
+}
+
 /*
  * Trusted Application Entry Points
  */
@@ -152,6 +323,18 @@ static TEE_Result invoke_command(void *psess __unused,
 		return get_alloc_stats(ptypes, params);
 	case STATS_CMD_MEMLEAK_STATS:
 		return get_memleak_stats(ptypes, params);
+	case STATS_CMD_RNG_STATS:
+		return get_rng_stats(ptypes, params);
+	case STATS_CMD_INTERRUPT_STATS:
+		return get_interrupt_stats(ptypes, params);
+	case STATS_CMD_TA_CACHE_STATS:
+		return get_ta_cache_stats(ptypes, params);
+	case STATS_CMD_LOCK_STATS:
+		return get_lock_stats(ptypes, params);
+	case STATS_CMD_MUTEX_WAIT_STATS:
+		return get_mutex_wait_stats(ptypes, params);
+	case STATS_CMD_BOUNCE_STATS:
+		return get_bounce_stats(ptypes, params);
 	default:
 		break;
 	}
@@ -9,6 +9,7 @@
 #include <kernel/misc.h>
 #include <kernel/msg_param.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/tee_time.h>
 #include <kernel/user_ta.h>
 #include <kernel/user_ta_store.h>
 #include <mm/file.h>
@@ -17,6 +18,7 @@
 #include <pta_system.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_defines.h>
+#include <utee_defines.h>
 #include <util.h>
 
 #define MAX_ENTROPY_IN			32u
@@ -27,6 +29,8 @@ struct bin_handle {
 	struct file *f;
 	size_t offs_bytes;
 	size_t size_bytes;
+	TEE_Time start_time;
+	bool warm;
 };
 
 struct system_ctx {
@@ -186,6 +190,22 @@ static TEE_Result system_unmap(struct tee_ta_session *s, uint32_t param_types,
 			     ROUNDUP(params[0].value.a, SMALL_PAGE_SIZE));
 }
 
+static void record_load_time(struct bin_handle *binh)
+{
+	TEE_Time now = { };
+	TEE_Time d = { };
+	uint32_t ms = 0;
+
+	if (tee_time_get_sys_time(&now))
+		return;
+	TEE_TIME_SUB(now, binh->start_time, d);
+	ms = d.seconds * TEE_TIME_MILLIS_BASE + d.millis;
+
+	DMSG("%s load of TA binary took %"PRIu32" ms",
+	     binh->warm ? "Warm" : "Cold", ms);
+	file_cache_add_load_time(binh->warm, ms);
+}
+
 static void ta_bin_close(void *ptr)
 {
 	struct bin_handle *binh = ptr;
@@ -224,6 +244,9 @@ static TEE_Result system_open_ta_binary(struct system_ctx *ctx,
 	if (!binh)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
+	if (tee_time_get_sys_time(&binh->start_time))
+		binh->start_time = (TEE_Time){ };
+
 	SCATTERED_ARRAY_FOREACH(binh->op, ta_stores, struct user_ta_store_ops) {
 		DMSG("Lookup user TA ELF %pUl (%s)",
 		     (void *)uuid, binh->op->description);
@@ -246,6 +269,9 @@ static TEE_Result system_open_ta_binary(struct system_ctx *ctx,
 	binh->f = file_get_by_tag(tag, tag_len);
 	if (!binh->f)
 		goto err_oom;
+	file_lock(binh->f);
+	binh->warm = file_is_populated(binh->f);
+	file_unlock(binh->f);
 
 	h = handle_get(&ctx->db, binh);
 	if (h < 0)
@@ -259,6 +285,39 @@ err:
 	return res;
 }
 
+static TEE_Result system_prefetch_ta_binaries(uint32_t param_types,
+					      TEE_Param params[TEE_NUM_PARAMS])
+{
+	const struct user_ta_store_ops *op = NULL;
+	size_t num_uuids = 0;
+	TEE_UUID *uuids = NULL;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	uuids = params[0].memref.buffer;
+	num_uuids = params[0].memref.size / sizeof(*uuids);
+	if (!num_uuids || num_uuids > PTA_SYSTEM_PREFETCH_MAX_UUIDS ||
+	    params[0].memref.size % sizeof(*uuids) ||
+	    !ALIGNMENT_IS_OK(uuids, TEE_UUID))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/*
+	 * It's only a hint, a store failing to prefetch will report the
+	 * error when the binary is opened instead.
+	 */
+	SCATTERED_ARRAY_FOREACH(op, ta_stores, struct user_ta_store_ops) {
+		if (op->prefetch && op->prefetch(uuids, num_uuids))
+			DMSG("Prefetch failed (%s)", op->description);
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result system_close_ta_binary(struct system_ctx *ctx,
 					 uint32_t param_types,
 					 TEE_Param params[TEE_NUM_PARAMS])
@@ -284,6 +343,13 @@ static TEE_Result system_close_ta_binary(struct system_ctx *ctx,
 		res = binh->op->read(binh->h, NULL,
 				     binh->size_bytes - binh->offs_bytes);
 
+	if (!res) {
+		file_lock(binh->f);
+		file_set_verified(binh->f);
+		file_unlock(binh->f);
+		record_load_time(binh);
+	}
+
 	ta_bin_close(binh);
 	return res;
 }
@@ -322,6 +388,21 @@ static TEE_Result binh_copy_to(struct bin_handle *binh, vaddr_t va,
 	return TEE_SUCCESS;
 }
 
+static void lock_file(struct tee_ta_session *s, struct file *f)
+{
+	if (!file_trylock(f)) {
+		/*
+		 * Before we can block on the file lock we must make all
+		 * our page tables available for reclaiming in order to
+		 * avoid a dead-lock with the other thread (which already
+		 * is holding the file lock) mapping lots of memory.
+		 */
+		tee_mmu_set_ctx(NULL);
+		file_lock(f);
+		tee_mmu_set_ctx(s->ctx);
+	}
+}
+
 static TEE_Result system_map_ta_binary(struct system_ctx *ctx,
 				       struct tee_ta_session *s,
 				       uint32_t param_types,
@@ -384,17 +465,7 @@ static TEE_Result system_map_ta_binary(struct system_ctx *ctx,
 	offs_pages = offs_bytes >> SMALL_PAGE_SHIFT;
 	num_pages = ROUNDUP(num_bytes, SMALL_PAGE_SIZE) / SMALL_PAGE_SIZE;
 
-	if (!file_trylock(binh->f)) {
-		/*
-		 * Before we can block on the file lock we must make all
-		 * our page tables available for reclaiming in order to
-		 * avoid a dead-lock with the other thread (which already
-		 * is holding the file lock) mapping lots of memory below.
-		 */
-		tee_mmu_set_ctx(NULL);
-		file_lock(binh->f);
-		tee_mmu_set_ctx(s->ctx);
-	}
+	lock_file(s, binh->f);
 	file_is_locked = true;
 	fs = file_find_slice(binh->f, offs_pages);
 	if (fs) {
@@ -475,6 +546,163 @@ err:
 	return res;
 }
 
+#ifdef CFG_TA_RELOC_CACHE
+/*
+ * The key of a relocation is a hash of the tag and load address of each
+ * ELF of the TA. The file of each ELF is found via the shared read-only
+ * mapping at its load address.
+ */
+static TEE_Result reloc_cache_key(struct user_ta_ctx *utc,
+				  const uint64_t *addrs, size_t num_addrs,
+				  uint8_t key[FILE_TAG_SIZE], struct file **file)
+{
+	TEE_Result res = TEE_SUCCESS;
+	const uint8_t *tag = NULL;
+	unsigned int taglen = 0;
+	struct file *f = NULL;
+	void *ctx = NULL;
+	uint64_t addr = 0;
+	size_t n = 0;
+
+	res = crypto_hash_alloc_ctx(&ctx, TEE_ALG_SHA256);
+	if (res)
+		return res;
+	res = crypto_hash_init(ctx, TEE_ALG_SHA256);
+	if (res)
+		goto out;
+
+	for (n = 0; n < num_addrs; n++) {
+		addr = addrs[n];
+		if (addr != (vaddr_t)addr) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			goto out;
+		}
+		f = user_ta_get_file(utc, addr);
+		if (!f) {
+			res = TEE_ERROR_ITEM_NOT_FOUND;
+			goto out;
+		}
+		if (!n)
+			*file = f;
+
+		tag = file_get_tag(f, &taglen);
+		res = crypto_hash_update(ctx, TEE_ALG_SHA256, tag, taglen);
+		if (res)
+			goto out;
+		res = crypto_hash_update(ctx, TEE_ALG_SHA256, (void *)&addr,
+					 sizeof(addr));
+		if (res)
+			goto out;
+	}
+
+	res = crypto_hash_final(ctx, TEE_ALG_SHA256, key, FILE_TAG_SIZE);
+out:
+	crypto_hash_free_ctx(ctx, TEE_ALG_SHA256);
+	return res;
+}
+
+static TEE_Result system_reloc_cache(struct tee_ta_session *s,
+				     uint32_t param_types,
+				     TEE_Param params[TEE_NUM_PARAMS],
+				     bool add)
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	const uint32_t access = TEE_MEMORY_ACCESS_READ |
+				TEE_MEMORY_ACCESS_WRITE;
+	struct user_ta_ctx *utc = to_user_ta_ctx(s->ctx);
+	uint8_t key[FILE_TAG_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+	const void *data = NULL;
+	struct file *f = NULL;
+	uint64_t *segs = NULL;
+	size_t num_addrs = 0;
+	size_t num_segs = 0;
+	size_t n = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Only ldelf may use the cache, before the TA itself has run */
+	if (!utc->is_initializing)
+		return TEE_ERROR_ACCESS_DENIED;
+
+	if (!ALIGNMENT_IS_OK(params[0].memref.buffer, uint64_t) ||
+	    !ALIGNMENT_IS_OK(params[1].memref.buffer, uint64_t) ||
+	    params[0].memref.size % sizeof(uint64_t) ||
+	    params[1].memref.size % (2 * sizeof(uint64_t)))
+		return TEE_ERROR_BAD_PARAMETERS;
+	num_addrs = params[0].memref.size / sizeof(uint64_t);
+	num_segs = params[1].memref.size / (2 * sizeof(uint64_t));
+	if (!num_addrs || !num_segs)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Copy the segments to make sure they're checked as used */
+	segs = malloc(params[1].memref.size);
+	if (!segs)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memcpy(segs, params[1].memref.buffer, params[1].memref.size);
+
+	for (n = 0; n < num_segs; n++) {
+		if (segs[n * 2] != (vaddr_t)segs[n * 2] ||
+		    (segs[n * 2] & SMALL_PAGE_MASK) || !segs[n * 2 + 1] ||
+		    (segs[n * 2 + 1] & SMALL_PAGE_MASK)) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			goto out;
+		}
+		res = tee_mmu_check_access_rights(utc, access, segs[n * 2],
+						  segs[n * 2 + 1]);
+		if (res)
+			goto out;
+	}
+
+	res = reloc_cache_key(utc, params[0].memref.buffer, num_addrs, key,
+			      &f);
+	if (res)
+		goto out;
+
+	lock_file(s, f);
+	if (add) {
+		for (n = 0; n < num_segs; n++) {
+			res = file_add_reloc(f, key, segs[n * 2],
+					     (void *)(vaddr_t)segs[n * 2],
+					     segs[n * 2 + 1]);
+			if (res)
+				break;
+		}
+	} else {
+		/* All segments must be found before anything is restored */
+		for (n = 0; n < num_segs; n++) {
+			if (!file_find_reloc(f, key, segs[n * 2],
+					     segs[n * 2 + 1])) {
+				res = TEE_ERROR_ITEM_NOT_FOUND;
+				break;
+			}
+		}
+		for (n = 0; !res && n < num_segs; n++) {
+			data = file_find_reloc(f, key, segs[n * 2],
+					       segs[n * 2 + 1]);
+			memcpy((void *)(vaddr_t)segs[n * 2], data,
+			       segs[n * 2 + 1]);
+		}
+	}
+	file_unlock(f);
+out:
+	free(segs);
+	return res;
+}
+#else
+static TEE_Result system_reloc_cache(struct tee_ta_session *s __unused,
+				     uint32_t param_types __unused,
+				     TEE_Param params[TEE_NUM_PARAMS] __unused,
+				     bool add __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif /*CFG_TA_RELOC_CACHE*/
+
 static TEE_Result system_copy_from_ta_binary(struct system_ctx *ctx,
 					     uint32_t param_types,
 					     TEE_Param params[TEE_NUM_PARAMS])
@@ -620,6 +848,12 @@ static TEE_Result invoke_command(void *sess_ctx, uint32_t cmd_id,
 		return system_set_prot(s, param_types, params);
 	case PTA_SYSTEM_REMAP:
 		return system_remap(s, param_types, params);
+	case PTA_SYSTEM_RELOC_CACHE_LOOKUP:
+		return system_reloc_cache(s, param_types, params, false);
+	case PTA_SYSTEM_RELOC_CACHE_ADD:
+		return system_reloc_cache(s, param_types, params, true);
+	case PTA_SYSTEM_PREFETCH_TA_BINARIES:
+		return system_prefetch_ta_binaries(param_types, params);
 	default:
 		break;
 	}
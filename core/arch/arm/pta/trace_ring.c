@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2019, agent
+ */
+
+#include <kernel/pseudo_ta.h>
+#include <kernel/trace_ring.h>
+#include <pta_trace_ring.h>
+
+#define TA_NAME		"trace_ring.pta"
+
+static TEE_Result dump_rings(uint32_t param_types,
+			     TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_SUCCESS;
+	size_t len = 0;
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	len = params[0].memref.size;
+	res = trace_ring_dump(params[0].memref.buffer, &len);
+	params[0].memref.size = len;
+
+	return res;
+}
+
+static TEE_Result invoke_command(void *session_ctx __unused, uint32_t cmd_id,
+				 uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t no_params = TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+					     TEE_PARAM_TYPE_NONE,
+					     TEE_PARAM_TYPE_NONE,
+					     TEE_PARAM_TYPE_NONE);
+
+	switch (cmd_id) {
+	case PTA_TRACE_RING_START:
+		if (param_types != no_params)
+			return TEE_ERROR_BAD_PARAMETERS;
+		trace_ring_start();
+		return TEE_SUCCESS;
+	case PTA_TRACE_RING_STOP:
+		if (param_types != no_params)
+			return TEE_ERROR_BAD_PARAMETERS;
+		trace_ring_stop();
+		return TEE_SUCCESS;
+	case PTA_TRACE_RING_DUMP:
+		return dump_rings(param_types, params);
+	default:
+		break;
+	}
+
+	return TEE_ERROR_BAD_PARAMETERS;
+}
+
+pseudo_ta_register(.uuid = PTA_TRACE_RING_UUID, .name = TA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .invoke_command_entry_point = invoke_command);
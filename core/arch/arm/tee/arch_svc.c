@@ -6,10 +6,12 @@
 #include <arm.h>
 #include <assert.h>
 #include <kernel/abort.h>
+#include <kernel/core_prof.h>
 #include <kernel/misc.h>
 #include <kernel/panic.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
+#include <kernel/trace_ring.h>
 #include <kernel/trace_ta.h>
 #include <kernel/user_ta.h>
 #include <mm/tee_mmu.h>
@@ -117,6 +119,7 @@ static const struct syscall_entry tee_svc_syscall_table[] = {
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_cache_operation),
+	SYSCALL_ENTRY(syscall_get_property_set),
 };
 
 #ifdef TRACE_SYSCALLS
@@ -180,6 +183,9 @@ void __weak tee_svc_handler(struct thread_svc_regs *regs)
 	size_t max_args;
 	syscall_t scf;
 	uint32_t state;
+#ifdef CFG_CORE_PROF
+	uint64_t t = 0;
+#endif
 
 	COMPILE_TIME_ASSERT(ARRAY_SIZE(tee_svc_syscall_table) ==
 				(TEE_SCN_MAX + 1));
@@ -199,6 +205,7 @@ void __weak tee_svc_handler(struct thread_svc_regs *regs)
 	get_scn_max_args(regs, &scn, &max_args);
 
 	trace_syscall(scn);
+	trace_ring_emit(TRACE_RING_SYSCALL_BEGIN, scn);
 
 	if (max_args > TEE_SVC_MAX_ARGS) {
 		DMSG("Too many arguments for SCN %zu (%zu)", scn, max_args);
@@ -211,7 +218,17 @@ void __weak tee_svc_handler(struct thread_svc_regs *regs)
 	else
 		scf = tee_svc_syscall_table[scn].fn;
 
+#ifdef CFG_CORE_PROF
+	t = read_cntpct();
+#endif
 	set_svc_retval(regs, tee_svc_do_call(regs, scf));
+#ifdef CFG_CORE_PROF
+	core_prof_syscall_done(scn, read_cntpct() - t);
+#endif
+
+	/* Lets other sessions of a concurrent TA use the handles again */
+	user_ta_syscall_done();
+	trace_ring_emit(TRACE_RING_SYSCALL_END, scn);
 
 	if (scn != TEE_SCN_RETURN) {
 		/* We're about to switch back to user mode */
@@ -91,6 +91,12 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 #ifdef CFG_VIRTUALIZATION
 	args->a1 |= OPTEE_SMC_SEC_CAP_VIRTUALIZATION;
 #endif
+#ifdef CFG_CORE_MSG_QUEUE
+	args->a1 |= OPTEE_SMC_SEC_CAP_MSG_QUEUE;
+#endif
+#ifdef CFG_CORE_INVOKE_WITH_REGS
+	args->a1 |= OPTEE_SMC_SEC_CAP_INVOKE_WITH_REGS;
+#endif
 
 #if defined(CFG_CORE_DYN_SHM)
 	dyn_shm_en = core_mmu_nsec_ddr_is_defined();
@@ -4,15 +4,20 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <arm.h>
 #include <assert.h>
+#include <atomic.h>
 #include <bench.h>
 #include <compiler.h>
 #include <initcall.h>
 #include <io.h>
+#include <kernel/core_prof.h>
 #include <kernel/linker.h>
 #include <kernel/msg_param.h>
+#include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/tee_misc.h>
+#include <kernel/trace_ring.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
@@ -409,6 +414,49 @@ out:
 	smc_args->a0 = OPTEE_SMC_RETURN_OK;
 }
 
+#ifdef CFG_CORE_INVOKE_WITH_REGS
+static void entry_invoke_with_regs(struct thread_smc_args *smc_args)
+{
+	TEE_ErrorOrigin err_orig = TEE_ORIGIN_TEE;
+	struct tee_ta_param param = {
+		.types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INOUT,
+					 TEE_PARAM_TYPE_VALUE_INPUT,
+					 TEE_PARAM_TYPE_NONE,
+					 TEE_PARAM_TYPE_NONE),
+		.u[0].val = { .a = smc_args->a3, .b = smc_args->a4 },
+		.u[1].val = { .a = smc_args->a5, .b = smc_args->a6 },
+	};
+	struct tee_ta_session *s = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	bm_timestamp();
+
+	s = tee_ta_get_session(smc_args->a1, true, &tee_open_sessions);
+	if (!s) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = tee_ta_invoke_command(&err_orig, s, NSAPP_IDENTITY,
+				    TEE_TIMEOUT_INFINITE, smc_args->a2, &param);
+
+	bm_timestamp();
+
+	tee_ta_put_session(s);
+
+out:
+	smc_args->a0 = OPTEE_SMC_RETURN_OK;
+	smc_args->a1 = res;
+	if (res == TEE_SUCCESS) {
+		smc_args->a2 = param.u[0].val.a;
+		smc_args->a3 = param.u[0].val.b;
+	} else {
+		smc_args->a2 = err_orig;
+		smc_args->a3 = 0;
+	}
+}
+#endif
+
 static void entry_cancel(struct thread_smc_args *smc_args,
 			struct optee_msg_arg *arg, uint32_t num_params)
 {
@@ -529,6 +577,345 @@ static struct mobj *get_cmd_buffer(paddr_t parg, uint32_t *num_params)
 	return mobj_shm_alloc(parg, args_size, 0);
 }
 
+/*
+ * Maps the memref holding the embedded struct optee_msg_arg of a queue or
+ * a batch. Only contiguous temporary memrefs in the reserved shared memory
+ * and registered memrefs are accepted as they're the ones we can access
+ * through a kernel virtual address.
+ */
+static void put_arg_buf(uint32_t attr __maybe_unused,
+			struct mobj *mobj __maybe_unused)
+{
+#ifdef CFG_CORE_DYN_SHM
+	if (attr == OPTEE_MSG_ATTR_TYPE_RMEM_INOUT) {
+		mobj_reg_shm_dec_map(mobj);
+		mobj_reg_shm_put(mobj);
+	}
+#endif
+}
+
+static TEE_Result get_arg_buf(struct optee_msg_param *param, uint32_t attr,
+			      struct param_mem *mem)
+{
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+
+	switch (attr) {
+	case OPTEE_MSG_ATTR_TYPE_TMEM_INOUT:
+		res = set_tmem_param(&param->u.tmem, attr, mem);
+		break;
+#ifdef CFG_CORE_DYN_SHM
+	case OPTEE_MSG_ATTR_TYPE_RMEM_INOUT:
+		res = set_rmem_param(&param->u.rmem, mem);
+		if (!res)
+			res = mobj_reg_shm_inc_map(mem->mobj);
+		if (res && mem->mobj)
+			mobj_reg_shm_put(mem->mobj);
+		break;
+#endif
+	default:
+		break;
+	}
+	if (res)
+		return res;
+
+	if (!mem->mobj || !mobj_is_nonsec(mem->mobj)) {
+		put_arg_buf(attr, mem->mobj);
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Processes the struct optee_msg_arg at @offs in the @size bytes of @buf,
+ * its size is returned in @arg_size. Returns an error if the argument
+ * could not be read or holds a command which can't be embedded.
+ *
+ * Shared memory registration can't be embedded: unregistering the shared
+ * memory holding @buf would wait forever for the reference we hold.
+ */
+static TEE_Result call_embedded_arg(void *buf, size_t size, size_t offs,
+				    size_t *arg_size)
+{
+	struct thread_smc_args smc_args = { };
+	struct optee_msg_arg *arg = NULL;
+	uint32_t num_params = 0;
+	size_t end = 0;
+
+	if ((offs & 7) || ADD_OVERFLOW(offs, sizeof(*arg), &end) || end > size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	arg = (struct optee_msg_arg *)((vaddr_t)buf + offs);
+	num_params = READ_ONCE(arg->num_params);
+	if (num_params > OPTEE_MSG_MAX_NUM_PARAMS)
+		return TEE_ERROR_BAD_PARAMETERS;
+	*arg_size = OPTEE_MSG_GET_ARG_SIZE(num_params);
+	if (ADD_OVERFLOW(offs, *arg_size, &end) || end > size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	switch (READ_ONCE(arg->cmd)) {
+	case OPTEE_MSG_CMD_OPEN_SESSION:
+		entry_open_session(&smc_args, arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_CLOSE_SESSION:
+		entry_close_session(&smc_args, arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_INVOKE_COMMAND:
+		entry_invoke_command(&smc_args, arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_CANCEL:
+		entry_cancel(&smc_args, arg, num_params);
+		break;
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static void batch(struct thread_smc_args *smc_args, struct optee_msg_arg *arg,
+		  uint32_t num_params)
+{
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	struct param_mem mem = { };
+	uint32_t num_done = 0;
+	size_t arg_size = 0;
+	uint32_t attr = 0;
+	void *buf = NULL;
+	size_t offs = 0;
+	size_t n = 0;
+
+	if (num_params != 2 || READ_ONCE(arg->params[1].attr) !=
+			       OPTEE_MSG_ATTR_TYPE_VALUE_INOUT)
+		goto out;
+
+	attr = READ_ONCE(arg->params[0].attr);
+	res = get_arg_buf(arg->params, attr, &mem);
+	if (res)
+		goto out;
+
+	buf = mobj_get_va(mem.mobj, mem.offs);
+	if (!buf || !ALIGNMENT_IS_OK(buf, struct optee_msg_arg)) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto put;
+	}
+
+	n = READ_ONCE(arg->params[1].u.value.a);
+	while (num_done < n) {
+		if (call_embedded_arg(buf, mem.size, offs, &arg_size))
+			break;
+		offs += arg_size;
+		num_done++;
+	}
+	arg->params[1].u.value.a = num_done;
+put:
+	put_arg_buf(attr, mem.mobj);
+out:
+	arg->ret = res;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	smc_args->a0 = OPTEE_SMC_RETURN_OK;
+}
+
+#ifdef CFG_CORE_MSG_QUEUE
+/*
+ * The registered message queue. The ring indexes owned by secure world
+ * are kept here and only copied to the shared buffer so normal world
+ * can't change them under our feet. @in_flight counts the submissions
+ * being processed whose completions aren't posted yet and @num_workers
+ * the OPTEE_MSG_CMD_PROCESS_QUEUE calls in progress.
+ */
+struct msg_queue {
+	struct mobj *mobj;
+	uint32_t attr;
+	struct optee_msg_queue *q;
+	size_t size;
+	uint32_t num_entries;
+	uint32_t sq_head;
+	uint32_t cq_tail;
+	uint32_t in_flight;
+	uint32_t num_workers;
+};
+
+static struct msg_queue msg_queue;
+static struct mutex msg_queue_mu = MUTEX_INITIALIZER;
+
+static void register_queue(struct thread_smc_args *smc_args,
+			   struct optee_msg_arg *arg, uint32_t num_params)
+{
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	struct optee_msg_queue *q = NULL;
+	struct param_mem mem = { };
+	uint32_t num_entries = 0;
+	uint32_t attr = 0;
+	size_t sz = 0;
+
+	if (num_params != 1)
+		goto out;
+
+	attr = READ_ONCE(arg->params[0].attr);
+	res = get_arg_buf(arg->params, attr, &mem);
+	if (res)
+		goto out;
+
+	res = TEE_ERROR_BAD_PARAMETERS;
+	q = mobj_get_va(mem.mobj, mem.offs);
+	if (!q || !ALIGNMENT_IS_OK(q, struct optee_msg_queue) ||
+	    mem.size < sizeof(*q))
+		goto err;
+
+	num_entries = READ_ONCE(q->num_entries);
+	if (!IS_POWER_OF_TWO(num_entries) ||
+	    MUL_OVERFLOW(num_entries, 2 * sizeof(q->entries[0]), &sz) ||
+	    ADD_OVERFLOW(sz, sizeof(*q), &sz) || sz > mem.size)
+		goto err;
+
+	mutex_lock(&msg_queue_mu);
+	if (msg_queue.q) {
+		mutex_unlock(&msg_queue_mu);
+		res = TEE_ERROR_BAD_STATE;
+		goto err;
+	}
+	msg_queue = (struct msg_queue){
+		.mobj = mem.mobj,
+		.attr = attr,
+		.q = q,
+		.size = mem.size,
+		.num_entries = num_entries,
+		.sq_head = READ_ONCE(q->sq_head),
+		.cq_tail = READ_ONCE(q->cq_tail),
+	};
+	mutex_unlock(&msg_queue_mu);
+
+	res = TEE_SUCCESS;
+	goto out;
+err:
+	put_arg_buf(attr, mem.mobj);
+out:
+	arg->ret = res;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	smc_args->a0 = OPTEE_SMC_RETURN_OK;
+}
+
+static void unregister_queue(struct thread_smc_args *smc_args,
+			     struct optee_msg_arg *arg, uint32_t num_params)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (num_params) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	mutex_lock(&msg_queue_mu);
+	if (!msg_queue.q) {
+		res = TEE_ERROR_BAD_STATE;
+	} else if (msg_queue.num_workers) {
+		res = TEE_ERROR_BUSY;
+	} else {
+		put_arg_buf(msg_queue.attr, msg_queue.mobj);
+		msg_queue = (struct msg_queue){ };
+	}
+	mutex_unlock(&msg_queue_mu);
+
+out:
+	arg->ret = res;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	smc_args->a0 = OPTEE_SMC_RETURN_OK;
+}
+
+/* Called with msg_queue_mu held */
+static bool pop_submission(struct optee_msg_queue_entry *e)
+{
+	struct optee_msg_queue *q = msg_queue.q;
+	uint32_t n = msg_queue.num_entries;
+	uint32_t sq_tail = READ_ONCE(q->sq_tail);
+	uint32_t cq_used = msg_queue.cq_tail - READ_ONCE(q->cq_head);
+	struct optee_msg_queue_entry *sqe = NULL;
+
+	if (sq_tail == msg_queue.sq_head)
+		return false;
+	if (sq_tail - msg_queue.sq_head > n || cq_used > n) {
+		EMSG("Corrupt message queue");
+		return false;
+	}
+	/* Keep room for the completions of the submissions in flight */
+	if (cq_used + msg_queue.in_flight >= n)
+		return false;
+
+	/* The entry is read only once its index has been observed */
+	dsb_ish();
+	sqe = q->entries + (msg_queue.sq_head & (n - 1));
+	e->arg_offs = READ_ONCE(sqe->arg_offs);
+	e->user_data = READ_ONCE(sqe->user_data);
+
+	msg_queue.sq_head++;
+	msg_queue.in_flight++;
+	atomic_store_u32(&q->sq_head, msg_queue.sq_head);
+
+	return true;
+}
+
+/* Called with msg_queue_mu held */
+static void push_completion(const struct optee_msg_queue_entry *e)
+{
+	struct optee_msg_queue *q = msg_queue.q;
+	uint32_t n = msg_queue.num_entries;
+
+	q->entries[n + (msg_queue.cq_tail & (n - 1))] = *e;
+	/* The entry must be visible before the index */
+	dsb_ish();
+
+	msg_queue.cq_tail++;
+	msg_queue.in_flight--;
+	atomic_store_u32(&q->cq_tail, msg_queue.cq_tail);
+}
+
+static void process_queue(struct thread_smc_args *smc_args,
+			  struct optee_msg_arg *arg, uint32_t num_params)
+{
+	struct optee_msg_queue_entry e = { };
+	TEE_Result res = TEE_SUCCESS;
+	struct optee_msg_queue *q = NULL;
+	uint32_t num_done = 0;
+	size_t arg_size = 0;
+	size_t size = 0;
+
+	if (num_params != 1 || READ_ONCE(arg->params[0].attr) !=
+			       OPTEE_MSG_ATTR_TYPE_VALUE_OUTPUT) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	mutex_lock(&msg_queue_mu);
+	if (!msg_queue.q) {
+		mutex_unlock(&msg_queue_mu);
+		res = TEE_ERROR_BAD_STATE;
+		goto out;
+	}
+	/* Stays registered until num_workers is back to 0 */
+	q = msg_queue.q;
+	size = msg_queue.size;
+	msg_queue.num_workers++;
+
+	while (pop_submission(&e)) {
+		mutex_unlock(&msg_queue_mu);
+		e.ret = call_embedded_arg(q, size, e.arg_offs, &arg_size);
+		mutex_lock(&msg_queue_mu);
+		push_completion(&e);
+		num_done++;
+	}
+
+	msg_queue.num_workers--;
+	mutex_unlock(&msg_queue_mu);
+
+	arg->params[0].u.value.a = num_done;
+out:
+	arg->ret = res;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	smc_args->a0 = OPTEE_SMC_RETURN_OK;
+}
+#endif /*CFG_CORE_MSG_QUEUE*/
+
 void nsec_sessions_list_head(struct tee_ta_session_head **open_sessions)
 {
 	*open_sessions = &tee_open_sessions;
@@ -544,6 +931,21 @@ void __weak tee_entry_std(struct thread_smc_args *smc_args)
 	struct optee_msg_arg *arg = NULL;
 	uint32_t num_params = 0;
 	struct mobj *mobj = NULL;
+	uint32_t cmd = 0;
+
+#ifdef CFG_CORE_INVOKE_WITH_REGS
+	/* No command buffer to map, the parameters are in the registers */
+	if (smc_args->a0 == OPTEE_SMC_CALL_INVOKE_WITH_REGS) {
+		thread_set_foreign_intr(true);
+		core_prof_pc_arm_cpu();
+		trace_ring_emit(TRACE_RING_SMC_BEGIN,
+				OPTEE_MSG_CMD_INVOKE_COMMAND);
+		entry_invoke_with_regs(smc_args);
+		trace_ring_emit(TRACE_RING_SMC_END,
+				OPTEE_MSG_CMD_INVOKE_COMMAND);
+		return;
+	}
+#endif
 
 	if (smc_args->a0 != OPTEE_SMC_CALL_WITH_ARG) {
 		EMSG("Unknown SMC 0x%" PRIx64, (uint64_t)smc_args->a0);
@@ -580,7 +982,10 @@ void __weak tee_entry_std(struct thread_smc_args *smc_args)
 
 	/* Enable foreign interrupts for STD calls */
 	thread_set_foreign_intr(true);
-	switch (arg->cmd) {
+	core_prof_pc_arm_cpu();
+	cmd = arg->cmd;
+	trace_ring_emit(TRACE_RING_SMC_BEGIN, cmd);
+	switch (cmd) {
 	case OPTEE_MSG_CMD_OPEN_SESSION:
 		entry_open_session(smc_args, arg, num_params);
 		break;
@@ -600,11 +1005,26 @@ void __weak tee_entry_std(struct thread_smc_args *smc_args)
 	case OPTEE_MSG_CMD_UNREGISTER_SHM:
 		unregister_shm(smc_args, arg, num_params);
 		break;
+#endif
+	case OPTEE_MSG_CMD_BATCH:
+		batch(smc_args, arg, num_params);
+		break;
+#ifdef CFG_CORE_MSG_QUEUE
+	case OPTEE_MSG_CMD_REGISTER_QUEUE:
+		register_queue(smc_args, arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_UNREGISTER_QUEUE:
+		unregister_queue(smc_args, arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_PROCESS_QUEUE:
+		process_queue(smc_args, arg, num_params);
+		break;
 #endif
 	default:
-		EMSG("Unknown cmd 0x%x", arg->cmd);
+		EMSG("Unknown cmd 0x%x", cmd);
 		smc_args->a0 = OPTEE_SMC_RETURN_EBADCMD;
 	}
+	trace_ring_emit(TRACE_RING_SMC_END, cmd);
 	mobj_free(mobj);
 }
 
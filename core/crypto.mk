@@ -33,6 +33,12 @@ CFG_CRYPTO_DSA ?= y
 CFG_CRYPTO_RSA ?= y
 CFG_CRYPTO_DH ?= y
 CFG_CRYPTO_ECC ?= y
+# Multiply by the P-256, P-384 and P-521 generators (key generation, ECDSA
+# signing) with a constant-time comb table built at boot, costs ~7 KiB heap
+CFG_CRYPTO_ECC_FIXED_BASE ?= y
+# Dedicated P-256 field arithmetic (fixed size limbs, Solinas reduction, no
+# heap) for ECDSA and ECDH on P-256, other curves use the generic bignums
+CFG_CRYPTO_ECC_P256 ?= y
 
 # Authenticated encryption
 CFG_CRYPTO_CCM ?= y
@@ -123,6 +129,8 @@ $(eval $(call cryp-dep-one, GCM, AES))
 $(eval $(call cryp-dep-one, AES, ECB CBC CTR CTS XTS))
 # If no DES cipher mode is left, disable DES
 $(eval $(call cryp-dep-one, DES, ECB CBC))
+$(eval $(call cryp-dep-one, ECC_FIXED_BASE, ECC))
+$(eval $(call cryp-dep-one, ECC_P256, ECC))
 
 ###############################################################
 # libtomcrypt (LTC) specifics, phase #1
@@ -148,7 +156,7 @@ core-ltc-vars += CCM
 ifeq ($(CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB),y)
 core-ltc-vars += GCM
 endif
-core-ltc-vars += RSA DSA DH ECC
+core-ltc-vars += RSA DSA DH ECC ECC_FIXED_BASE ECC_P256
 core-ltc-vars += AES_ARM64_CE AES_ARM32_CE
 core-ltc-vars += SHA1_ARM32_CE SHA1_ARM64_CE
 core-ltc-vars += SHA256_ARM32_CE SHA256_ARM64_CE
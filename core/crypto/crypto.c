@@ -11,6 +11,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <utee_defines.h>
+#include <util.h>
+
+/*
+ * Size of the tiles used by crypto_hash_copy_update(), a multiple of the
+ * block size of all supported hashes and well below the size of the L1
+ * data cache.
+ */
+#define HASH_COPY_TILE_SIZE	4096
 
 TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 {
@@ -78,6 +86,27 @@ TEE_Result crypto_hash_update(void *ctx, uint32_t algo __unused,
 	return hash_ops(ctx)->update(ctx, data, len);
 }
 
+TEE_Result crypto_hash_copy_update(void *ctx, uint32_t algo __unused,
+				   uint8_t *dst, const uint8_t *src,
+				   size_t len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t l = 0;
+
+	while (len) {
+		l = MIN(len, (size_t)HASH_COPY_TILE_SIZE);
+		memcpy(dst, src, l);
+		res = hash_ops(ctx)->update(ctx, dst, l);
+		if (res)
+			return res;
+		dst += l;
+		src += l;
+		len -= l;
+	}
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result crypto_hash_final(void *ctx, uint32_t algo __unused,
 			     uint8_t *digest, size_t len)
 {
@@ -490,6 +519,10 @@ void crypto_acipher_free_rsa_public_key(struct rsa_public_key *s __unused)
 {
 }
 
+void crypto_acipher_free_rsa_precomp(struct rsa_keypair *s __unused)
+{
+}
+
 TEE_Result crypto_acipher_gen_rsa_key(struct rsa_keypair *key __unused,
 				      size_t key_size __unused)
 {
@@ -8,12 +8,16 @@
  */
 
 #include <assert.h>
+#include <atomic.h>
 #include <crypto/crypto.h>
+#include <kernel/misc.h>
 #include <kernel/mutex.h>
 #include <kernel/refcount.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_time.h>
+#include <kernel/thread.h>
 #include <string.h>
+#include <string_ext.h>
 #include <types_ext.h>
 #include <utee_defines.h>
 #include <util.h>
@@ -26,6 +30,9 @@
 #define MIN_POOL_SIZE		64
 #define MAX_EVENT_DATA_LEN	32U
 #define RING_BUF_DATA_SIZE	4U
+#define CPU_BUF_SIZE		CFG_CORE_RNG_CPU_BUF_SIZE
+#define CPU_BUF_MAX_READ	(CPU_BUF_SIZE / 4)
+#define GEN_BUF_BLOCKS		16
 
 /*
  * struct fortuna_state - state of the Fortuna PRNG
@@ -58,6 +65,17 @@ static struct fortuna_state {
 
 static struct mutex state_mu = MUTEX_INITIALIZER;
 
+/*
+ * Counter blocks and their encryption for generate_blocks(), protected by
+ * state_mu. The buffer passed to crypto_rng_read() may be shared with
+ * normal world or with other threads of a TA so nothing that ends up
+ * there is ever read back.
+ */
+static struct {
+	uint8_t ctr[GEN_BUF_BLOCKS * BLOCK_SIZE];
+	uint8_t out[GEN_BUF_BLOCKS * BLOCK_SIZE];
+} gen_buf;
+
 static struct {
 	struct {
 		uint8_t snum;
@@ -71,6 +89,34 @@ static struct {
 
 unsigned int ring_buffer_spin_lock;
 
+#if CPU_BUF_SIZE
+/*
+ * struct cpu_buf - per-CPU buffer of random bytes
+ * @data:	Random bytes, only the first @avail bytes are unused
+ * @avail:	Number of unused bytes in @data
+ * @reads:	Number of reads served from this buffer
+ * @refills:	Number of times this buffer has been refilled
+ *
+ * The buffer is filled with output of the generator, which is rekeyed
+ * right after as for any other read. Bytes are taken from the end of the
+ * unused part and wiped as they are handed out so the buffer never holds
+ * anything that has already been returned.
+ *
+ * A buffer is only accessed by the CPU it belongs to with foreign
+ * interrupts masked, so no lock is needed.
+ */
+struct cpu_buf {
+	uint8_t data[CPU_BUF_SIZE];
+	size_t avail;
+	uint32_t reads;
+	uint32_t refills;
+};
+
+static struct cpu_buf cpu_bufs[CFG_TEE_CORE_NB_CORE];
+#endif
+
+static uint32_t direct_reads;
+
 static void inc_counter(uint64_t counter[2])
 {
 	counter[0]++;
@@ -311,30 +357,50 @@ void crypto_rng_add_event(enum crypto_rng_src sid, unsigned int *pnum,
 	}
 }
 
-/* GenerateBlocks */
+/*
+ * GenerateBlocks
+ *
+ * The successive counter values are written to gen_buf and encrypted with
+ * a single call per GEN_BUF_BLOCKS blocks so that the cipher can process
+ * several blocks at once (CTR mode keystream). Only the finished
+ * ciphertext is copied to @block.
+ */
 static TEE_Result generate_blocks(void *block, size_t nblocks)
 {
+	TEE_Result res = TEE_SUCCESS;
 	uint8_t *b = block;
-	size_t n;
+	size_t sz = 0;
+	size_t m = 0;
+	size_t n = 0;
 
-	for (n = 0; n < nblocks; n++) {
-		TEE_Result res = crypto_cipher_update(state.ctx, CIPHER_ALGO,
-						      TEE_MODE_ENCRYPT, false,
-						      (void *)state.counter,
-						      BLOCK_SIZE,
-						      b + n * BLOCK_SIZE);
+	while (nblocks) {
+		m = MIN(nblocks, (size_t)GEN_BUF_BLOCKS);
+		sz = m * BLOCK_SIZE;
 
 		/*
-		 * Make sure to increase the counter before returning an
-		 * eventual errors, we must never re-use the counter with
+		 * All counter values are consumed before the encryption so
+		 * an eventual error can't lead to re-using a counter with
 		 * the same key.
 		 */
-		inc_counter(state.counter);
+		for (n = 0; n < m; n++) {
+			memcpy(gen_buf.ctr + n * BLOCK_SIZE, state.counter,
+			       BLOCK_SIZE);
+			inc_counter(state.counter);
+		}
+
+		res = crypto_cipher_update(state.ctx, CIPHER_ALGO,
+					   TEE_MODE_ENCRYPT, false,
+					   gen_buf.ctr, sz, gen_buf.out);
 		if (res)
-			return res;
+			break;
+		memcpy(b, gen_buf.out, sz);
+		b += sz;
+		nblocks -= m;
 	}
 
-	return TEE_SUCCESS;
+	memzero_explicit(&gen_buf, sizeof(gen_buf));
+
+	return res;
 }
 
 /* GenerateRandomData */
@@ -511,10 +577,76 @@ out:
 	return res;
 }
 
+#if CPU_BUF_SIZE
+static bool read_cpu_buf(void *buf, size_t blen)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	struct cpu_buf *cb = cpu_bufs + get_core_pos();
+	bool ret = false;
+
+	if (cb->avail >= blen) {
+		cb->avail -= blen;
+		memcpy(buf, cb->data + cb->avail, blen);
+		memzero_explicit(cb->data + cb->avail, blen);
+		cb->reads++;
+		ret = true;
+	}
+
+	thread_unmask_exceptions(exceptions);
+
+	return ret;
+}
+
+static TEE_Result refill_cpu_buf(void *buf, size_t blen)
+{
+	uint8_t data[CPU_BUF_SIZE];
+	struct cpu_buf *cb = NULL;
+	uint32_t exceptions = 0;
+	TEE_Result res = TEE_SUCCESS;
+
+	res = fortuna_read(data, sizeof(data));
+	if (res)
+		return res;
+
+	/*
+	 * We may have been moved to another CPU while generating, whatever
+	 * is left in the buffer of the current CPU is less than what we're
+	 * about to put there so it's simply replaced.
+	 */
+	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	cb = cpu_bufs + get_core_pos();
+	cb->avail = sizeof(data) - blen;
+	memcpy(cb->data, data, cb->avail);
+	memzero_explicit(cb->data + cb->avail, blen);
+	cb->reads++;
+	cb->refills++;
+	thread_unmask_exceptions(exceptions);
+
+	memcpy(buf, data + sizeof(data) - blen, blen);
+	memzero_explicit(data, sizeof(data));
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result buffered_read(void *buf, size_t blen)
+{
+	if (read_cpu_buf(buf, blen))
+		return TEE_SUCCESS;
+	return refill_cpu_buf(buf, blen);
+}
+#endif
+
 TEE_Result crypto_rng_read(void *buf, size_t blen)
 {
 	size_t offs = 0;
 
+#if CPU_BUF_SIZE
+	if (blen && blen <= CPU_BUF_MAX_READ)
+		return buffered_read(buf, blen);
+#endif
+
+	atomic_inc32(&direct_reads);
+
 	while (true) {
 		TEE_Result res;
 		size_t n;
@@ -529,3 +661,18 @@ TEE_Result crypto_rng_read(void *buf, size_t blen)
 		offs += n;
 	}
 }
+
+void crypto_rng_get_stats(struct crypto_rng_stats *stats)
+{
+	size_t __maybe_unused n = 0;
+
+	memset(stats, 0, sizeof(*stats));
+#if CPU_BUF_SIZE
+	for (n = 0; n < ARRAY_SIZE(cpu_bufs); n++) {
+		stats->buf_reads += cpu_bufs[n].reads;
+		stats->buf_refills += cpu_bufs[n].refills;
+	}
+#endif
+	stats->direct_reads = direct_reads;
+	stats->reseeds = state.reseed_count;
+}
@@ -213,6 +213,7 @@ void gic_init_base_addr(struct gic_data *gd, vaddr_t gicc_base __maybe_unused,
 	gd->gicd_base = gicd_base;
 	gd->max_it = probe_max_it(gicc_base, gicd_base);
 	gd->chip.ops = &gic_ops;
+	gd->chip.num_it = gd->max_it;
 }
 
 static void gic_it_add(struct gic_data *gd, size_t it)
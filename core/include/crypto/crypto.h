@@ -33,6 +33,15 @@ TEE_Result crypto_hash_update(void *ctx, uint32_t algo, const uint8_t *data,
 			      size_t len);
 TEE_Result crypto_hash_final(void *ctx, uint32_t algo, uint8_t *digest,
 			     size_t len);
+/*
+ * Copies @len bytes from @src to @dst and updates the hash with the copy.
+ * The data is processed in tiles small enough to still be in the data
+ * cache when hashed, so @src is only read once from memory. Since the
+ * hash is computed over @dst, a @src in non-secure memory which is
+ * modified during the copy can't make the hash and the copy differ.
+ */
+TEE_Result crypto_hash_copy_update(void *ctx, uint32_t algo, uint8_t *dst,
+				   const uint8_t *src, size_t len);
 void crypto_hash_free_ctx(void *ctx, uint32_t algo);
 void crypto_hash_copy_state(void *dst_ctx, void *src_ctx, uint32_t algo);
 
@@ -120,6 +129,13 @@ struct rsa_keypair {
 	struct bignum *qp;	/* 1/q mod p */
 	struct bignum *dp;	/* d mod (p-1) */
 	struct bignum *dq;	/* d mod (q-1) */
+
+	/*
+	 * Values derived from the key by the crypto library on first use
+	 * and kept for the lifetime of the key, NULL if none. Released with
+	 * crypto_acipher_free_rsa_precomp().
+	 */
+	void *precomp;
 };
 
 struct rsa_public_key {
@@ -179,6 +195,7 @@ TEE_Result crypto_acipher_alloc_rsa_keypair(struct rsa_keypair *s,
 TEE_Result crypto_acipher_alloc_rsa_public_key(struct rsa_public_key *s,
 				   size_t key_size_bits);
 void crypto_acipher_free_rsa_public_key(struct rsa_public_key *s);
+void crypto_acipher_free_rsa_precomp(struct rsa_keypair *s);
 TEE_Result crypto_acipher_alloc_dsa_keypair(struct dsa_keypair *s,
 				size_t key_size_bits);
 TEE_Result crypto_acipher_alloc_dsa_public_key(struct dsa_public_key *s,
@@ -316,6 +333,28 @@ void crypto_rng_add_event(enum crypto_rng_src sid, unsigned int *pnum,
  */
 TEE_Result crypto_rng_read(void *buf, size_t len);
 
+/*
+ * struct crypto_rng_stats - RNG statistics
+ * @buf_reads:		Reads served from the per-CPU buffers
+ * @buf_refills:	Per-CPU buffer refills from the generator
+ * @direct_reads:	Reads served by the generator directly
+ * @reseeds:		Number of reseeds of the generator
+ */
+struct crypto_rng_stats {
+	uint32_t buf_reads;
+	uint32_t buf_refills;
+	uint32_t direct_reads;
+	uint32_t reseeds;
+};
+
+/*
+ * crypto_rng_get_stats() - get RNG statistics
+ * @stats:	Filled in with the statistics accumulated since boot
+ *
+ * Only implemented by the software PRNG, CFG_WITH_SOFTWARE_PRNG=y.
+ */
+void crypto_rng_get_stats(struct crypto_rng_stats *stats);
+
 /*
  * crypto_aes_expand_enc_key() - Expand an AES key
  * @key:	AES key buffer
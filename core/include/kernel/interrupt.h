@@ -10,8 +10,15 @@
 
 #define ITRF_TRIGGER_LEVEL	(1 << 0)
 
+/*
+ * struct itr_chip - interrupt controller
+ * @ops:	Operations of the controller
+ * @num_it:	Number of interrupt lines, the interrupt IDs are in the
+ *		range [0, @num_it)
+ */
 struct itr_chip {
 	const struct itr_ops *ops;
+	size_t num_it;
 };
 
 struct itr_ops {
@@ -41,6 +48,11 @@ struct itr_handler {
 void itr_init(struct itr_chip *data);
 void itr_handle(size_t it);
 
+/*
+ * Several handlers may be added for the same interrupt (shared line), they
+ * are all called when the interrupt is raised. The interrupt is disabled
+ * if none of them returns ITRR_HANDLED.
+ */
 void itr_add(struct itr_handler *handler);
 void itr_enable(size_t it);
 void itr_disable(size_t it);
@@ -57,4 +69,28 @@ void itr_raise_sgi(size_t it, uint8_t cpu_mask);
  */
 void itr_set_affinity(size_t it, uint8_t cpu_mask);
 
+/*
+ * struct itr_stats - statistics of one interrupt line
+ * @it:			Interrupt ID
+ * @count:		Number of times the interrupt has been handled
+ * @max_time_us:	Longest time spent in the handlers, in microseconds
+ */
+struct itr_stats {
+	uint32_t it;
+	uint32_t count;
+	uint32_t max_time_us;
+};
+
+/*
+ * itr_get_stats() - get statistics of the interrupt lines with handlers
+ * @stats:	Array of @num_stats elements to fill in, may be NULL if
+ *		@num_stats is 0
+ * @num_stats:	Number of elements in @stats
+ * @reset:	If true the statistics are reset once read
+ *
+ * Returns the number of interrupt lines with handlers, which may be larger
+ * than @num_stats in which case only the first @num_stats are reported.
+ */
+size_t itr_get_stats(struct itr_stats *stats, size_t num_stats, bool reset);
+
 #endif /*__KERNEL_INTERRUPT_H*/
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2019, agent
+ */
+#ifndef __KERNEL_LOCK_STAT_H
+#define __KERNEL_LOCK_STAT_H
+
+#include <compiler.h>
+#include <stdbool.h>
+#include <types_ext.h>
+
+#define LOCK_STAT_TYPE_MUTEX	0
+#define LOCK_STAT_TYPE_SPINLOCK	1
+
+#define LOCK_STAT_SITE_LEN	48
+
+/*
+ * struct lock_stat - contention statistics of one lock site
+ * @lock_va:		Address of the lock
+ * @type:		LOCK_STAT_TYPE_*
+ * @acquired:		Number of times the lock has been acquired
+ * @contended:		Number of acquisitions which had to wait
+ * @held:		Number of exclusive acquisitions whose hold time has
+ *			been measured, read locks are not included
+ * @wait_total_ns:	Total time spent waiting for the lock
+ * @wait_max_ns:	Longest time spent waiting for the lock
+ * @hold_total_ns:	Total time the lock has been held
+ * @hold_max_ns:	Longest time the lock has been held
+ * @site:		"file:line" where the lock was acquired, empty for
+ *			spinlocks which are only identified by @lock_va
+ */
+struct lock_stat {
+	uint64_t lock_va;
+	uint32_t type;
+	uint32_t acquired;
+	uint32_t contended;
+	uint32_t held;
+	uint64_t wait_total_ns;
+	uint64_t wait_max_ns;
+	uint64_t hold_total_ns;
+	uint64_t hold_max_ns;
+	char site[LOCK_STAT_SITE_LEN];
+};
+
+struct mutex;
+
+#ifdef CFG_LOCK_STAT
+/* Counter value to pass as @wait_start when a lock had to be waited for */
+uint64_t lock_stat_timestamp(void);
+
+/*
+ * lock_stat_mutex_acquired() - record the acquisition of a mutex
+ * @m:		The mutex
+ * @fname:	File name of the call site
+ * @lineno:	Line number of the call site
+ * @wait_start:	lock_stat_timestamp() when the wait started or 0 if the
+ *		mutex was acquired without waiting
+ * @write:	True if @m was write locked, its hold time is then measured
+ *		until lock_stat_mutex_released()
+ */
+void lock_stat_mutex_acquired(struct mutex *m, const char *fname, int lineno,
+			      uint64_t wait_start, bool write);
+void lock_stat_mutex_released(struct mutex *m);
+
+void lock_stat_spin_acquired(unsigned int *lock, uint64_t wait_start);
+void lock_stat_spin_released(unsigned int *lock);
+
+/*
+ * lock_stat_get() - get the statistics of the recorded lock sites
+ * @stats:	Array of @num_stats elements to fill in, may be NULL if
+ *		@num_stats is 0
+ * @num_stats:	Number of elements in @stats
+ * @reset:	If true the statistics are reset once read
+ *
+ * Returns the number of recorded lock sites, which may be larger than
+ * @num_stats in which case only the first @num_stats are reported.
+ */
+size_t lock_stat_get(struct lock_stat *stats, size_t num_stats, bool reset);
+#else
+static inline uint64_t lock_stat_timestamp(void)
+{
+	return 0;
+}
+
+static inline void lock_stat_mutex_acquired(struct mutex *m __unused,
+					    const char *fname __unused,
+					    int lineno __unused,
+					    uint64_t wait_start __unused,
+					    bool write __unused)
+{
+}
+
+static inline void lock_stat_mutex_released(struct mutex *m __unused)
+{
+}
+
+static inline void lock_stat_spin_acquired(unsigned int *lock __unused,
+					   uint64_t wait_start __unused)
+{
+}
+
+static inline void lock_stat_spin_released(unsigned int *lock __unused)
+{
+}
+#endif
+
+#endif /*__KERNEL_LOCK_STAT_H*/
@@ -86,12 +86,20 @@ struct tee_ta_ctx {
 	uint32_t ref_count;	/* Reference counter for multi session TA */
 	bool busy;		/* Context is busy and cannot be entered */
 	bool initializing;	/* Context is initializing */
+	bool dying;		/* Context panicked and is being destroyed */
+	/* Number of threads in a TA_FLAG_CONCURRENT context */
+	unsigned int num_entered;
+	/* Protects busy, initializing, dying and num_entered */
+	struct mutex busy_mu;
 	struct condvar busy_cv;	/* CV used when context is busy */
 };
 
 struct tee_ta_session {
 	TAILQ_ENTRY(tee_ta_session) link;
 	TAILQ_ENTRY(tee_ta_session) link_tsd;
+	LIST_ENTRY(tee_ta_session) link_hash;
+	/* Session list holding the session, part of the lookup key */
+	struct tee_ta_session_head *open_sessions;
 	uint32_t id;		/* Session handle (0 is invalid) */
 	struct tee_ta_ctx *ctx;	/* TA context */
 	TEE_Identity clnt_id;	/* Identify of client */
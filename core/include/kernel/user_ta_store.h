@@ -49,6 +49,12 @@ struct user_ta_store_ops {
 	 * Close a TA handle. Do nothing if @h == NULL.
 	 */
 	void (*close)(struct user_ta_store_handle *h);
+	/*
+	 * Optional, hint that the TAs in @uuids are about to be opened.
+	 * The store may start fetching them in the background. Errors
+	 * are ignored by the caller.
+	 */
+	TEE_Result (*prefetch)(const TEE_UUID *uuids, size_t num_uuids);
 };
 
 #endif /*__KERNEL_USER_TA_STORE_H*/
@@ -89,11 +89,115 @@ struct file *file_get_by_tag(const uint8_t *tag, unsigned int taglen);
  * @f:		File pointer
  *
  * If reference counter reaches 0, matching the numbers of file_new() +
- * file_get() + file_get_by_tag(), the file is removed with reference
- * counters for all contained fobjs decreased.
+ * file_get() + file_get_by_tag(), the file is either kept in the file
+ * cache, to be found again by file_get_by_tag(), or removed with
+ * reference counters for all contained fobjs decreased.
  */
 void file_put(struct file *f);
 
+/*
+ * file_get_tag() - Get the tag of a file
+ * @f:		File pointer
+ * @taglen:	Returned length of the tag
+ *
+ * Returns a pointer to the tag, valid as long as the file is referenced.
+ */
+const uint8_t *file_get_tag(struct file *f, unsigned int *taglen);
+
+/*
+ * file_add_reloc() - Save a relocated writable segment of a file
+ * @f:		File pointer
+ * @key:	FILE_TAG_SIZE bytes identifying the relocation, it must cover
+ *		the load address of @f and everything symbols of @f may be
+ *		resolved against
+ * @va:		Address the segment is relocated for
+ * @data:	Relocated content of the segment
+ * @size:	Size of the segment, a multiple of SMALL_PAGE_SIZE
+ *
+ * File must be in locked state. A limited number of segments is kept per
+ * file, the oldest one is dropped when needed.
+ *
+ * Returns TEE_SUCCESS on success or a TEE_ERROR_* code on failure.
+ */
+TEE_Result file_add_reloc(struct file *f, const uint8_t *key, vaddr_t va,
+			  const void *data, size_t size);
+
+/*
+ * file_find_reloc() - Find a relocated writable segment of a file
+ * @f:		File pointer
+ * @key:	Key supplied to file_add_reloc()
+ * @va:		Address supplied to file_add_reloc()
+ * @size:	Size supplied to file_add_reloc()
+ *
+ * File must be in locked state.
+ *
+ * Returns a pointer to the relocated content, valid until the file is
+ * unlocked, or NULL if not found.
+ */
+const void *file_find_reloc(struct file *f, const uint8_t *key, vaddr_t va,
+			    size_t size);
+
+/*
+ * file_set_verified() - Mark the file content as verified
+ * @f:		File pointer
+ *
+ * File must be in locked state.
+ *
+ * Called when a load of the file has completed with the digest of the
+ * file checked. Only verified files are kept in the file cache.
+ */
+void file_set_verified(struct file *f);
+
+/*
+ * file_is_populated() - Check if a file has any slices
+ * @f:		File pointer
+ *
+ * File must be in locked state.
+ *
+ * Returns true if at least one slice has been added to the file.
+ */
+bool file_is_populated(struct file *f);
+
+/*
+ * struct file_cache_stats - statistics of the file cache
+ * @cold_loads:		Number of loads of files without slices
+ * @warm_loads:		Number of loads of files with slices
+ * @cold_load_ms:	Accumulated time of the cold loads
+ * @warm_load_ms:	Accumulated time of the warm loads
+ * @evictions:		Number of files evicted from the cache
+ * @cached_bytes:	Size of the slices currently held by the cache
+ */
+struct file_cache_stats {
+	uint32_t cold_loads;
+	uint32_t warm_loads;
+	uint64_t cold_load_ms;
+	uint64_t warm_load_ms;
+	uint32_t evictions;
+	size_t cached_bytes;
+};
+
+/*
+ * file_cache_evict() - Remove the least recently used file from the cache
+ *
+ * Used to release memory when an allocation of TA memory fails.
+ *
+ * Returns true if a file was evicted or false if the cache is empty.
+ */
+bool file_cache_evict(void);
+
+/*
+ * file_cache_add_load_time() - Record the time it took to load a file
+ * @warm:	True if the file was populated already when opened
+ * @ms:		Load time in milliseconds
+ */
+void file_cache_add_load_time(bool warm, uint32_t ms);
+
+/*
+ * file_cache_get_stats() - Get statistics of the file cache
+ * @stats:	Returned statistics
+ */
+void file_cache_get_stats(struct file_cache_stats *stats);
+
 /*
  * file_find_slice() - Find a slice covering the @page_offset
  * @f:		 File pointer
@@ -7,7 +7,19 @@
 
 #include <tee_api_types.h>
 #include <kernel/tee_ta_manager.h>
+#include <kernel/thread.h>
 #include <kernel/user_ta.h>
+#include <mm/tee_mmu_types.h>
+
+/*
+ * Returns true if @r holds the parameters of a call made by another thread
+ * to a TA executing sessions concurrently. Such a region isn't mapped for
+ * the current thread.
+ */
+static inline bool tee_mmu_is_foreign_region(const struct vm_region *r)
+{
+	return (r->attr & TEE_MATTR_EPHEMERAL) && r->owner != thread_get_id();
+}
 
 /*-----------------------------------------------------------------------------
  * Allocate context resources like ASID and MMU table information
@@ -78,13 +90,13 @@ void tee_mmu_rem_rwmem(struct user_ta_ctx *utc, struct mobj *mobj, vaddr_t va);
  * parameters. These later are considered outside TA private memory as it
  * might be accessed by the TA and its client(s).
  */
-bool tee_mmu_is_vbuf_inside_ta_private(const struct user_ta_ctx *utc,
+bool tee_mmu_is_vbuf_inside_ta_private(struct user_ta_ctx *utc,
 				       const void *va, size_t size);
 
-bool tee_mmu_is_vbuf_intersect_ta_private(const struct user_ta_ctx *utc,
+bool tee_mmu_is_vbuf_intersect_ta_private(struct user_ta_ctx *utc,
 					  const void *va, size_t size);
 
-TEE_Result tee_mmu_vbuf_to_mobj_offs(const struct user_ta_ctx *utc,
+TEE_Result tee_mmu_vbuf_to_mobj_offs(struct user_ta_ctx *utc,
 				     const void *va, size_t size,
 				     struct mobj **mobj, size_t *offs);
 
@@ -93,7 +105,7 @@ TEE_Result tee_mmu_vbuf_to_mobj_offs(const struct user_ta_ctx *utc,
  * given the user context.
  * Interface is deprecated, use virt_to_phys() instead.
  *---------------------------------------------------------------------------*/
-TEE_Result tee_mmu_user_va2pa_helper(const struct user_ta_ctx *utc, void *ua,
+TEE_Result tee_mmu_user_va2pa_helper(struct user_ta_ctx *utc, void *ua,
 				     paddr_t *pa);
 
 /*-----------------------------------------------------------------------------
@@ -101,13 +113,13 @@ TEE_Result tee_mmu_user_va2pa_helper(const struct user_ta_ctx *utc, void *ua,
  * given the user context.
  * Interface is deprecated, use phys_to_virt() instead.
  *---------------------------------------------------------------------------*/
-TEE_Result tee_mmu_user_pa2va_helper(const struct user_ta_ctx *utc,
+TEE_Result tee_mmu_user_pa2va_helper(struct user_ta_ctx *utc,
 				     paddr_t pa, void **va);
 
 /*-----------------------------------------------------------------------------
  * tee_mmu_check_access_rights -
  *---------------------------------------------------------------------------*/
-TEE_Result tee_mmu_check_access_rights(const struct user_ta_ctx *utc,
+TEE_Result tee_mmu_check_access_rights(struct user_ta_ctx *utc,
 				       uint32_t flags, uaddr_t uaddr,
 				       size_t len);
 
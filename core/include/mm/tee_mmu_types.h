@@ -79,6 +79,7 @@ struct vm_region {
 	vaddr_t va;
 	size_t size;
 	uint32_t attr; /* TEE_MATTR_* above */
+	int owner; /* Thread ID which added a TEE_MATTR_EPHEMERAL region */
 	TAILQ_ENTRY(vm_region) link;
 };
 
@@ -210,6 +210,50 @@ struct optee_msg_arg {
 	((OPTEE_MSG_NONCONTIG_PAGE_SIZE - sizeof(struct optee_msg_arg)) / \
 	 sizeof(struct optee_msg_param))
 
+/**
+ * struct optee_msg_queue_entry - entry of a message queue
+ * @arg_offs:	Offset of a struct optee_msg_arg in the queue buffer
+ * @user_data:	Opaque value of normal world, copied to the completion
+ * @ret:	Completions only: TEE_SUCCESS if the struct optee_msg_arg
+ *		was processed, its ret field holds the result of the
+ *		command, else the reason it could not be read
+ * @pad:	Unused
+ */
+struct optee_msg_queue_entry {
+	uint64_t arg_offs;
+	uint64_t user_data;
+	uint32_t ret;
+	uint32_t pad;
+};
+
+/**
+ * struct optee_msg_queue - header of a message queue buffer
+ * @num_entries: Number of entries of each ring, a power of 2
+ * @sq_head:	Submissions consumed by secure world
+ * @sq_tail:	Submissions posted by normal world
+ * @cq_head:	Completions consumed by normal world
+ * @cq_tail:	Completions posted by secure world
+ * @pad:	Unused
+ * @entries:	The submission ring followed by the completion ring
+ *
+ * The indexes are free running, entry i of a ring is at i modulo
+ * num_entries. Each index is only written by its owner, the other side
+ * only reads it. The buffer also holds the struct optee_msg_arg, each
+ * of them 8 bytes aligned, referenced by the submissions.
+ *
+ * Normal world must not have more than num_entries submissions whose
+ * completions it has not yet consumed.
+ */
+struct optee_msg_queue {
+	uint32_t num_entries;
+	uint32_t sq_head;
+	uint32_t sq_tail;
+	uint32_t cq_head;
+	uint32_t cq_tail;
+	uint32_t pad;
+	struct optee_msg_queue_entry entries[];
+};
+
 #endif /*ASM*/
 
 /*****************************************************************************
@@ -299,6 +343,42 @@ struct optee_msg_arg {
  * [in] param[0].u.rmem.shm_ref		holds shared memory reference
  * [in] param[0].u.rmem.offs		0
  * [in] param[0].u.rmem.size		0
+ *
+ * OPTEE_MSG_CMD_REGISTER_QUEUE registers a struct optee_msg_queue buffer.
+ * Only one queue can be registered at a time. The buffer is passed as:
+ * [in] param[0].attr			OPTEE_MSG_ATTR_TYPE_TMEM_INOUT or
+ *					OPTEE_MSG_ATTR_TYPE_RMEM_INOUT
+ * [in] param[0].u.tmem or .rmem	the queue buffer, the tmem has to
+ *					be in the reserved shared memory
+ *
+ * OPTEE_MSG_CMD_UNREGISTER_QUEUE unregisters the queue, it fails with
+ * TEE_ERROR_BUSY while an OPTEE_MSG_CMD_PROCESS_QUEUE is in progress.
+ *
+ * OPTEE_MSG_CMD_PROCESS_QUEUE processes the posted submissions, posting
+ * a completion for each. The commands of the submissions are restricted
+ * as for OPTEE_MSG_CMD_BATCH below. It returns once the submission ring
+ * is empty or the completion ring full. Several can run concurrently,
+ * each on its own thread. Normal world should issue one after posting
+ * submissions, a call which finds nothing to process returns at once.
+ * [out] param[0].attr			OPTEE_MSG_ATTR_TYPE_VALUE_OUTPUT
+ * [out] param[0].u.value.a		number of completions posted
+ *
+ * OPTEE_MSG_CMD_BATCH processes several commands in one call. Each is a
+ * struct optee_msg_arg with its parameters, packed one after the other in
+ * a buffer, and gets its own ret and ret_origin. Only
+ * OPTEE_MSG_CMD_OPEN_SESSION, OPTEE_MSG_CMD_INVOKE_COMMAND,
+ * OPTEE_MSG_CMD_CLOSE_SESSION and OPTEE_MSG_CMD_CANCEL can be batched.
+ * Shared memory registration isn't allowed since unregistering the
+ * shared memory holding the batch, or the queue, would deadlock. The
+ * commands are processed in order, stopping at the first one which can't
+ * be read or isn't allowed.
+ * [in] param[0].attr			OPTEE_MSG_ATTR_TYPE_TMEM_INOUT or
+ *					OPTEE_MSG_ATTR_TYPE_RMEM_INOUT
+ * [in] param[0].u.tmem or .rmem	the buffer, the tmem has to be in the
+ *					reserved shared memory
+ * [in] param[1].attr			OPTEE_MSG_ATTR_TYPE_VALUE_INOUT
+ * [in] param[1].u.value.a		number of commands in the buffer
+ * [out] param[1].u.value.a		number of commands processed
  */
 #define OPTEE_MSG_CMD_OPEN_SESSION	0
 #define OPTEE_MSG_CMD_INVOKE_COMMAND	1
@@ -306,6 +386,10 @@ struct optee_msg_arg {
 #define OPTEE_MSG_CMD_CANCEL		3
 #define OPTEE_MSG_CMD_REGISTER_SHM	4
 #define OPTEE_MSG_CMD_UNREGISTER_SHM	5
+#define OPTEE_MSG_CMD_REGISTER_QUEUE	6
+#define OPTEE_MSG_CMD_UNREGISTER_QUEUE	7
+#define OPTEE_MSG_CMD_PROCESS_QUEUE	8
+#define OPTEE_MSG_CMD_BATCH		9
 #define OPTEE_MSG_FUNCID_CALL_WITH_ARG	0x0004
 
 #endif /* _OPTEE_MSG_H */
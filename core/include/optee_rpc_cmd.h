@@ -24,6 +24,13 @@
  *
  * [in]     value[0].a-b    UUID
  * [out]    memref[1]	    Buffer with TA
+ *
+ * A TA can also be loaded in chunks by supplying a third parameter, the
+ * buffer is then filled with the part of the TA starting at the offset.
+ *
+ * [in]     value[0].a-b    UUID
+ * [out]    memref[1]	    Buffer with chunk of TA
+ * [in]     value[2].a	    Offset into the TA of the chunk
  */
 #define OPTEE_RPC_CMD_LOAD_TA		0
 
@@ -144,6 +151,19 @@
  */
 #define OPTEE_RPC_CMD_GENERIC		12
 
+/*
+ * Prefetch TAs
+ *
+ * Hint that the TAs in the list are about to be loaded with
+ * OPTEE_RPC_CMD_LOAD_TA. tee-supplicant may start reading them
+ * concurrently in the background and return immediately, the following
+ * loads are then served from memory. The result is ignored by secure
+ * world.
+ *
+ * [in]     memref[0]	    Array of UUIDs, 16 bytes each in octet form
+ */
+#define OPTEE_RPC_CMD_PREFETCH_TA	13
+
 /*
  * Register timestamp buffer in the linux kernel optee driver
  *
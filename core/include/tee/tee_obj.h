@@ -8,6 +8,7 @@
 
 #include <tee_api_types.h>
 #include <kernel/tee_ta_manager.h>
+#include <kernel/user_ta.h>
 #include <sys/queue.h>
 
 #define TEE_USAGE_DEFAULT   0xffffffff
@@ -22,6 +23,7 @@ struct tee_obj {
 	struct tee_pobj *pobj;	/* ptr to persistant object */
 	struct tee_file_handle *fh;
 	uint32_t flags;		/* permission flags for persistent objects */
+	struct user_ta_claim claim;
 };
 
 void tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o);
@@ -51,6 +51,8 @@ TEE_Result syscall_get_property_name_to_index(unsigned long prop_set,
 					      void *name,
 					      unsigned long name_len,
 					      uint32_t *index);
+TEE_Result syscall_get_property_set(unsigned long prop_set, void *buf,
+				    uint32_t *blen);
 
 TEE_Result syscall_open_ta_session(const TEE_UUID *dest,
 			unsigned long cancel_req_to, struct utee_params *params,
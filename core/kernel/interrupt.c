@@ -3,7 +3,10 @@
  * Copyright (c) 2016, Linaro Limited
  */
 
+#include <arm.h>
 #include <kernel/interrupt.h>
+#include <kernel/panic.h>
+#include <stdlib.h>
 #include <trace.h>
 
 /*
@@ -14,35 +17,86 @@
  * we begin to modify settings after boot initialization.
  */
 
+/*
+ * The interrupt lines are looked up in a two level table indexed with the
+ * interrupt ID. The first level has one entry per group of
+ * LINES_PER_GROUP lines, the second level is only allocated for groups
+ * where at least one handler has been added.
+ */
+#define LINES_PER_GROUP		32
+
+/*
+ * struct itr_line - an interrupt line
+ * @handlers:	Handlers added for this line
+ * @count:	Number of times the interrupt has been handled
+ * @max_time:	Longest time spent in the handlers, in counter ticks
+ *
+ * @count and @max_time are updated without locking, an SPI is only
+ * delivered to one CPU at a time but concurrent delivery of an SGI or PPI
+ * may occasionally lose an update.
+ */
+struct itr_line {
+	SLIST_HEAD(, itr_handler) handlers;
+	uint32_t count;
+	uint64_t max_time;
+};
+
 static struct itr_chip *itr_chip;
-static SLIST_HEAD(, itr_handler) handlers = SLIST_HEAD_INITIALIZER(handlers);
+static struct itr_line **itr_lines;
+static size_t itr_num_groups;
 
 void itr_init(struct itr_chip *chip)
 {
+	if (!chip->num_it)
+		panic();
+
+	itr_num_groups = ROUNDUP(chip->num_it, LINES_PER_GROUP) /
+			 LINES_PER_GROUP;
+	itr_lines = calloc(itr_num_groups, sizeof(*itr_lines));
+	if (!itr_lines)
+		panic();
+
 	itr_chip = chip;
 }
 
-static struct itr_handler *find_handler(size_t it)
+static struct itr_line *find_line(size_t it)
 {
-	struct itr_handler *h;
+	struct itr_line *group = NULL;
+
+	if (it >= itr_chip->num_it)
+		return NULL;
+
+	group = itr_lines[it / LINES_PER_GROUP];
+	if (!group)
+		return NULL;
 
-	SLIST_FOREACH(h, &handlers, link)
-		if (h->it == it)
-			return h;
-	return NULL;
+	return group + it % LINES_PER_GROUP;
 }
 
 void itr_handle(size_t it)
 {
-	struct itr_handler *h = find_handler(it);
+	struct itr_line *line = find_line(it);
+	enum itr_return ret = ITRR_NONE;
+	struct itr_handler *h = NULL;
+	uint64_t t = 0;
 
-	if (!h) {
+	if (!line || SLIST_EMPTY(&line->handlers)) {
 		EMSG("Disabling unhandled interrupt %zu", it);
 		itr_chip->ops->disable(itr_chip, it);
 		return;
 	}
 
-	if (h->handler(h) != ITRR_HANDLED) {
+	t = read_cntpct();
+	SLIST_FOREACH(h, &line->handlers, link)
+		if (h->handler(h) == ITRR_HANDLED)
+			ret = ITRR_HANDLED;
+	t = read_cntpct() - t;
+
+	line->count++;
+	if (t > line->max_time)
+		line->max_time = t;
+
+	if (ret != ITRR_HANDLED) {
 		EMSG("Disabling interrupt %zu not handled by handler", it);
 		itr_chip->ops->disable(itr_chip, it);
 	}
@@ -50,8 +104,30 @@ void itr_handle(size_t it)
 
 void itr_add(struct itr_handler *h)
 {
-	itr_chip->ops->add(itr_chip, h->it, h->flags);
-	SLIST_INSERT_HEAD(&handlers, h, link);
+	struct itr_line **group = NULL;
+	struct itr_line *line = NULL;
+	struct itr_handler *lh = NULL;
+
+	if (h->it >= itr_chip->num_it)
+		panic();
+
+	group = itr_lines + h->it / LINES_PER_GROUP;
+	if (!*group) {
+		*group = calloc(LINES_PER_GROUP, sizeof(**group));
+		if (!*group)
+			panic();
+	}
+	line = *group + h->it % LINES_PER_GROUP;
+
+	/* Adding an already added handler again is a no-op */
+	SLIST_FOREACH(lh, &line->handlers, link)
+		if (lh == h)
+			return;
+
+	/* The line is only configured when the first handler is added */
+	if (SLIST_EMPTY(&line->handlers))
+		itr_chip->ops->add(itr_chip, h->it, h->flags);
+	SLIST_INSERT_HEAD(&line->handlers, h, link);
 }
 
 void itr_enable(size_t it)
@@ -78,3 +154,40 @@ void itr_set_affinity(size_t it, uint8_t cpu_mask)
 {
 	itr_chip->ops->set_affinity(itr_chip, it, cpu_mask);
 }
+
+size_t itr_get_stats(struct itr_stats *stats, size_t num_stats, bool reset)
+{
+	uint64_t freq = read_cntfrq();
+	struct itr_line *line = NULL;
+	size_t count = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	if (!freq)
+		freq = 1;
+
+	for (n = 0; n < itr_num_groups; n++) {
+		if (!itr_lines[n])
+			continue;
+
+		for (m = 0; m < LINES_PER_GROUP; m++) {
+			line = itr_lines[n] + m;
+			if (SLIST_EMPTY(&line->handlers))
+				continue;
+
+			if (count < num_stats) {
+				stats[count].it = n * LINES_PER_GROUP + m;
+				stats[count].count = line->count;
+				stats[count].max_time_us = (line->max_time *
+							    1000000) / freq;
+			}
+			if (reset) {
+				line->count = 0;
+				line->max_time = 0;
+			}
+			count++;
+		}
+	}
+
+	return count;
+}
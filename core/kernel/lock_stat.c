@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2019, agent
+ */
+
+#include <arm.h>
+#include <kernel/lock_stat.h>
+#include <kernel/misc.h>
+#include <kernel/mutex.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <stdio.h>
+#include <string.h>
+#include <trace.h>
+#include <util.h>
+
+/*
+ * Lock sites are recorded in a fixed size open addressing hash table
+ * indexed by the lock and, for mutexes, the call site. Entries are never
+ * removed, so a mutex may keep a pointer to the entry of its current
+ * write lock until it's released.
+ *
+ * The table is protected by a raw spinlock taken with all exceptions
+ * masked, since the recording is itself done on spinlock acquisition
+ * nothing in here may take an instrumented lock or print.
+ */
+struct lock_stat_site {
+	const void *lock;
+	const char *fname;
+	int lineno;
+	uint32_t type;
+	uint32_t acquired;
+	uint32_t contended;
+	uint32_t held;
+	uint64_t wait_total;
+	uint64_t wait_max;
+	uint64_t hold_total;
+	uint64_t hold_max;
+};
+
+/*
+ * Spinlocks have no room for the time they were acquired, it's kept in
+ * a small per-CPU stack instead. A spinlock holder can't be rescheduled
+ * on another CPU since foreign interrupts are masked.
+ */
+#define MAX_HELD_SPINLOCKS	4
+
+struct held_spinlock {
+	unsigned int *lock;
+	struct lock_stat_site *site;
+	uint64_t ts;
+};
+
+static struct lock_stat_site sites[CFG_LOCK_STAT_ENTRIES];
+static unsigned int sites_lock = SPINLOCK_UNLOCK;
+static uint32_t num_lost;
+
+static struct held_spinlock held[CFG_TEE_CORE_NB_CORE][MAX_HELD_SPINLOCKS];
+static size_t num_held[CFG_TEE_CORE_NB_CORE];
+
+uint64_t lock_stat_timestamp(void)
+{
+	return read_cntpct();
+}
+
+static uint32_t lock_sites(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+
+	__cpu_spin_lock(&sites_lock);
+	return exceptions;
+}
+
+static void unlock_sites(uint32_t exceptions)
+{
+	__cpu_spin_unlock(&sites_lock);
+	thread_unmask_exceptions(exceptions);
+}
+
+/* Called with sites_lock held */
+static struct lock_stat_site *get_site(const void *lock, const char *fname,
+				       int lineno, uint32_t type)
+{
+	size_t h = ((vaddr_t)lock >> 2) + (vaddr_t)fname + lineno;
+	struct lock_stat_site *s = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(sites); n++) {
+		s = sites + (h + n) % ARRAY_SIZE(sites);
+		if (!s->lock) {
+			s->lock = lock;
+			s->fname = fname;
+			s->lineno = lineno;
+			s->type = type;
+			return s;
+		}
+		if (s->lock == lock && s->fname == fname &&
+		    s->lineno == lineno)
+			return s;
+	}
+
+	num_lost++;
+	return NULL;
+}
+
+/* Called with sites_lock held */
+static void add_acquired(struct lock_stat_site *s, uint64_t wait_start,
+			 uint64_t now)
+{
+	uint64_t wait = 0;
+
+	s->acquired++;
+	if (wait_start) {
+		wait = now - wait_start;
+		s->contended++;
+		s->wait_total += wait;
+		if (wait > s->wait_max)
+			s->wait_max = wait;
+	}
+}
+
+/* Called with sites_lock held */
+static void add_held(struct lock_stat_site *s, uint64_t hold)
+{
+	s->held++;
+	s->hold_total += hold;
+	if (hold > s->hold_max)
+		s->hold_max = hold;
+}
+
+void lock_stat_mutex_acquired(struct mutex *m, const char *fname, int lineno,
+			      uint64_t wait_start, bool write)
+{
+	uint64_t now = lock_stat_timestamp();
+	struct lock_stat_site *s = NULL;
+	uint32_t exceptions = lock_sites();
+
+	s = get_site(m, fname, lineno, LOCK_STAT_TYPE_MUTEX);
+	if (s)
+		add_acquired(s, wait_start, now);
+
+	unlock_sites(exceptions);
+
+	/* Only the owner of a write locked mutex accesses these */
+	if (write) {
+		m->stat_site = s;
+		m->stat_ts = now;
+	}
+}
+
+void lock_stat_mutex_released(struct mutex *m)
+{
+	uint64_t now = lock_stat_timestamp();
+	struct lock_stat_site *s = m->stat_site;
+	uint32_t exceptions = 0;
+
+	if (!s)
+		return;
+	m->stat_site = NULL;
+
+	exceptions = lock_sites();
+	add_held(s, now - m->stat_ts);
+	unlock_sites(exceptions);
+}
+
+void lock_stat_spin_acquired(unsigned int *lock, uint64_t wait_start)
+{
+	uint64_t now = lock_stat_timestamp();
+	struct lock_stat_site *s = NULL;
+	uint32_t exceptions = lock_sites();
+	size_t pos = get_core_pos();
+
+	s = get_site(lock, NULL, 0, LOCK_STAT_TYPE_SPINLOCK);
+	if (s) {
+		add_acquired(s, wait_start, now);
+		if (num_held[pos] < MAX_HELD_SPINLOCKS) {
+			held[pos][num_held[pos]] = (struct held_spinlock){
+				.lock = lock, .site = s, .ts = now,
+			};
+			num_held[pos]++;
+		}
+	}
+
+	unlock_sites(exceptions);
+}
+
+void lock_stat_spin_released(unsigned int *lock)
+{
+	uint64_t now = lock_stat_timestamp();
+	uint32_t exceptions = lock_sites();
+	size_t pos = get_core_pos();
+	struct held_spinlock *h = held[pos];
+	size_t n = num_held[pos];
+
+	/* Spinlocks are mostly, but not always, released in reverse order */
+	while (n) {
+		n--;
+		if (h[n].lock == lock) {
+			add_held(h[n].site, now - h[n].ts);
+			num_held[pos]--;
+			memmove(h + n, h + n + 1,
+				(num_held[pos] - n) * sizeof(*h));
+			break;
+		}
+	}
+
+	unlock_sites(exceptions);
+}
+
+static uint64_t ticks_to_ns(uint64_t ticks, uint64_t freq)
+{
+	return (ticks / freq) * 1000000000 +
+	       ((ticks % freq) * 1000000000) / freq;
+}
+
+static void fill_stat(struct lock_stat *st, struct lock_stat_site *s,
+		      uint64_t freq)
+{
+	const char *fname = s->fname;
+	size_t max_len = LOCK_STAT_SITE_LEN - 8;
+	size_t len = 0;
+
+	*st = (struct lock_stat){
+		.lock_va = (vaddr_t)s->lock,
+		.type = s->type,
+		.acquired = s->acquired,
+		.contended = s->contended,
+		.held = s->held,
+		.wait_total_ns = ticks_to_ns(s->wait_total, freq),
+		.wait_max_ns = ticks_to_ns(s->wait_max, freq),
+		.hold_total_ns = ticks_to_ns(s->hold_total, freq),
+		.hold_max_ns = ticks_to_ns(s->hold_max, freq),
+	};
+
+	if (fname) {
+		/* Keep the end of the path with the file name */
+		len = strlen(fname);
+		if (len > max_len)
+			fname += len - max_len;
+		snprintf(st->site, sizeof(st->site), "%s:%d", fname,
+			 s->lineno);
+	}
+}
+
+size_t lock_stat_get(struct lock_stat *stats, size_t num_stats, bool reset)
+{
+	uint64_t freq = read_cntfrq();
+	struct lock_stat_site s = { };
+	uint32_t exceptions = 0;
+	size_t count = 0;
+	size_t n = 0;
+
+	if (!freq)
+		freq = 1;
+
+	for (n = 0; n < ARRAY_SIZE(sites); n++) {
+		/*
+		 * Copied first since the file name must not be accessed
+		 * with the spinlock held, it may be paged.
+		 */
+		exceptions = lock_sites();
+		s = sites[n];
+		if (reset) {
+			sites[n].acquired = 0;
+			sites[n].contended = 0;
+			sites[n].held = 0;
+			sites[n].wait_total = 0;
+			sites[n].wait_max = 0;
+			sites[n].hold_total = 0;
+			sites[n].hold_max = 0;
+		}
+		unlock_sites(exceptions);
+
+		if (!s.lock)
+			continue;
+		if (count < num_stats)
+			fill_stat(stats + count, &s, freq);
+		count++;
+	}
+
+	if (num_lost)
+		DMSG("%"PRIu32" lock acquisitions not recorded, increase CFG_LOCK_STAT_ENTRIES",
+		     num_lost);
+
+	return count;
+}
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <arm.h>
 #include <assert.h>
+#include <atomic.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
@@ -32,7 +33,16 @@
 #include <utee_types.h>
 #include <util.h>
 
-/* This mutex protects the critical section in tee_ta_init_session */
+/*
+ * This mutex protects the critical section in tee_ta_init_session,
+ * tee_ctxes, the reference counters of the contexts, the session lists
+ * and the single-instance lock. It's not taken when invoking an already
+ * opened session: the busy state of a context is protected by
+ * tee_ta_ctx::busy_mu and the session hash table by sess_locks[].
+ *
+ * Lock order is tee_ta_mutex followed by sess_locks[] in index order,
+ * tee_ta_ctx::busy_mu is never held while acquiring another lock.
+ */
 struct mutex tee_ta_mutex = MUTEX_INITIALIZER;
 struct tee_ta_ctx_head tee_ctxes = TAILQ_HEAD_INITIALIZER(tee_ctxes);
 
@@ -58,60 +68,104 @@ static bool has_single_instance_lock(void)
 #else
 static void lock_single_instance(void)
 {
-	/* Requires tee_ta_mutex to be held */
+	mutex_lock(&tee_ta_mutex);
+
 	if (tee_ta_single_instance_thread != thread_get_id()) {
 		/* Wait until the single-instance lock is available. */
 		while (tee_ta_single_instance_thread != THREAD_ID_INVALID)
 			condvar_wait(&tee_ta_cv, &tee_ta_mutex);
 
-		tee_ta_single_instance_thread = thread_get_id();
+		atomic_store_int(&tee_ta_single_instance_thread,
+				 thread_get_id());
 		assert(tee_ta_single_instance_count == 0);
 	}
 
 	tee_ta_single_instance_count++;
+
+	mutex_unlock(&tee_ta_mutex);
 }
 
 static void unlock_single_instance(void)
 {
-	/* Requires tee_ta_mutex to be held */
+	mutex_lock(&tee_ta_mutex);
+
 	assert(tee_ta_single_instance_thread == thread_get_id());
 	assert(tee_ta_single_instance_count > 0);
 
 	tee_ta_single_instance_count--;
 	if (tee_ta_single_instance_count == 0) {
-		tee_ta_single_instance_thread = THREAD_ID_INVALID;
+		atomic_store_int(&tee_ta_single_instance_thread,
+				 THREAD_ID_INVALID);
 		condvar_signal(&tee_ta_cv);
 	}
+
+	mutex_unlock(&tee_ta_mutex);
 }
 
 static bool has_single_instance_lock(void)
 {
-	/* Requires tee_ta_mutex to be held */
-	return tee_ta_single_instance_thread == thread_get_id();
+	/*
+	 * Only the current thread can set or clear its own ID so the
+	 * answer doesn't change if tee_ta_mutex isn't held.
+	 */
+	return atomic_load_int(&tee_ta_single_instance_thread) ==
+	       thread_get_id();
 }
 #endif
 
+/*
+ * A context with TA_FLAG_CONCURRENT is never busy, instead the threads
+ * executing it are counted so it isn't destroyed under their feet, see
+ * destroy_ta_ctx_from_session().
+ */
+static void enter_concurrent(struct tee_ta_ctx *ctx)
+{
+	mutex_lock(&ctx->busy_mu);
+	ctx->num_entered++;
+	mutex_unlock(&ctx->busy_mu);
+}
+
+static void leave_concurrent(struct tee_ta_ctx *ctx)
+{
+	mutex_lock(&ctx->busy_mu);
+	assert(ctx->num_entered);
+	ctx->num_entered--;
+	if (!ctx->num_entered)
+		condvar_broadcast(&ctx->busy_cv);
+	mutex_unlock(&ctx->busy_mu);
+}
+
 static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx)
 {
+	bool unlock_si = false;
 	bool rc = true;
 
-	if (ctx->flags & TA_FLAG_CONCURRENT)
+	if ((ctx->flags & TA_FLAG_CONCURRENT) && !ctx->initializing) {
+		enter_concurrent(ctx);
 		return true;
-
-	mutex_lock(&tee_ta_mutex);
+	}
 
 	if (ctx->initializing) {
 		/*
 		 * Context is still initializing and flags cannot be relied
 		 * on for user TAs. Wait here until it's initialized.
 		 */
+		mutex_lock(&ctx->busy_mu);
 		while (ctx->busy)
-			condvar_wait(&ctx->busy_cv, &tee_ta_mutex);
+			condvar_wait(&ctx->busy_cv, &ctx->busy_mu);
+		mutex_unlock(&ctx->busy_mu);
+
+		if (ctx->flags & TA_FLAG_CONCURRENT) {
+			enter_concurrent(ctx);
+			return true;
+		}
 	}
 
 	if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
 		lock_single_instance();
 
+	mutex_lock(&ctx->busy_mu);
+
 	if (has_single_instance_lock()) {
 		if (ctx->busy) {
 			/*
@@ -120,8 +174,7 @@ static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx)
 			 * dead-lock, we release the lock and return false.
 			 */
 			rc = false;
-			if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
-				unlock_single_instance();
+			unlock_si = ctx->flags & TA_FLAG_SINGLE_INSTANCE;
 		}
 	} else {
 		/*
@@ -129,13 +182,17 @@ static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx)
 		 * wait for the TA to become available.
 		 */
 		while (ctx->busy)
-			condvar_wait(&ctx->busy_cv, &tee_ta_mutex);
+			condvar_wait(&ctx->busy_cv, &ctx->busy_mu);
 	}
 
 	/* Either it's already true or we should set it to true */
 	ctx->busy = true;
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(&ctx->busy_mu);
+
+	if (unlock_si)
+		unlock_single_instance();
+
 	return rc;
 }
 
@@ -147,23 +204,156 @@ static void tee_ta_set_busy(struct tee_ta_ctx *ctx)
 
 static void tee_ta_clear_busy(struct tee_ta_ctx *ctx)
 {
-	if (ctx->flags & TA_FLAG_CONCURRENT)
+	bool unlock_si = false;
+
+	/*
+	 * A user TA gets its flags while initializing, the busy state set
+	 * before that must still be cleared.
+	 */
+	if ((ctx->flags & TA_FLAG_CONCURRENT) && !ctx->initializing) {
+		leave_concurrent(ctx);
 		return;
+	}
 
-	mutex_lock(&tee_ta_mutex);
+	mutex_lock(&ctx->busy_mu);
 
 	assert(ctx->busy);
 	ctx->busy = false;
 	condvar_signal(&ctx->busy_cv);
 
-	if (!ctx->initializing && (ctx->flags & TA_FLAG_SINGLE_INSTANCE))
-		unlock_single_instance();
+	unlock_si = !ctx->initializing &&
+		    (ctx->flags & TA_FLAG_SINGLE_INSTANCE);
 
 	ctx->initializing = false;
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(&ctx->busy_mu);
+
+	if (unlock_si)
+		unlock_single_instance();
+}
+
+/*
+ * The sessions of all session lists are also indexed in a hash table
+ * keyed by session list and session ID. The number of buckets is doubled
+ * each time there are more sessions than buckets so lookups stay O(1)
+ * regardless of the number of open sessions.
+ *
+ * Bucket n is protected by sess_locks[n % SESS_LOCK_COUNT], which also
+ * protects the ref_count, lock_thread and unlink fields of the sessions
+ * in the bucket. Getting and putting different sessions thus rarely
+ * share a lock. Growing the table requires tee_ta_mutex and all of
+ * sess_locks[], sess_hash_count is protected by tee_ta_mutex.
+ */
+#define SESS_HASH_MIN_BUCKETS	16U
+#define SESS_LOCK_COUNT		16U	/* <= SESS_HASH_MIN_BUCKETS */
+
+LIST_HEAD(sess_bucket, tee_ta_session);
+
+static struct sess_bucket *sess_hash;
+static size_t sess_hash_size;
+static size_t sess_hash_count;
+/* Zero initialized is the same as MUTEX_INITIALIZER */
+static struct mutex sess_locks[SESS_LOCK_COUNT];
+
+static vaddr_t sess_hash_val(struct tee_ta_session_head *open_sessions,
+			     uint32_t id)
+{
+	return ((vaddr_t)open_sessions >> 4) + id;
+}
+
+static struct mutex *sess_lock(struct tee_ta_session_head *open_sessions,
+			       uint32_t id)
+{
+	return sess_locks + (sess_hash_val(open_sessions, id) &
+			     (SESS_LOCK_COUNT - 1));
+}
+
+static struct sess_bucket *
+sess_hash_bucket(struct sess_bucket *hash, size_t size,
+		 struct tee_ta_session_head *open_sessions, uint32_t id)
+{
+	return hash + (sess_hash_val(open_sessions, id) & (size - 1));
+}
+
+/* Called with tee_ta_mutex held */
+static void sess_hash_grow(void)
+{
+	size_t size = MAX(sess_hash_size * 2, SESS_HASH_MIN_BUCKETS);
+	struct sess_bucket *old_hash = sess_hash;
+	struct sess_bucket *hash = NULL;
+	struct sess_bucket *b = NULL;
+	struct tee_ta_session *s = NULL;
+	size_t n = 0;
+
+	hash = calloc(size, sizeof(*hash));
+	if (!hash)
+		return;
+
+	for (n = 0; n < SESS_LOCK_COUNT; n++)
+		mutex_lock(sess_locks + n);
+
+	for (n = 0; n < sess_hash_size; n++) {
+		while (!LIST_EMPTY(sess_hash + n)) {
+			s = LIST_FIRST(sess_hash + n);
+			LIST_REMOVE(s, link_hash);
+			b = sess_hash_bucket(hash, size, s->open_sessions,
+					     s->id);
+			LIST_INSERT_HEAD(b, s, link_hash);
+		}
+	}
+
+	sess_hash = hash;
+	sess_hash_size = size;
+
+	for (n = 0; n < SESS_LOCK_COUNT; n++)
+		mutex_unlock(sess_locks + n);
+
+	free(old_hash);
 }
 
+/* Called with tee_ta_mutex held, makes room for one more session */
+static TEE_Result sess_hash_reserve(void)
+{
+	/* A failure to grow only makes the chains longer */
+	if (sess_hash_count >= sess_hash_size)
+		sess_hash_grow();
+	if (!sess_hash)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	return TEE_SUCCESS;
+}
+
+/* Called with tee_ta_mutex held after sess_hash_reserve() */
+static void sess_hash_add(struct tee_ta_session *s)
+{
+	struct mutex *mu = sess_lock(s->open_sessions, s->id);
+
+	mutex_lock(mu);
+	LIST_INSERT_HEAD(sess_hash_bucket(sess_hash, sess_hash_size,
+					  s->open_sessions, s->id),
+			 s, link_hash);
+	mutex_unlock(mu);
+	sess_hash_count++;
+}
+
+/* Called with the lock of the bucket held */
+static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
+			struct tee_ta_session_head *open_sessions)
+{
+	struct tee_ta_session *s = NULL;
+
+	if (!sess_hash)
+		return NULL;
+
+	LIST_FOREACH(s, sess_hash_bucket(sess_hash, sess_hash_size,
+					 open_sessions, id), link_hash)
+		if (s->id == id && s->open_sessions == open_sessions)
+			return s;
+
+	return NULL;
+}
+
+/* Called with the lock of the bucket of @s held */
 static void dec_session_ref_count(struct tee_ta_session *s)
 {
 	assert(s->ref_count > 0);
@@ -174,7 +364,9 @@ static void dec_session_ref_count(struct tee_ta_session *s)
 
 void tee_ta_put_session(struct tee_ta_session *s)
 {
-	mutex_lock(&tee_ta_mutex);
+	struct mutex *mu = sess_lock(s->open_sessions, s->id);
+
+	mutex_lock(mu);
 
 	if (s->lock_thread == thread_get_id()) {
 		s->lock_thread = THREAD_ID_INVALID;
@@ -182,35 +374,20 @@ void tee_ta_put_session(struct tee_ta_session *s)
 	}
 	dec_session_ref_count(s);
 
-	mutex_unlock(&tee_ta_mutex);
-}
-
-static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
-			struct tee_ta_session_head *open_sessions)
-{
-	struct tee_ta_session *s = NULL;
-	struct tee_ta_session *found = NULL;
-
-	TAILQ_FOREACH(s, open_sessions, link) {
-		if (s->id == id) {
-			found = s;
-			break;
-		}
-	}
-
-	return found;
+	mutex_unlock(mu);
 }
 
 struct tee_ta_session *tee_ta_find_session(uint32_t id,
 			struct tee_ta_session_head *open_sessions)
 {
+	struct mutex *mu = sess_lock(open_sessions, id);
 	struct tee_ta_session *s = NULL;
 
-	mutex_lock(&tee_ta_mutex);
+	mutex_lock(mu);
 
 	s = tee_ta_find_session_nolock(id, open_sessions);
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(mu);
 
 	return s;
 }
@@ -218,9 +395,10 @@ struct tee_ta_session *tee_ta_find_session(uint32_t id,
 struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 			struct tee_ta_session_head *open_sessions)
 {
+	struct mutex *mu = sess_lock(open_sessions, id);
 	struct tee_ta_session *s;
 
-	mutex_lock(&tee_ta_mutex);
+	mutex_lock(mu);
 
 	while (true) {
 		s = tee_ta_find_session_nolock(id, open_sessions);
@@ -237,7 +415,7 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 		assert(s->lock_thread != thread_get_id());
 
 		while (s->lock_thread != THREAD_ID_INVALID && !s->unlink)
-			condvar_wait(&s->lock_cv, &tee_ta_mutex);
+			condvar_wait(&s->lock_cv, mu);
 
 		if (s->unlink) {
 			dec_session_ref_count(s);
@@ -249,14 +427,16 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 		break;
 	}
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(mu);
 	return s;
 }
 
 static void tee_ta_unlink_session(struct tee_ta_session *s,
 			struct tee_ta_session_head *open_sessions)
 {
-	mutex_lock(&tee_ta_mutex);
+	struct mutex *mu = sess_lock(open_sessions, s->id);
+
+	mutex_lock(mu);
 
 	assert(s->ref_count >= 1);
 	assert(s->lock_thread == thread_get_id());
@@ -266,10 +446,15 @@ static void tee_ta_unlink_session(struct tee_ta_session *s,
 	condvar_broadcast(&s->lock_cv);
 
 	while (s->ref_count != 1)
-		condvar_wait(&s->refc_cv, &tee_ta_mutex);
+		condvar_wait(&s->refc_cv, mu);
 
-	TAILQ_REMOVE(open_sessions, s, link);
+	LIST_REMOVE(s, link_hash);
 
+	mutex_unlock(mu);
+
+	mutex_lock(&tee_ta_mutex);
+	TAILQ_REMOVE(open_sessions, s, link);
+	sess_hash_count--;
 	mutex_unlock(&tee_ta_mutex);
 }
 
@@ -296,10 +481,18 @@ static void destroy_context(struct tee_ta_ctx *ctx)
 	DMSG("Destroy TA ctx (0x%" PRIxVA ")",  (vaddr_t)ctx);
 
 	condvar_destroy(&ctx->busy_cv);
+	mutex_destroy(&ctx->busy_mu);
 	pgt_flush_ctx(ctx);
 	ctx->ops->destroy(ctx);
 }
 
+/*
+ * Called with @s->ctx busy once it has panicked, clears the busy state.
+ *
+ * Other threads may still execute a TA_FLAG_CONCURRENT context. The first
+ * thread to get here waits for them to leave before destroying the
+ * context, the others only leave it.
+ */
 static void destroy_ta_ctx_from_session(struct tee_ta_session *s)
 {
 	struct tee_ta_session *sess = NULL;
@@ -307,6 +500,22 @@ static void destroy_ta_ctx_from_session(struct tee_ta_session *s)
 	struct tee_ta_ctx *ctx = NULL;
 	struct user_ta_ctx *utc = NULL;
 	size_t count = 1; /* start counting the references to the context */
+	bool dying = false;
+
+	mutex_lock(&s->ctx->busy_mu);
+	dying = s->ctx->dying;
+	s->ctx->dying = true;
+	mutex_unlock(&s->ctx->busy_mu);
+
+	tee_ta_clear_busy(s->ctx);
+	/* Another thread destroys the context, it may be gone already */
+	if (dying)
+		return;
+
+	mutex_lock(&s->ctx->busy_mu);
+	while (s->ctx->num_entered)
+		condvar_wait(&s->ctx->busy_cv, &s->ctx->busy_mu);
+	mutex_unlock(&s->ctx->busy_mu);
 
 	DMSG("Remove references to context (0x%" PRIxVA ")", (vaddr_t)s->ctx);
 
@@ -582,7 +791,11 @@ static uint32_t new_session_id(struct tee_ta_session_head *open_sessions)
 
 	last = TAILQ_LAST(open_sessions, tee_ta_session_head);
 	if (last) {
-		/* This value is less likely to be already used */
+		/*
+		 * This value is less likely to be already used, IDs are
+		 * handed out in increasing order so the probing below
+		 * normally succeeds at once.
+		 */
 		id = last->id + 1;
 		if (!id)
 			id++; /* 0 is not valid */
@@ -590,7 +803,7 @@ static uint32_t new_session_id(struct tee_ta_session_head *open_sessions)
 
 	saved = id;
 	do {
-		if (!tee_ta_find_session_nolock(id, open_sessions))
+		if (!tee_ta_find_session(id, open_sessions))
 			return id;
 		id++;
 		if (!id)
@@ -631,8 +844,12 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 	s->id = new_session_id(open_sessions);
 	if (!s->id) {
 		res = TEE_ERROR_OVERFLOW;
-		goto out;
+		goto err_free;
 	}
+	s->open_sessions = open_sessions;
+	res = sess_hash_reserve();
+	if (res)
+		goto err_free;
 	TAILQ_INSERT_TAIL(open_sessions, s, link);
 
 	/* Look for already loaded TA */
@@ -653,11 +870,16 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 
 out:
 	if (res == TEE_SUCCESS) {
+		/* Only visible to lookups once fully initialized */
+		sess_hash_add(s);
 		*sess = s;
-	} else {
-		TAILQ_REMOVE(open_sessions, s, link);
-		free(s);
+		mutex_unlock(&tee_ta_mutex);
+		return TEE_SUCCESS;
 	}
+
+	TAILQ_REMOVE(open_sessions, s, link);
+err_free:
+	free(s);
 	mutex_unlock(&tee_ta_mutex);
 	return res;
 }
@@ -701,15 +923,16 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 	if (tee_ta_try_set_busy(ctx)) {
 		set_invoke_timeout(s, cancel_req_to);
 		res = ctx->ops->enter_open_session(s, param, err);
+		/* The context may be destroyed once it isn't busy */
+		panicked = ctx->panicked;
 		tee_ta_clear_busy(ctx);
 	} else {
 		/* Deadlock avoided */
 		res = TEE_ERROR_BUSY;
 		was_busy = true;
+		panicked = ctx->panicked;
 	}
 
-	panicked = ctx->panicked;
-
 	tee_ta_put_session(s);
 	if (panicked || (res != TEE_SUCCESS))
 		tee_ta_close_session(s, open_sessions, KERN_IDENTITY);
@@ -733,7 +956,8 @@ TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 				 uint32_t cancel_req_to, uint32_t cmd,
 				 struct tee_ta_param *param)
 {
-	TEE_Result res;
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_ta_ctx *ctx = NULL;
 
 	if (check_client(sess, clnt_id) != TEE_SUCCESS)
 		return TEE_ERROR_BAD_PARAMETERS; /* intentional generic error */
@@ -741,30 +965,33 @@ TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 	if (!check_params(sess, param))
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	if (!sess->ctx) {
+	ctx = sess->ctx;
+	if (!ctx) {
 		/* The context has been already destroyed */
 		*err = TEE_ORIGIN_TEE;
 		return TEE_ERROR_TARGET_DEAD;
-	} else if (sess->ctx->panicked) {
-		DMSG("Panicked !");
-		destroy_ta_ctx_from_session(sess);
-		*err = TEE_ORIGIN_TEE;
-		return TEE_ERROR_TARGET_DEAD;
 	}
 
-	tee_ta_set_busy(sess->ctx);
-
-	set_invoke_timeout(sess, cancel_req_to);
-	res = sess->ctx->ops->enter_invoke_cmd(sess, cmd, param, err);
+	tee_ta_set_busy(ctx);
 
-	tee_ta_clear_busy(sess->ctx);
+	if (!ctx->panicked) {
+		set_invoke_timeout(sess, cancel_req_to);
+		res = ctx->ops->enter_invoke_cmd(sess, cmd, param, err);
+	}
 
-	if (sess->ctx->panicked) {
+	/*
+	 * The context must not be accessed once it isn't busy, it may be
+	 * destroyed by another thread if it has panicked.
+	 */
+	if (ctx->panicked) {
+		DMSG("Panicked !");
 		destroy_ta_ctx_from_session(sess);
 		*err = TEE_ORIGIN_TEE;
 		return TEE_ERROR_TARGET_DEAD;
 	}
 
+	tee_ta_clear_busy(ctx);
+
 	/* Short buffer is not an effective error case */
 	if (res != TEE_SUCCESS && res != TEE_ERROR_SHORT_BUFFER)
 		DMSG("Error: %x of %d", res, *err);
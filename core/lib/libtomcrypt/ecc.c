@@ -12,6 +12,7 @@
 #include <utee_defines.h>
 
 #include "acipher_helpers.h"
+#include "ecc_p256.h"
 
 TEE_Result crypto_acipher_alloc_ecc_keypair(struct ecc_keypair *s,
 					    size_t key_size_bits __unused)
@@ -125,6 +126,256 @@ static TEE_Result ecc_get_keysize(uint32_t curve, uint32_t algo,
 	return TEE_SUCCESS;
 }
 
+static TEE_Result ecc_compute_key_idx(ecc_key *ltc_key, size_t keysize)
+{
+	size_t x;
+
+	for (x = 0; ((int)keysize > ltc_ecc_sets[x].size) &&
+		    (ltc_ecc_sets[x].size != 0);
+	     x++)
+		;
+	keysize = (size_t)ltc_ecc_sets[x].size;
+
+	if ((keysize > ECC_MAXSIZE) || (ltc_ecc_sets[x].size == 0))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	ltc_key->idx = -1;
+	ltc_key->dp  = &ltc_ecc_sets[x];
+
+	return TEE_SUCCESS;
+}
+
+#if defined(_CFG_CORE_LTC_ECC_P256)
+/*
+ * P-256 goes through the dedicated fixed size field arithmetic in
+ * ecc_p256.c for all point multiplications. The few operations modulo
+ * the group order are still done with the generic bignums. The functions
+ * below return LTC status codes and mirror ecc_make_key(),
+ * ecc_sign_hash_raw(), ecc_verify_hash_raw() and ecc_shared_secret().
+ */
+static int p256_to_bytes(void *a, uint8_t b[ECC_P256_BYTES])
+{
+	size_t sz = mp_unsigned_bin_size(a);
+
+	if (sz > ECC_P256_BYTES)
+		return CRYPT_BUFFER_OVERFLOW;
+	memset(b, 0, ECC_P256_BYTES);
+	return mp_to_unsigned_bin(a, b + ECC_P256_BYTES - sz);
+}
+
+/* k = random in [1, n - 1] */
+static int p256_rand_scalar(void *k, void *n, int wprng)
+{
+	int err = CRYPT_OK;
+
+	do {
+		err = rand_bn_range(k, n, NULL, wprng);
+		if (err != CRYPT_OK)
+			return err;
+	} while (mp_iszero(k) == LTC_MP_YES);
+
+	return CRYPT_OK;
+}
+
+static int p256_make_key(ecc_key *key)
+{
+	const ltc_ecc_set_type *dp = key->dp;
+	uint8_t kb[ECC_P256_BYTES] = { 0 };
+	uint8_t x[ECC_P256_BYTES] = { 0 };
+	uint8_t y[ECC_P256_BYTES] = { 0 };
+	void *n = NULL;
+	int err = CRYPT_OK;
+
+	err = mp_init_multi(&key->pubkey.x, &key->pubkey.y, &key->pubkey.z,
+			    &key->k, &n, NULL);
+	if (err != CRYPT_OK)
+		return err;
+
+	if ((err = mp_read_radix(n, (char *)dp->order, 16)) != CRYPT_OK)
+		goto err;
+	err = p256_rand_scalar(key->k, n, find_prng("prng_crypto"));
+	if (err != CRYPT_OK)
+		goto err;
+	if ((err = p256_to_bytes(key->k, kb)) != CRYPT_OK)
+		goto err;
+	if (ecc_p256_mul_base(kb, x, y)) {
+		err = CRYPT_ERROR;
+		goto err;
+	}
+	if ((err = mp_read_unsigned_bin(key->pubkey.x, x, sizeof(x))))
+		goto err;
+	if ((err = mp_read_unsigned_bin(key->pubkey.y, y, sizeof(y))))
+		goto err;
+	if ((err = mp_set(key->pubkey.z, 1)) != CRYPT_OK)
+		goto err;
+	key->type = PK_PRIVATE;
+	goto out;
+err:
+	mp_clear_multi(key->pubkey.x, key->pubkey.y, key->pubkey.z, key->k,
+		       NULL);
+out:
+	mp_clear(n);
+	memset(kb, 0, sizeof(kb));
+	return err;
+}
+
+static int p256_sign_hash_raw(const uint8_t *in, size_t inlen, void *r,
+			      void *s, ecc_key *key)
+{
+	uint8_t kb[ECC_P256_BYTES] = { 0 };
+	uint8_t x[ECC_P256_BYTES] = { 0 };
+	uint8_t y[ECC_P256_BYTES] = { 0 };
+	int wprng = find_prng("prng_crypto");
+	void *n = NULL;
+	void *e = NULL;
+	void *k = NULL;
+	void *b = NULL;
+	void *t = NULL;
+	int err = CRYPT_OK;
+
+	if ((err = mp_init_multi(&n, &e, &k, &b, &t, NULL)) != CRYPT_OK)
+		return err;
+	if ((err = mp_read_radix(n, (char *)key->dp->order, 16)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_read_unsigned_bin(e, (uint8_t *)in, inlen)) != CRYPT_OK)
+		goto out;
+
+	while (true) {
+		if ((err = p256_rand_scalar(k, n, wprng)) != CRYPT_OK)
+			goto out;
+		if ((err = p256_to_bytes(k, kb)) != CRYPT_OK)
+			goto out;
+		if (ecc_p256_mul_base(kb, x, y)) {
+			err = CRYPT_ERROR;
+			goto out;
+		}
+
+		/* r = x1 mod n */
+		if ((err = mp_read_unsigned_bin(r, x, sizeof(x))) != CRYPT_OK)
+			goto out;
+		if ((err = mp_mod(r, n, r)) != CRYPT_OK)
+			goto out;
+		if (mp_iszero(r) == LTC_MP_YES)
+			continue;
+
+		/* s = (e + d r) / k, blinded by b as ecc_sign_hash_raw() */
+		if ((err = p256_rand_scalar(b, n, wprng)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_mulmod(k, b, n, k)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_invmod(k, n, k)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_mulmod(key->k, r, n, s)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_mulmod(k, s, n, s)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_mulmod(k, e, n, t)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_add(t, s, s)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_mulmod(s, b, n, s)) != CRYPT_OK)
+			goto out;
+		if (mp_iszero(s) == LTC_MP_NO)
+			break;
+	}
+out:
+	memset(kb, 0, sizeof(kb));
+	mp_clear_multi(n, e, k, b, t, NULL);
+	return err;
+}
+
+static int p256_verify_hash_raw(void *r, void *s, const uint8_t *hash,
+				size_t hashlen, int *stat, ecc_key *key)
+{
+	uint8_t u1b[ECC_P256_BYTES] = { 0 };
+	uint8_t u2b[ECC_P256_BYTES] = { 0 };
+	uint8_t qx[ECC_P256_BYTES] = { 0 };
+	uint8_t qy[ECC_P256_BYTES] = { 0 };
+	uint8_t x[ECC_P256_BYTES] = { 0 };
+	void *n = NULL;
+	void *e = NULL;
+	void *w = NULL;
+	void *u1 = NULL;
+	void *u2 = NULL;
+	int err = CRYPT_OK;
+
+	*stat = 0;
+
+	if ((err = mp_init_multi(&n, &e, &w, &u1, &u2, NULL)) != CRYPT_OK)
+		return err;
+	if ((err = mp_read_radix(n, (char *)key->dp->order, 16)) != CRYPT_OK)
+		goto out;
+	if (mp_iszero(r) == LTC_MP_YES || mp_iszero(s) == LTC_MP_YES ||
+	    mp_cmp(r, n) != LTC_MP_LT || mp_cmp(s, n) != LTC_MP_LT) {
+		err = CRYPT_INVALID_PACKET;
+		goto out;
+	}
+	if ((err = mp_read_unsigned_bin(e, (uint8_t *)hash, hashlen)))
+		goto out;
+
+	/* u1 = e / s, u2 = r / s */
+	if ((err = mp_invmod(s, n, w)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_mulmod(e, w, n, u1)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_mulmod(r, w, n, u2)) != CRYPT_OK)
+		goto out;
+
+	if ((err = p256_to_bytes(u1, u1b)) != CRYPT_OK)
+		goto out;
+	if ((err = p256_to_bytes(u2, u2b)) != CRYPT_OK)
+		goto out;
+	if ((err = p256_to_bytes(key->pubkey.x, qx)) != CRYPT_OK)
+		goto out;
+	if ((err = p256_to_bytes(key->pubkey.y, qy)) != CRYPT_OK)
+		goto out;
+
+	/* The point at infinity or an invalid key just fails verification */
+	if (ecc_p256_mul2add(u1b, u2b, qx, qy, x))
+		goto out;
+
+	/* v = x1 mod n, reuse e */
+	if ((err = mp_read_unsigned_bin(e, x, sizeof(x))) != CRYPT_OK)
+		goto out;
+	if ((err = mp_mod(e, n, e)) != CRYPT_OK)
+		goto out;
+	if (mp_cmp(e, r) == LTC_MP_EQ)
+		*stat = 1;
+out:
+	mp_clear_multi(n, e, w, u1, u2, NULL);
+	return err;
+}
+
+static int p256_shared_secret(ecc_key *private_key, ecc_key *public_key,
+			      uint8_t *out, unsigned long *outlen)
+{
+	uint8_t kb[ECC_P256_BYTES] = { 0 };
+	uint8_t qx[ECC_P256_BYTES] = { 0 };
+	uint8_t qy[ECC_P256_BYTES] = { 0 };
+	int err = CRYPT_OK;
+
+	if (*outlen < ECC_P256_BYTES) {
+		*outlen = ECC_P256_BYTES;
+		return CRYPT_BUFFER_OVERFLOW;
+	}
+
+	if ((err = p256_to_bytes(private_key->k, kb)) != CRYPT_OK)
+		goto out;
+	if ((err = p256_to_bytes(public_key->pubkey.x, qx)) != CRYPT_OK)
+		goto out;
+	if ((err = p256_to_bytes(public_key->pubkey.y, qy)) != CRYPT_OK)
+		goto out;
+	if (ecc_p256_mul(kb, qx, qy, out, NULL)) {
+		err = CRYPT_INVALID_ARG;
+		goto out;
+	}
+	*outlen = ECC_P256_BYTES;
+out:
+	memset(kb, 0, sizeof(kb));
+	return err;
+}
+#endif /*_CFG_CORE_LTC_ECC_P256*/
+
 TEE_Result crypto_acipher_gen_ecc_key(struct ecc_keypair *key)
 {
 	TEE_Result res;
@@ -138,6 +389,14 @@ TEE_Result crypto_acipher_gen_ecc_key(struct ecc_keypair *key)
 		return res;
 
 	/* Generate the ECC key */
+#if defined(_CFG_CORE_LTC_ECC_P256)
+	if (key->curve == TEE_ECC_CURVE_NIST_P256) {
+		res = ecc_compute_key_idx(&ltc_tmp_key, key_size_bytes);
+		if (res != TEE_SUCCESS)
+			return res;
+		ltc_res = p256_make_key(&ltc_tmp_key);
+	} else
+#endif
 	ltc_res = ecc_make_key(NULL, find_prng("prng_crypto"),
 			       key_size_bytes, &ltc_tmp_key);
 	if (ltc_res != CRYPT_OK)
@@ -169,25 +428,6 @@ exit:
 	return res;
 }
 
-static TEE_Result ecc_compute_key_idx(ecc_key *ltc_key, size_t keysize)
-{
-	size_t x;
-
-	for (x = 0; ((int)keysize > ltc_ecc_sets[x].size) &&
-		    (ltc_ecc_sets[x].size != 0);
-	     x++)
-		;
-	keysize = (size_t)ltc_ecc_sets[x].size;
-
-	if ((keysize > ECC_MAXSIZE) || (ltc_ecc_sets[x].size == 0))
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	ltc_key->idx = -1;
-	ltc_key->dp  = &ltc_ecc_sets[x];
-
-	return TEE_SUCCESS;
-}
-
 /*
  * Given a keypair "key", populate the Libtomcrypt private key "ltc_key"
  * It also returns the key size, in bytes
@@ -276,6 +516,11 @@ TEE_Result crypto_acipher_ecc_sign(uint32_t algo, struct ecc_keypair *key,
 		goto err;
 	}
 
+#if defined(_CFG_CORE_LTC_ECC_P256)
+	if (key->curve == TEE_ECC_CURVE_NIST_P256)
+		ltc_res = p256_sign_hash_raw(msg, msg_len, r, s, &ltc_key);
+	else
+#endif
 	ltc_res = ecc_sign_hash_raw(msg, msg_len, r, s,
 				    NULL, find_prng("prng_crypto"), &ltc_key);
 
@@ -331,6 +576,12 @@ TEE_Result crypto_acipher_ecc_verify(uint32_t algo, struct ecc_public_key *key,
 	mp_read_unsigned_bin(r, (uint8_t *)sig, sig_len/2);
 	mp_read_unsigned_bin(s, (uint8_t *)sig + sig_len/2, sig_len/2);
 
+#if defined(_CFG_CORE_LTC_ECC_P256)
+	if (key->curve == TEE_ECC_CURVE_NIST_P256)
+		ltc_res = p256_verify_hash_raw(r, s, msg, msg_len, &ltc_stat,
+					       &ltc_key);
+	else
+#endif
 	ltc_res = ecc_verify_hash_raw(r, s, msg, msg_len, &ltc_stat, &ltc_key);
 	res = convert_ltc_verify_status(ltc_res, ltc_stat);
 out:
@@ -367,6 +618,12 @@ TEE_Result crypto_acipher_ecc_shared_secret(struct ecc_keypair *private_key,
 	if (res != TEE_SUCCESS)
 		goto out;
 
+#if defined(_CFG_CORE_LTC_ECC_P256)
+	if (private_key->curve == TEE_ECC_CURVE_NIST_P256)
+		ltc_res = p256_shared_secret(&ltc_private_key, &ltc_public_key,
+					     secret, secret_len);
+	else
+#endif
 	ltc_res = ecc_shared_secret(&ltc_private_key, &ltc_public_key,
 				    secret, secret_len);
 	if (ltc_res == CRYPT_OK)
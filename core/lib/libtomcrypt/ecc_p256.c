@@ -0,0 +1,569 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2019, agent
+ */
+
+#include <io.h>
+#include <stdbool.h>
+#include <string.h>
+#include <tee_api_types.h>
+
+#include "ecc_p256.h"
+
+/*
+ * Field elements are 8 little endian 32-bit limbs and are always kept
+ * fully reduced, that is in [0, p), so that equality and zero checks
+ * can be done on the limbs directly.
+ */
+#define NLIMBS	8
+
+typedef uint32_t fe[NLIMBS];
+
+/* Jacobian coordinates, Z == 0 is the point at infinity */
+struct p256_point {
+	fe x;
+	fe y;
+	fe z;
+};
+
+/* p = 2^256 - 2^224 + 2^192 + 2^96 - 1 */
+static const fe p256_p = {
+	0xffffffff, 0xffffffff, 0xffffffff, 0x00000000,
+	0x00000000, 0x00000000, 0x00000001, 0xffffffff
+};
+
+static const fe p256_b = {
+	0x27d2604b, 0x3bce3c3e, 0xcc53b0f6, 0x651d06b0,
+	0x769886bc, 0xb3ebbd55, 0xaa3a93e7, 0x5ac635d8
+};
+
+static const fe p256_gx = {
+	0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81,
+	0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2
+};
+
+static const fe p256_gy = {
+	0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357,
+	0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2
+};
+
+/* p - 2, the exponent used for inversion */
+static const fe p256_p_minus_2 = {
+	0xfffffffd, 0xffffffff, 0xffffffff, 0x00000000,
+	0x00000000, 0x00000000, 0x00000001, 0xffffffff
+};
+
+static void fe_from_bytes(fe r, const uint8_t b[ECC_P256_BYTES])
+{
+	size_t n = 0;
+
+	for (n = 0; n < NLIMBS; n++)
+		r[n] = get_be32(b + ECC_P256_BYTES - 4 * (n + 1));
+}
+
+static void fe_to_bytes(uint8_t b[ECC_P256_BYTES], const fe a)
+{
+	size_t n = 0;
+
+	for (n = 0; n < NLIMBS; n++)
+		put_be32(b + ECC_P256_BYTES - 4 * (n + 1), a[n]);
+}
+
+static void fe_copy(fe r, const fe a)
+{
+	memcpy(r, a, sizeof(fe));
+}
+
+/* r = a if mask is all ones, unchanged if mask is zero */
+static void fe_cmov(fe r, const fe a, uint32_t mask)
+{
+	size_t n = 0;
+
+	for (n = 0; n < NLIMBS; n++)
+		r[n] = (r[n] & ~mask) | (a[n] & mask);
+}
+
+/* Returns all ones if a == 0, zero otherwise */
+static uint32_t fe_is_zero(const fe a)
+{
+	uint32_t t = 0;
+	size_t n = 0;
+
+	for (n = 0; n < NLIMBS; n++)
+		t |= a[n];
+
+	return ((t | (0 - t)) >> 31) - 1;
+}
+
+/* r = a - b, returns the borrow (0 or 1) */
+static uint32_t limbs_sub(fe r, const fe a, const fe b)
+{
+	int64_t t = 0;
+	size_t n = 0;
+
+	for (n = 0; n < NLIMBS; n++) {
+		t += (int64_t)a[n] - b[n];
+		r[n] = (uint32_t)t;
+		t >>= 32;
+	}
+
+	return (uint32_t)t & 1;
+}
+
+/* Returns true if a < p */
+static bool fe_is_valid(const fe a)
+{
+	fe t;
+
+	return limbs_sub(t, a, p256_p);
+}
+
+/* r = a + b mod p */
+static void fe_add(fe r, const fe a, const fe b)
+{
+	uint64_t t = 0;
+	uint32_t carry = 0;
+	uint32_t borrow = 0;
+	fe s;
+	fe d;
+	size_t n = 0;
+
+	for (n = 0; n < NLIMBS; n++) {
+		t += (uint64_t)a[n] + b[n];
+		s[n] = (uint32_t)t;
+		t >>= 32;
+	}
+	carry = (uint32_t)t;
+	borrow = limbs_sub(d, s, p256_p);
+	fe_copy(r, s);
+	fe_cmov(r, d, 0 - (carry | (borrow ^ 1)));
+}
+
+/* r = a - b mod p */
+static void fe_sub(fe r, const fe a, const fe b)
+{
+	uint32_t mask = 0 - limbs_sub(r, a, b);
+	uint64_t t = 0;
+	size_t n = 0;
+
+	for (n = 0; n < NLIMBS; n++) {
+		t += (uint64_t)r[n] + (p256_p[n] & mask);
+		r[n] = (uint32_t)t;
+		t >>= 32;
+	}
+}
+
+/*
+ * Reduces the 512-bit product c modulo p using the Solinas method from
+ * FIPS 186-4 D.2.3:
+ * r = s1 + 2 s2 + 2 s3 + s4 + s5 - d1 - d2 - d3 - d4
+ */
+static void fe_reduce(fe r, const uint32_t c[2 * NLIMBS])
+{
+	int64_t w[NLIMBS];
+	int64_t acc = 0;
+	uint32_t borrow = 0;
+	fe d;
+	size_t n = 0;
+	size_t i = 0;
+
+	w[0] = (int64_t)c[0] + c[8] + c[9] - c[11] - c[12] - c[13] - c[14];
+	w[1] = (int64_t)c[1] + c[9] + c[10] - c[12] - c[13] - c[14] - c[15];
+	w[2] = (int64_t)c[2] + c[10] + c[11] - c[13] - c[14] - c[15];
+	w[3] = (int64_t)c[3] + 2 * (int64_t)c[11] + 2 * (int64_t)c[12] +
+	       c[13] - c[15] - c[8] - c[9];
+	w[4] = (int64_t)c[4] + 2 * (int64_t)c[12] + 2 * (int64_t)c[13] +
+	       c[14] - c[9] - c[10];
+	w[5] = (int64_t)c[5] + 2 * (int64_t)c[13] + 2 * (int64_t)c[14] +
+	       c[15] - c[10] - c[11];
+	w[6] = (int64_t)c[6] + 3 * (int64_t)c[14] + 2 * (int64_t)c[15] +
+	       c[13] - c[8] - c[9];
+	w[7] = (int64_t)c[7] + 3 * (int64_t)c[15] + c[8] - c[10] - c[11] -
+	       c[12] - c[13];
+
+	/*
+	 * Propagate carries, then fold the (small, signed) carry out of the
+	 * top limb back in using 2^256 = 2^224 - 2^192 - 2^96 + 1 (mod p).
+	 * Two folds are always enough to bring the value into [0, 2^256).
+	 */
+	for (i = 0; i < 3; i++) {
+		acc = 0;
+		for (n = 0; n < NLIMBS; n++) {
+			acc += w[n];
+			w[n] = (uint32_t)acc;
+			acc >>= 32;
+		}
+		w[0] += acc;
+		w[3] -= acc;
+		w[6] -= acc;
+		w[7] += acc;
+	}
+
+	for (n = 0; n < NLIMBS; n++)
+		r[n] = (uint32_t)w[n];
+
+	/* r < 2^256 < 2p, one conditional subtraction is enough */
+	borrow = limbs_sub(d, r, p256_p);
+	fe_cmov(r, d, borrow - 1);
+}
+
+/* r = a * b mod p */
+static void fe_mul(fe r, const fe a, const fe b)
+{
+	uint32_t c[2 * NLIMBS] = { 0 };
+	uint64_t t = 0;
+	size_t i = 0;
+	size_t j = 0;
+
+	for (i = 0; i < NLIMBS; i++) {
+		t = 0;
+		for (j = 0; j < NLIMBS; j++) {
+			t += (uint64_t)a[i] * b[j] + c[i + j];
+			c[i + j] = (uint32_t)t;
+			t >>= 32;
+		}
+		c[i + NLIMBS] = (uint32_t)t;
+	}
+
+	fe_reduce(r, c);
+}
+
+static void fe_sqr(fe r, const fe a)
+{
+	fe_mul(r, a, a);
+}
+
+/* r = a^(p - 2) = 1/a mod p */
+static void fe_inv(fe r, const fe a)
+{
+	fe t;
+	int n = 0;
+
+	memset(t, 0, sizeof(t));
+	t[0] = 1;
+	for (n = NLIMBS * 32 - 1; n >= 0; n--) {
+		fe_sqr(t, t);
+		if ((p256_p_minus_2[n / 32] >> (n % 32)) & 1)
+			fe_mul(t, t, a);
+	}
+	fe_copy(r, t);
+}
+
+/* Checks y^2 = x^3 - 3x + b */
+static bool fe_is_on_curve(const fe x, const fe y)
+{
+	fe lhs;
+	fe rhs;
+	fe t;
+
+	if (!fe_is_valid(x) || !fe_is_valid(y))
+		return false;
+
+	fe_sqr(lhs, y);
+	fe_sqr(rhs, x);
+	fe_mul(rhs, rhs, x);
+	fe_add(t, x, x);
+	fe_add(t, t, x);
+	fe_sub(rhs, rhs, t);
+	fe_add(rhs, rhs, p256_b);
+
+	return !memcmp(lhs, rhs, sizeof(fe));
+}
+
+static void point_set_affine(struct p256_point *r, const fe x, const fe y)
+{
+	fe_copy(r->x, x);
+	fe_copy(r->y, y);
+	memset(r->z, 0, sizeof(fe));
+	r->z[0] = 1;
+}
+
+static void point_cmov(struct p256_point *r, const struct p256_point *a,
+		       uint32_t mask)
+{
+	fe_cmov(r->x, a->x, mask);
+	fe_cmov(r->y, a->y, mask);
+	fe_cmov(r->z, a->z, mask);
+}
+
+/* r = 2a, "dbl-2001-b" for a = -3, r may alias a */
+static void point_double(struct p256_point *r, const struct p256_point *a)
+{
+	fe delta;
+	fe gamma;
+	fe beta;
+	fe alpha;
+	fe t1;
+	fe t2;
+
+	fe_sqr(delta, a->z);
+	fe_sqr(gamma, a->y);
+	fe_mul(beta, a->x, gamma);
+
+	/* alpha = 3 (x - delta) (x + delta) */
+	fe_sub(t1, a->x, delta);
+	fe_add(t2, a->x, delta);
+	fe_mul(alpha, t1, t2);
+	fe_add(t1, alpha, alpha);
+	fe_add(alpha, t1, alpha);
+
+	/* z3 = (y + z)^2 - gamma - delta */
+	fe_add(t1, a->y, a->z);
+	fe_sqr(t1, t1);
+	fe_sub(t1, t1, gamma);
+	fe_sub(r->z, t1, delta);
+
+	/* x3 = alpha^2 - 8 beta */
+	fe_add(beta, beta, beta);
+	fe_add(beta, beta, beta);
+	fe_add(t2, beta, beta);
+	fe_sqr(t1, alpha);
+	fe_sub(r->x, t1, t2);
+
+	/* y3 = alpha (4 beta - x3) - 8 gamma^2 */
+	fe_sub(t1, beta, r->x);
+	fe_mul(t1, alpha, t1);
+	fe_sqr(gamma, gamma);
+	fe_add(gamma, gamma, gamma);
+	fe_add(gamma, gamma, gamma);
+	fe_add(gamma, gamma, gamma);
+	fe_sub(r->y, t1, gamma);
+}
+
+/*
+ * r = a + b, "add-2007-bl", r may alias a or b. The point at infinity is
+ * handled with constant-time selects. a == b isn't, instead it branches
+ * to point_double(): this is only reached for a negligible fraction of
+ * the scalars.
+ */
+static void point_add(struct p256_point *r, const struct p256_point *a,
+		      const struct p256_point *b)
+{
+	struct p256_point res;
+	uint32_t a_inf = fe_is_zero(a->z);
+	uint32_t b_inf = fe_is_zero(b->z);
+	fe z1z1;
+	fe z2z2;
+	fe u1;
+	fe u2;
+	fe s1;
+	fe s2;
+	fe h;
+	fe i;
+	fe j;
+	fe rr;
+	fe v;
+	fe t;
+
+	fe_sqr(z1z1, a->z);
+	fe_sqr(z2z2, b->z);
+	fe_mul(u1, a->x, z2z2);
+	fe_mul(u2, b->x, z1z1);
+	fe_mul(s1, a->y, b->z);
+	fe_mul(s1, s1, z2z2);
+	fe_mul(s2, b->y, a->z);
+	fe_mul(s2, s2, z1z1);
+
+	fe_sub(h, u2, u1);
+	fe_sub(rr, s2, s1);
+
+	if (fe_is_zero(h) & fe_is_zero(rr) & ~a_inf & ~b_inf) {
+		point_double(r, a);
+		return;
+	}
+
+	fe_add(rr, rr, rr);
+	fe_add(i, h, h);
+	fe_sqr(i, i);
+	fe_mul(j, h, i);
+	fe_mul(v, u1, i);
+
+	/* x3 = r^2 - j - 2v */
+	fe_sqr(res.x, rr);
+	fe_sub(res.x, res.x, j);
+	fe_sub(res.x, res.x, v);
+	fe_sub(res.x, res.x, v);
+
+	/* y3 = r (v - x3) - 2 s1 j */
+	fe_sub(t, v, res.x);
+	fe_mul(t, rr, t);
+	fe_mul(s1, s1, j);
+	fe_add(s1, s1, s1);
+	fe_sub(res.y, t, s1);
+
+	/* z3 = ((z1 + z2)^2 - z1z1 - z2z2) h */
+	fe_add(t, a->z, b->z);
+	fe_sqr(t, t);
+	fe_sub(t, t, z1z1);
+	fe_sub(t, t, z2z2);
+	fe_mul(res.z, t, h);
+
+	point_cmov(&res, a, b_inf);
+	point_cmov(&res, b, a_inf);
+	*r = res;
+}
+
+static TEE_Result point_to_affine(fe x, fe y, const struct p256_point *a)
+{
+	fe zinv;
+	fe t;
+
+	if (fe_is_zero(a->z))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	fe_inv(zinv, a->z);
+	fe_sqr(t, zinv);
+	fe_mul(x, a->x, t);
+	fe_mul(t, t, zinv);
+	fe_mul(y, a->y, t);
+
+	return TEE_SUCCESS;
+}
+
+/* tab[n] = nP for n in [0, 16), tab[0] is the point at infinity */
+static void point_table(struct p256_point tab[16], const fe x, const fe y)
+{
+	size_t n = 0;
+
+	memset(tab, 0, sizeof(*tab));
+	point_set_affine(tab + 1, x, y);
+	point_double(tab + 2, tab + 1);
+	for (n = 3; n < 16; n++)
+		point_add(tab + n, tab + n - 1, tab + 1);
+}
+
+static unsigned int scalar_nibble(const uint8_t k[ECC_P256_BYTES], size_t n)
+{
+	return (k[ECC_P256_BYTES - 1 - n / 2] >> (4 * (n & 1))) & 0xf;
+}
+
+/* Loads tab[idx] into r reading the whole table */
+static void point_select(struct p256_point *r,
+			 const struct p256_point tab[16], unsigned int idx)
+{
+	uint32_t mask = 0;
+	size_t n = 0;
+
+	memset(r, 0, sizeof(*r));
+	for (n = 0; n < 16; n++) {
+		mask = ((uint32_t)(n ^ idx) - 1) >> 31;
+		point_cmov(r, tab + n, 0 - mask);
+	}
+}
+
+/* Fixed 4-bit window, constant time with respect to k */
+static void point_mul(struct p256_point *r, const uint8_t k[ECC_P256_BYTES],
+		      const fe x, const fe y)
+{
+	struct p256_point tab[16];
+	struct p256_point t;
+	size_t n = 0;
+
+	point_table(tab, x, y);
+	memset(r, 0, sizeof(*r));
+
+	for (n = 2 * ECC_P256_BYTES; n > 0; n--) {
+		point_double(r, r);
+		point_double(r, r);
+		point_double(r, r);
+		point_double(r, r);
+		point_select(&t, tab, scalar_nibble(k, n - 1));
+		point_add(r, r, &t);
+	}
+
+	memset(tab, 0, sizeof(tab));
+	memset(&t, 0, sizeof(t));
+}
+
+TEE_Result ecc_p256_mul(const uint8_t k[ECC_P256_BYTES],
+			const uint8_t px[ECC_P256_BYTES],
+			const uint8_t py[ECC_P256_BYTES],
+			uint8_t rx[ECC_P256_BYTES], uint8_t ry[ECC_P256_BYTES])
+{
+	struct p256_point r;
+	TEE_Result res = TEE_SUCCESS;
+	fe x;
+	fe y;
+
+	fe_from_bytes(x, px);
+	fe_from_bytes(y, py);
+	if (!fe_is_on_curve(x, y))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	point_mul(&r, k, x, y);
+	res = point_to_affine(x, y, &r);
+	if (!res) {
+		fe_to_bytes(rx, x);
+		if (ry)
+			fe_to_bytes(ry, y);
+	}
+
+	memset(&r, 0, sizeof(r));
+	return res;
+}
+
+TEE_Result ecc_p256_mul_base(const uint8_t k[ECC_P256_BYTES],
+			     uint8_t rx[ECC_P256_BYTES],
+			     uint8_t ry[ECC_P256_BYTES])
+{
+	struct p256_point r;
+	TEE_Result res = TEE_SUCCESS;
+	fe x;
+	fe y;
+
+	point_mul(&r, k, p256_gx, p256_gy);
+	res = point_to_affine(x, y, &r);
+	if (!res) {
+		fe_to_bytes(rx, x);
+		fe_to_bytes(ry, y);
+	}
+
+	memset(&r, 0, sizeof(r));
+	return res;
+}
+
+TEE_Result ecc_p256_mul2add(const uint8_t u1[ECC_P256_BYTES],
+			    const uint8_t u2[ECC_P256_BYTES],
+			    const uint8_t qx[ECC_P256_BYTES],
+			    const uint8_t qy[ECC_P256_BYTES],
+			    uint8_t rx[ECC_P256_BYTES])
+{
+	struct p256_point gtab[16];
+	struct p256_point qtab[16];
+	struct p256_point r;
+	TEE_Result res = TEE_SUCCESS;
+	unsigned int n1 = 0;
+	unsigned int n2 = 0;
+	size_t n = 0;
+	fe x;
+	fe y;
+
+	fe_from_bytes(x, qx);
+	fe_from_bytes(y, qy);
+	if (!fe_is_on_curve(x, y))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Shamir's trick, only public values are involved */
+	point_table(gtab, p256_gx, p256_gy);
+	point_table(qtab, x, y);
+	memset(&r, 0, sizeof(r));
+
+	for (n = 2 * ECC_P256_BYTES; n > 0; n--) {
+		point_double(&r, &r);
+		point_double(&r, &r);
+		point_double(&r, &r);
+		point_double(&r, &r);
+		n1 = scalar_nibble(u1, n - 1);
+		n2 = scalar_nibble(u2, n - 1);
+		if (n1)
+			point_add(&r, &r, gtab + n1);
+		if (n2)
+			point_add(&r, &r, qtab + n2);
+	}
+
+	res = point_to_affine(x, y, &r);
+	if (!res)
+		fe_to_bytes(rx, x);
+
+	return res;
+}
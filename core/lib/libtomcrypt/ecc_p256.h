@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2019, agent
+ */
+#ifndef ECC_P256_H
+#define ECC_P256_H
+
+#include <stdint.h>
+#include <tee_api_types.h>
+
+/*
+ * Point multiplications on NIST P-256 using fixed size limbs and Solinas
+ * reduction, without any heap allocation. Scalars and coordinates are
+ * 32 bytes big endian. Input points are checked to be on the curve.
+ *
+ * Returns TEE_ERROR_BAD_PARAMETERS if an input point isn't on the curve
+ * or if the result is the point at infinity.
+ */
+#define ECC_P256_BYTES	32
+
+/* R = kP, constant time with respect to k */
+TEE_Result ecc_p256_mul(const uint8_t k[ECC_P256_BYTES],
+			const uint8_t px[ECC_P256_BYTES],
+			const uint8_t py[ECC_P256_BYTES],
+			uint8_t rx[ECC_P256_BYTES], uint8_t ry[ECC_P256_BYTES]);
+
+/* R = kG, constant time with respect to k */
+TEE_Result ecc_p256_mul_base(const uint8_t k[ECC_P256_BYTES],
+			     uint8_t rx[ECC_P256_BYTES],
+			     uint8_t ry[ECC_P256_BYTES]);
+
+/* R = u1 G + u2 Q, variable time, only the x coordinate is returned */
+TEE_Result ecc_p256_mul2add(const uint8_t u1[ECC_P256_BYTES],
+			    const uint8_t u2[ECC_P256_BYTES],
+			    const uint8_t qx[ECC_P256_BYTES],
+			    const uint8_t qy[ECC_P256_BYTES],
+			    uint8_t rx[ECC_P256_BYTES]);
+
+#endif /*ECC_P256_H*/
@@ -246,6 +246,11 @@
    /* Timing Resistant */
    #define LTC_ECC_TIMING_RESISTANT
 
+   /* precomputed constant time comb for multiplications by the generator */
+   #ifdef _CFG_CORE_LTC_ECC_FIXED_BASE
+   #define LTC_ECC_FIXED_BASE
+   #endif
+
    #define LTC_ECC192
    #define LTC_ECC224
    #define LTC_ECC256
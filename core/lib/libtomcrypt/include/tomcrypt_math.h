@@ -368,6 +368,16 @@ typedef struct {
    */
    int (*exptmod)(void *a, void *b, void *c, void *d);
 
+   /** (optional) Modular exponentiation with a precomputed context
+       @param a    The base integer
+       @param b    The power integer
+       @param c    The modulus integer
+       @param mp   The "b" value from montgomery_setup() for c
+       @param d    The destination
+       @return CRYPT_OK on success
+   */
+   int (*exptmod_mont)(void *a, void *b, void *c, void *mp, void *d);
+
    /** Primality testing
        @param a     The integer to test
        @param b     The number of tests that shall be executed
@@ -542,6 +552,7 @@ extern const ltc_math_descriptor gmp_desc;
 #define mp_montgomery_free(a)        ltc_mp.montgomery_deinit(a)
 
 #define mp_exptmod(a,b,c,d)          ltc_mp.exptmod(a,b,c,d)
+#define mp_exptmod_mont(a,b,c,m,d)   ltc_mp.exptmod_mont(a,b,c,m,d)
 #define mp_prime_is_prime(a, b, c)   ltc_mp.isprime(a,b,c)
 
 #define mp_iszero(a)                 (mp_cmp_d(a, 0) == LTC_MP_EQ ? LTC_MP_YES : LTC_MP_NO)
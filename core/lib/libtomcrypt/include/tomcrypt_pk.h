@@ -79,6 +79,8 @@ typedef struct Rsa_key {
     void *dP; 
     /** The d mod (q - 1) CRT param */
     void *dQ;
+    /** Optional montgomery_setup() contexts for N, p and q, or NULL */
+    void *mont_N, *mont_p, *mont_q;
 } rsa_key;
 
 int rsa_make_key(prng_state *prng, int wprng, int size, long e, rsa_key *key);
@@ -353,6 +355,13 @@ void ltc_ecc_fp_tablelock(int lock);
 /* R = kG */
 int ltc_ecc_mulmod(void *k, ecc_point *G, ecc_point *R, void *modulus, int map);
 
+#ifdef LTC_ECC_FIXED_BASE
+/* R = kG where G is the generator of dp, constant time comb */
+int ltc_ecc_fixed_base_init(void);
+int ltc_ecc_fixed_base_mulmod(void *k, const ltc_ecc_set_type *dp,
+                              ecc_point *R, void *modulus, int map);
+#endif
+
 #ifdef LTC_ECC_SHAMIR
 /* kA*A + kB*B = C */
 int ltc_ecc_mul2add(ecc_point *A, void *kA,
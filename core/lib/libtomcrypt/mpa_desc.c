@@ -567,19 +567,16 @@ static void montgomery_deinit(void *a)
  * @a: base
  * @b: exponent
  * @c: modulus
+ * @c_mont: Montgomery context of c from montgomery_setup()
  * @d: destination
  */
-static int exptmod(void *a, void *b, void *c, void *d)
+static int exptmod_mont(void *a, void *b, void *c, void *c_mont, void *d)
 {
 	LTC_ARGCHK(a != NULL);
 	LTC_ARGCHK(b != NULL);
 	LTC_ARGCHK(c != NULL);
+	LTC_ARGCHK(c_mont != NULL);
 	LTC_ARGCHK(d != NULL);
-	void *c_mont;
-	if (montgomery_setup(c, &c_mont) != CRYPT_OK) {
-		return CRYPT_MEM;
-	}
-
 	void *d_tmp;
 	int memguard;
 
@@ -591,10 +588,8 @@ static int exptmod(void *a, void *b, void *c, void *d)
 	 * variable.
 	 */
 	if (memguard) {
-		if (init(&d_tmp) != CRYPT_OK) {
-			montgomery_deinit(c_mont);
+		if (init(&d_tmp) != CRYPT_OK)
 			return CRYPT_MEM;
-		}
 	} else {
 		d_tmp = d;
 	}
@@ -614,8 +609,6 @@ static int exptmod(void *a, void *b, void *c, void *d)
 		    ((mpa_fmm_context)c_mont)->n_inv,
 		    external_mem_pool);
 
-	montgomery_deinit(c_mont);
-
 	if (memguard) {
 		deinit(d_tmp);
 	}
@@ -623,6 +616,19 @@ static int exptmod(void *a, void *b, void *c, void *d)
 	return CRYPT_OK;
 }
 
+static int exptmod(void *a, void *b, void *c, void *d)
+{
+	void *c_mont;
+	int res;
+
+	if (montgomery_setup(c, &c_mont) != CRYPT_OK)
+		return CRYPT_MEM;
+	res = exptmod_mont(a, b, c, c_mont, d);
+	montgomery_deinit(c_mont);
+
+	return res;
+}
+
 static int isprime(void *a, int b, int *c)
 {
 	LTC_ARGCHK(a != NULL);
@@ -690,6 +696,7 @@ ltc_math_descriptor ltc_mp = {
 	.montgomery_deinit = &montgomery_deinit,
 
 	.exptmod = &exptmod,
+	.exptmod_mont = &exptmod_mont,
 	.isprime = &isprime,
 
 #ifdef LTC_MECC
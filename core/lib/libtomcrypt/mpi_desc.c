@@ -472,14 +472,31 @@ static int invmod(void *a, void *b, void *c)
 }
 
 
+/*
+ * Montgomery context. @mm must be first since montgomery_reduce() only
+ * dereferences the context as a mbedtls_mpi_uint. @rr is R^2 mod N, only
+ * computed by the first exptmod_mont() and reused by the following ones,
+ * R depends on the number of limbs of N which is saved in @rr_limbs.
+ */
+struct mont_ctx {
+	mbedtls_mpi_uint mm;
+	mbedtls_mpi rr;
+	size_t rr_limbs;
+};
+
 /* setup */
 static int montgomery_setup(void *a, void **b)
 {
-	*b = malloc(sizeof(mbedtls_mpi_uint));
-	if (!*b)
+	struct mont_ctx *ctx = malloc(sizeof(*ctx));
+
+	if (!ctx)
 		return CRYPT_MEM;
 
-	mbedtls_mpi_montg_init(*b, a);
+	mbedtls_mpi_montg_init(&ctx->mm, a);
+	/* Not from the mempool, @rr may outlive the current operation */
+	mbedtls_mpi_init(&ctx->rr);
+	ctx->rr_limbs = 0;
+	*b = ctx;
 
 	return CRYPT_OK;
 }
@@ -542,7 +559,10 @@ out:
 /* clean up */
 static void montgomery_deinit(void *a)
 {
-	free(a);
+	struct mont_ctx *ctx = a;
+
+	mbedtls_mpi_free(&ctx->rr);
+	free(ctx);
 }
 
 /*
@@ -576,6 +596,42 @@ static int exptmod(void *a, void *b, void *c, void *d)
 		return CRYPT_OK;
 }
 
+/*
+ * Same as exptmod() but with @c_mont from montgomery_setup() of @c, which
+ * caches R^2 mod @c between calls.
+ */
+static int exptmod_mont(void *a, void *b, void *c, void *c_mont, void *d)
+{
+	struct mont_ctx *ctx = c_mont;
+	mbedtls_mpi *N = c;
+	mbedtls_mpi dest;
+	int res = 0;
+
+	if (!ctx->rr.p || ctx->rr_limbs != N->n) {
+		ctx->rr_limbs = N->n;
+		res = mbedtls_mpi_lset(&ctx->rr, 1);
+		if (!res)
+			res = mbedtls_mpi_shift_l(&ctx->rr, N->n * 2 * biL);
+		if (!res)
+			res = mbedtls_mpi_mod_mpi(&ctx->rr, &ctx->rr, N);
+		if (res) {
+			mbedtls_mpi_free(&ctx->rr);
+			return CRYPT_MEM;
+		}
+	}
+
+	mbedtls_mpi_init_mempool(&dest);
+	res = mbedtls_mpi_exp_mod(&dest, a, b, N, &ctx->rr);
+	if (!res)
+		res = mbedtls_mpi_copy(d, &dest);
+	mbedtls_mpi_free(&dest);
+
+	if (res)
+		return CRYPT_MEM;
+	else
+		return CRYPT_OK;
+}
+
 static int rng_read(void *ignored __unused, unsigned char *buf, size_t blen)
 {
 	if (crypto_rng_read(buf, blen))
@@ -658,6 +714,7 @@ ltc_math_descriptor ltc_mp = {
 	.montgomery_deinit = &montgomery_deinit,
 
 	.exptmod = &exptmod,
+	.exptmod_mont = &exptmod_mont,
 	.isprime = &isprime,
 
 #ifdef LTC_MECC
@@ -176,6 +176,115 @@ TEE_Result crypto_acipher_gen_rsa_key(struct rsa_keypair *key, size_t key_size)
 	return res;
 }
 
+/*
+ * Montgomery contexts of N, p and q, computed on the first private key
+ * operation and kept in struct rsa_keypair::precomp for the following
+ * ones. The moduli are kept too so that a key updated in place is
+ * detected and the contexts are recomputed.
+ */
+struct rsa_precomp {
+	struct bignum *n;
+	struct bignum *p;
+	struct bignum *q;
+	void *mont_n;
+	void *mont_p;
+	void *mont_q;
+};
+
+static void rsa_precomp_free(struct rsa_precomp *pc)
+{
+	if (!pc)
+		return;
+	if (pc->mont_n)
+		mp_montgomery_free(pc->mont_n);
+	if (pc->mont_p)
+		mp_montgomery_free(pc->mont_p);
+	if (pc->mont_q)
+		mp_montgomery_free(pc->mont_q);
+	crypto_bignum_free(pc->n);
+	crypto_bignum_free(pc->p);
+	crypto_bignum_free(pc->q);
+	free(pc);
+}
+
+static bool rsa_precomp_setup(struct bignum *m, struct bignum **copy,
+			      void **mont)
+{
+	*copy = crypto_bignum_allocate(crypto_bignum_num_bits(m));
+	if (!*copy)
+		return false;
+	crypto_bignum_copy(*copy, m);
+
+	return mp_montgomery_setup(m, mont) == CRYPT_OK;
+}
+
+static bool rsa_precomp_match(struct bignum *a, struct bignum *b)
+{
+	if (!a)
+		return !b || !crypto_bignum_num_bytes(b);
+	return !crypto_bignum_compare(a, b);
+}
+
+/* Returns NULL if out of memory, the operation then runs without it */
+static struct rsa_precomp *rsa_precomp_get(struct rsa_keypair *key)
+{
+	struct rsa_precomp *pc = key->precomp;
+	bool crt = key->p && crypto_bignum_num_bytes(key->p);
+
+	if (pc && rsa_precomp_match(pc->n, key->n) &&
+	    rsa_precomp_match(pc->p, key->p) &&
+	    rsa_precomp_match(pc->q, key->q))
+		return pc;
+
+	crypto_acipher_free_rsa_precomp(key);
+
+	pc = calloc(1, sizeof(*pc));
+	if (!pc)
+		return NULL;
+	if (!rsa_precomp_setup(key->n, &pc->n, &pc->mont_n))
+		goto err;
+	if (crt) {
+		if (!rsa_precomp_setup(key->p, &pc->p, &pc->mont_p))
+			goto err;
+		if (!rsa_precomp_setup(key->q, &pc->q, &pc->mont_q))
+			goto err;
+	}
+
+	key->precomp = pc;
+	return pc;
+err:
+	rsa_precomp_free(pc);
+	return NULL;
+}
+
+void crypto_acipher_free_rsa_precomp(struct rsa_keypair *s)
+{
+	rsa_precomp_free(s->precomp);
+	s->precomp = NULL;
+}
+
+static void rsa_keypair_to_ltc(struct rsa_keypair *key, rsa_key *ltc_key)
+{
+	struct rsa_precomp *pc = rsa_precomp_get(key);
+
+	ltc_key->type = PK_PRIVATE;
+	ltc_key->e = key->e;
+	ltc_key->d = key->d;
+	ltc_key->N = key->n;
+	if (key->p && crypto_bignum_num_bytes(key->p)) {
+		ltc_key->p = key->p;
+		ltc_key->q = key->q;
+		ltc_key->qP = key->qp;
+		ltc_key->dP = key->dp;
+		ltc_key->dQ = key->dq;
+	}
+	if (pc) {
+		ltc_key->mont_N = pc->mont_n;
+		ltc_key->mont_p = pc->mont_p;
+		ltc_key->mont_q = pc->mont_q;
+	}
+}
+
 static TEE_Result rsadorep(rsa_key *ltc_key, const uint8_t *src,
 			   size_t src_len, uint8_t *dst, size_t *dst_len)
 {
@@ -259,17 +368,7 @@ TEE_Result crypto_acipher_rsanopad_decrypt(struct rsa_keypair *key,
 	TEE_Result res;
 	rsa_key ltc_key = { 0, };
 
-	ltc_key.type = PK_PRIVATE;
-	ltc_key.e = key->e;
-	ltc_key.N = key->n;
-	ltc_key.d = key->d;
-	if (key->p && crypto_bignum_num_bytes(key->p)) {
-		ltc_key.p = key->p;
-		ltc_key.q = key->q;
-		ltc_key.qP = key->qp;
-		ltc_key.dP = key->dp;
-		ltc_key.dQ = key->dq;
-	}
+	rsa_keypair_to_ltc(key, &ltc_key);
 
 	res = rsadorep(&ltc_key, src, src_len, dst, dst_len);
 	return res;
@@ -287,17 +386,7 @@ TEE_Result crypto_acipher_rsaes_decrypt(uint32_t algo, struct rsa_keypair *key,
 	size_t mod_size;
 	rsa_key ltc_key = { 0, };
 
-	ltc_key.type = PK_PRIVATE;
-	ltc_key.e = key->e;
-	ltc_key.d = key->d;
-	ltc_key.N = key->n;
-	if (key->p && crypto_bignum_num_bytes(key->p)) {
-		ltc_key.p = key->p;
-		ltc_key.q = key->q;
-		ltc_key.qP = key->qp;
-		ltc_key.dP = key->dp;
-		ltc_key.dQ = key->dq;
-	}
+	rsa_keypair_to_ltc(key, &ltc_key);
 
 	/* Get the algorithm */
 	res = tee_algo_to_ltc_hashindex(algo, &ltc_hashindex);
@@ -439,17 +528,7 @@ TEE_Result crypto_acipher_rsassa_sign(uint32_t algo, struct rsa_keypair *key,
 	unsigned long ltc_sig_len;
 	rsa_key ltc_key = { 0, };
 
-	ltc_key.type = PK_PRIVATE;
-	ltc_key.e = key->e;
-	ltc_key.N = key->n;
-	ltc_key.d = key->d;
-	if (key->p && crypto_bignum_num_bytes(key->p)) {
-		ltc_key.p = key->p;
-		ltc_key.q = key->q;
-		ltc_key.qP = key->qp;
-		ltc_key.dP = key->dp;
-		ltc_key.dQ = key->dq;
-	}
+	rsa_keypair_to_ltc(key, &ltc_key);
 
 	switch (algo) {
 	case TEE_ALG_RSASSA_PKCS1_V1_5:
@@ -132,7 +132,15 @@ int ecc_make_key_ex(prng_state *prng, int wprng, ecc_key *key, const ltc_ecc_set
        if((err = mp_mod(key->k, order, key->k)) != CRYPT_OK)                                    { goto errkey; }
    }
    /* make the public key */
-   if ((err = ltc_mp.ecc_ptmul(key->k, base, &key->pubkey, prime, 1)) != CRYPT_OK)              { goto errkey; }
+#ifdef LTC_ECC_FIXED_BASE
+   err = ltc_ecc_fixed_base_mulmod(key->k, key->dp, &key->pubkey, prime, 1);
+   if (err == CRYPT_NOP) {
+      err = ltc_mp.ecc_ptmul(key->k, base, &key->pubkey, prime, 1);
+   }
+#else
+   err = ltc_mp.ecc_ptmul(key->k, base, &key->pubkey, prime, 1);
+#endif
+   if (err != CRYPT_OK)                                                                         { goto errkey; }
    key->type = PK_PRIVATE;
 
    /* free up ram */
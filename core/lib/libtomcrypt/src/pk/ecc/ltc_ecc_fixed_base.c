@@ -0,0 +1,441 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2019, agent
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* LibTomCrypt, modular cryptographic library -- Tom St Denis
+ *
+ * LibTomCrypt is a library that provides various cryptographic
+ * algorithms in a highly modular and flexible manner.
+ *
+ * The library is free for all purposes without any express
+ * guarantee it works.
+ *
+ * Tom St Denis, tomstdenis@gmail.com, http://libtom.org
+ */
+
+#include <string.h>
+#include "tomcrypt.h"
+
+/**
+  @file ltc_ecc_fixed_base.c
+  Constant-time multiplication by the generator of the NIST curves using a
+  precomputed signed odd comb (the same recoding as used by mbed TLS).
+*/
+
+#ifdef LTC_ECC_FIXED_BASE
+
+/*
+ * Comb width: the table holds 2^(W-1) affine points and a multiplication
+ * costs ceil(nbits / W) doublings and additions.
+ */
+#define FB_W		5
+#define FB_TSIZE	(1 << (FB_W - 1))
+#define FB_MAX_D	((LTC_MAX_ECC + FB_W - 1) / FB_W)
+#define FB_MAX_CURVES	3
+
+/*
+ * Each table entry is stored as x | y | p - y, every coordinate in
+ * Montgomery form and big endian on @len bytes. Storing the negated y
+ * allows point negation to be done with a masked byte select.
+ */
+struct fb_table {
+	const ltc_ecc_set_type *dp;
+	unsigned long len;
+	unsigned long d;
+	unsigned char *tab;
+};
+
+static struct fb_table fb_tables[FB_MAX_CURVES];
+
+static const struct fb_table *fb_find(const ltc_ecc_set_type *dp)
+{
+	int n;
+
+	for (n = 0; n < FB_MAX_CURVES; n++)
+		if (fb_tables[n].dp == dp && fb_tables[n].tab)
+			return fb_tables + n;
+	return NULL;
+}
+
+/* Writes @a as a big endian number of exactly @len bytes */
+static int fb_write(void *a, unsigned char *buf, unsigned long len)
+{
+	unsigned long sz = mp_unsigned_bin_size(a);
+
+	if (sz > len)
+		return CRYPT_BUFFER_OVERFLOW;
+	memset(buf, 0, len);
+	return mp_to_unsigned_bin(a, buf + len - sz);
+}
+
+/* Returns 0xff if @a == @b, 0 otherwise, without branching */
+static unsigned char fb_ct_eq(unsigned long a, unsigned long b)
+{
+	unsigned long d = ((a ^ b) - 1) >> (sizeof(unsigned long) * 8 - 1);
+
+	return (unsigned char)(d * 0xff);
+}
+
+static int fb_build(struct fb_table *t, const ltc_ecc_set_type *dp)
+{
+	ecc_point *T[FB_TSIZE] = { NULL };
+	ecc_point *P = NULL;
+	void *prime = NULL;
+	void *order = NULL;
+	void *mu = NULL;
+	void *mp = NULL;
+	unsigned char *e = NULL;
+	unsigned long nbits = 0;
+	unsigned long i = 0;
+	unsigned long j = 0;
+	int err = CRYPT_OK;
+
+	if ((err = mp_init_multi(&prime, &order, &mu, NULL)) != CRYPT_OK)
+		return err;
+	if ((err = mp_read_radix(prime, (char *)dp->prime, 16)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_read_radix(order, (char *)dp->order, 16)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_montgomery_setup(prime, &mp)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_montgomery_normalization(mu, prime)) != CRYPT_OK)
+		goto out;
+
+	t->len = mp_unsigned_bin_size(prime);
+	nbits = mp_count_bits(order);
+	t->d = (nbits + FB_W - 1) / FB_W;
+	if (t->d > FB_MAX_D || (nbits + 7) / 8 > t->len) {
+		err = CRYPT_INVALID_ARG;
+		goto out;
+	}
+
+	P = ltc_ecc_new_point();
+	if (!P) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+	for (i = 0; i < FB_TSIZE; i++) {
+		T[i] = ltc_ecc_new_point();
+		if (!T[i]) {
+			err = CRYPT_MEM;
+			goto out;
+		}
+	}
+
+	/* P = G in Montgomery form */
+	if ((err = mp_read_radix(P->x, (char *)dp->Gx, 16)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_read_radix(P->y, (char *)dp->Gy, 16)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_mulmod(P->x, mu, prime, P->x)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_mulmod(P->y, mu, prime, P->y)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_copy(mu, P->z)) != CRYPT_OK)
+		goto out;
+
+	/*
+	 * T[i] = G + i_0 * 2^d G + ... + i_(W-2) * 2^((W-1)d) G where
+	 * i_(W-2)...i_0 is the binary representation of i.
+	 */
+	if ((err = mp_copy(P->x, T[0]->x)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_copy(P->y, T[0]->y)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_copy(P->z, T[0]->z)) != CRYPT_OK)
+		goto out;
+	for (j = 1; j < FB_W; j++) {
+		for (i = 0; i < t->d; i++) {
+			err = ltc_mp.ecc_ptdbl(P, P, prime, mp);
+			if (err != CRYPT_OK)
+				goto out;
+		}
+		for (i = 0; i < (1UL << (j - 1)); i++) {
+			err = ltc_mp.ecc_ptadd(T[i], P, T[i + (1 << (j - 1))],
+					       prime, mp);
+			if (err != CRYPT_OK)
+				goto out;
+		}
+	}
+
+	e = XCALLOC(FB_TSIZE, 3 * t->len);
+	if (!e) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+	for (i = 0; i < FB_TSIZE; i++) {
+		unsigned char *ent = e + i * 3 * t->len;
+
+		/* Affine, then back to Montgomery form */
+		if ((err = ltc_ecc_map(T[i], prime, mp)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_mulmod(T[i]->x, mu, prime, T[i]->x)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_mulmod(T[i]->y, mu, prime, T[i]->y)) != CRYPT_OK)
+			goto out;
+		if ((err = fb_write(T[i]->x, ent, t->len)) != CRYPT_OK)
+			goto out;
+		if ((err = fb_write(T[i]->y, ent + t->len, t->len)) != CRYPT_OK)
+			goto out;
+		if ((err = mp_sub(prime, T[i]->y, T[i]->y)) != CRYPT_OK)
+			goto out;
+		err = fb_write(T[i]->y, ent + 2 * t->len, t->len);
+		if (err != CRYPT_OK)
+			goto out;
+	}
+
+	t->tab = e;
+	t->dp = dp;
+	e = NULL;
+out:
+	XFREE(e);
+	for (i = 0; i < FB_TSIZE; i++)
+		ltc_ecc_del_point(T[i]);
+	ltc_ecc_del_point(P);
+	if (mp)
+		mp_montgomery_free(mp);
+	mp_clear_multi(prime, order, mu, NULL);
+	return err;
+}
+
+/**
+  Precompute the comb tables of the P-256, P-384 and P-521 generators.
+  Curves for which this fails are left to the generic point multiplication.
+  @return CRYPT_OK if all tables could be built
+*/
+int ltc_ecc_fixed_base_init(void)
+{
+	int res = CRYPT_OK;
+	int err = CRYPT_OK;
+	int n = 0;
+	int x = 0;
+
+	for (x = 0; ltc_ecc_sets[x].size != 0 && n < FB_MAX_CURVES; x++) {
+		if (ltc_ecc_sets[x].size < 32)
+			continue;
+		err = fb_build(fb_tables + n, ltc_ecc_sets + x);
+		if (err == CRYPT_OK)
+			n++;
+		else
+			res = err;
+	}
+
+	return res;
+}
+
+/*
+ * Splits the odd scalar @m (big endian, @len bytes) into d + 1 comb
+ * columns and recodes them so that every column is odd: bits 0-6 of x[i]
+ * hold the column value and bit 7 whether the point must be negated.
+ */
+static void fb_recode(unsigned char x[FB_MAX_D + 1], unsigned long d,
+		      const unsigned char *m, unsigned long len)
+{
+	unsigned long i = 0;
+	unsigned long j = 0;
+	unsigned long b = 0;
+	unsigned char c = 0;
+	unsigned char cc = 0;
+	unsigned char adjust = 0;
+
+	memset(x, 0, FB_MAX_D + 1);
+
+	for (i = 0; i < d; i++) {
+		for (j = 0; j < FB_W; j++) {
+			b = i + d * j;
+			if (b >= len * 8)
+				break;
+			x[i] |= ((m[len - 1 - b / 8] >> (b % 8)) & 1) << j;
+		}
+	}
+
+	for (i = 1; i <= d; i++) {
+		/* Add carry and update it */
+		cc = x[i] & c;
+		x[i] = x[i] ^ c;
+		c = cc;
+
+		/* Adjust if needed, avoiding branches */
+		adjust = 1 - (x[i] & 0x01);
+		c |= x[i] & (x[i - 1] * adjust);
+		x[i] = x[i] ^ (x[i - 1] * adjust);
+		x[i - 1] |= adjust << 7;
+	}
+}
+
+/*
+ * Loads the signed table entry @x into the affine point @Q, touching every
+ * entry of the table so that the access pattern is independent of @x.
+ */
+static int fb_select(const struct fb_table *t, unsigned char x,
+		     unsigned char *buf, ecc_point *Q)
+{
+	const unsigned char *ent = NULL;
+	unsigned long idx = (x & 0x7f) >> 1;
+	unsigned char neg = -(unsigned char)(x >> 7);
+	unsigned char m = 0;
+	unsigned long i = 0;
+	unsigned long j = 0;
+	int err = CRYPT_OK;
+
+	memset(buf, 0, 2 * t->len);
+	for (i = 0; i < FB_TSIZE; i++) {
+		ent = t->tab + i * 3 * t->len;
+		m = fb_ct_eq(i, idx);
+		for (j = 0; j < t->len; j++) {
+			buf[j] |= ent[j] & m;
+			buf[t->len + j] |= ((ent[t->len + j] & ~neg) |
+					    (ent[2 * t->len + j] & neg)) & m;
+		}
+	}
+
+	if ((err = mp_read_unsigned_bin(Q->x, buf, t->len)) != CRYPT_OK)
+		return err;
+	return mp_read_unsigned_bin(Q->y, buf + t->len, t->len);
+}
+
+/**
+  Perform a point multiplication by the generator of the curve (constant
+  time with respect to the scalar)
+  @param k        The scalar to multiply by, 0 <= k < order
+  @param dp       The curve, the base point is dp->Gx, dp->Gy
+  @param R        [out] Destination for kG
+  @param modulus  The modulus of the field the ECC curve is in
+  @param map      Boolean whether to map back to affine or not (1==map, 0 == leave in projective)
+  @return CRYPT_OK on success, CRYPT_NOP if no table exists for this curve
+*/
+int ltc_ecc_fixed_base_mulmod(void *k, const ltc_ecc_set_type *dp,
+			      ecc_point *R, void *modulus, int map)
+{
+	const struct fb_table *t = NULL;
+	unsigned char x[FB_MAX_D + 1] = { 0 };
+	unsigned char kb[ECC_MAXSIZE] = { 0 };
+	unsigned char nkb[ECC_MAXSIZE] = { 0 };
+	unsigned char buf[2 * ECC_MAXSIZE] = { 0 };
+	unsigned char even = 0;
+	ecc_point Q = { NULL, NULL, NULL };
+	void *order = NULL;
+	void *mu = NULL;
+	void *mp = NULL;
+	unsigned long i = 0;
+	int err = CRYPT_OK;
+
+	LTC_ARGCHK(k       != NULL);
+	LTC_ARGCHK(dp      != NULL);
+	LTC_ARGCHK(R       != NULL);
+	LTC_ARGCHK(modulus != NULL);
+
+	t = fb_find(dp);
+	if (!t)
+		return CRYPT_NOP;
+
+	if ((err = mp_init_multi(&order, &mu, &Q.x, &Q.y, NULL)) != CRYPT_OK)
+		return err;
+	if ((err = mp_montgomery_setup(modulus, &mp)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_montgomery_normalization(mu, modulus)) != CRYPT_OK)
+		goto out;
+
+	/*
+	 * The comb needs an odd scalar: use order - k when k is even and
+	 * negate the result. Both candidates are computed and the choice is
+	 * made with a mask.
+	 */
+	if ((err = mp_read_radix(order, (char *)dp->order, 16)) != CRYPT_OK)
+		goto out;
+	if ((err = fb_write(k, kb, t->len)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_sub(order, k, order)) != CRYPT_OK)
+		goto out;
+	if ((err = fb_write(order, nkb, t->len)) != CRYPT_OK)
+		goto out;
+	even = (kb[t->len - 1] & 1) - 1;
+	for (i = 0; i < t->len; i++)
+		kb[i] = (kb[i] & ~even) | (nkb[i] & even);
+
+	fb_recode(x, t->d, kb, t->len);
+
+	/* R = T[x_d] */
+	if ((err = fb_select(t, x[t->d], buf, &Q)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_copy(Q.x, R->x)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_copy(Q.y, R->y)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_copy(mu, R->z)) != CRYPT_OK)
+		goto out;
+
+	/* R = 2R + T[x_i] with Q->z == NULL selecting the mixed addition */
+	for (i = t->d; i > 0; i--) {
+		if ((err = ltc_mp.ecc_ptdbl(R, R, modulus, mp)) != CRYPT_OK)
+			goto out;
+		if ((err = fb_select(t, x[i - 1], buf, &Q)) != CRYPT_OK)
+			goto out;
+		err = ltc_mp.ecc_ptadd(R, &Q, R, modulus, mp);
+		if (err != CRYPT_OK)
+			goto out;
+	}
+
+	/*
+	 * A zero Z means that one of the mixed additions hit R == +-T[x_i],
+	 * which the mixed addition doesn't handle. This only happens for
+	 * a negligible fraction of the scalars, let the caller use the
+	 * generic point multiplication instead.
+	 */
+	if (mp_iszero(R->z) == LTC_MP_YES) {
+		err = CRYPT_NOP;
+		goto out;
+	}
+
+	/* Negate R if order - k was used */
+	if ((err = fb_write(R->y, kb, t->len)) != CRYPT_OK)
+		goto out;
+	if ((err = mp_sub(modulus, R->y, Q.y)) != CRYPT_OK)
+		goto out;
+	if ((err = fb_write(Q.y, nkb, t->len)) != CRYPT_OK)
+		goto out;
+	for (i = 0; i < t->len; i++)
+		kb[i] = (kb[i] & ~even) | (nkb[i] & even);
+	if ((err = mp_read_unsigned_bin(R->y, kb, t->len)) != CRYPT_OK)
+		goto out;
+
+	if (map)
+		err = ltc_ecc_map(R, modulus, mp);
+out:
+#ifdef LTC_CLEAN_STACK
+	zeromem(x, sizeof(x));
+	zeromem(kb, sizeof(kb));
+	zeromem(nkb, sizeof(nkb));
+	zeromem(buf, sizeof(buf));
+#endif
+	if (mp)
+		mp_montgomery_free(mp);
+	mp_clear_multi(order, mu, Q.x, Q.y, NULL);
+	return err;
+}
+
+#endif /*LTC_ECC_FIXED_BASE*/
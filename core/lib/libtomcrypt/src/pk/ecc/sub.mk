@@ -4,6 +4,7 @@ srcs-y += ecc_make_key.c
 srcs-y += ecc_shared_secret.c
 srcs-y += ecc_sign_hash.c
 srcs-y += ecc_verify_hash.c
+srcs-y += ltc_ecc_fixed_base.c
 srcs-y += ltc_ecc_is_valid_idx.c
 srcs-y += ltc_ecc_map.c
 srcs-y += ltc_ecc_mulmod.c
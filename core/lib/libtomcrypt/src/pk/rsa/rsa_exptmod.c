@@ -47,6 +47,15 @@
 
 #ifdef LTC_MRSA
 
+/* d = a^b mod c, reusing the precomputed context of c if there is one */
+static int rsa_exptmod_ctx(void *a, void *b, void *c, void *mont, void *d)
+{
+   if (mont != NULL && ltc_mp.exptmod_mont != NULL) {
+      return mp_exptmod_mont(a, b, c, mont, d);
+   }
+   return mp_exptmod(a, b, c, d);
+}
+
 /** 
    Compute an RSA modular exponentiation 
    @param in         The input data to send into RSA
@@ -114,7 +123,7 @@ int rsa_exptmod(const unsigned char *in,   unsigned long inlen,
       }
 
       /* rnd = rnd^e */
-      err = mp_exptmod( rnd, key->e, key->N, rnd);
+      err = rsa_exptmod_ctx( rnd, key->e, key->N, key->mont_N, rnd);
       if (err != CRYPT_OK) {
              goto error;
       }
@@ -133,13 +142,13 @@ int rsa_exptmod(const unsigned char *in,   unsigned long inlen,
           * In case CRT optimization parameters are not provided,
           * the private key is directly used to exptmod it
           */
-         if ((err = mp_exptmod(tmp, key->d, key->N, tmp)) != CRYPT_OK)                              { goto error; }
+         if ((err = rsa_exptmod_ctx(tmp, key->d, key->N, key->mont_N, tmp)) != CRYPT_OK)            { goto error; }
       } else {
          /* tmpa = tmp^dP mod p */
-         if ((err = mp_exptmod(tmp, key->dP, key->p, tmpa)) != CRYPT_OK)                            { goto error; }
+         if ((err = rsa_exptmod_ctx(tmp, key->dP, key->p, key->mont_p, tmpa)) != CRYPT_OK)          { goto error; }
 
          /* tmpb = tmp^dQ mod q */
-         if ((err = mp_exptmod(tmp, key->dQ, key->q, tmpb)) != CRYPT_OK)                            { goto error; }
+         if ((err = rsa_exptmod_ctx(tmp, key->dQ, key->q, key->mont_q, tmpb)) != CRYPT_OK)          { goto error; }
 
          /* tmp = (tmpa - tmpb) * qInv (mod p) */
          if ((err = mp_sub(tmpa, tmpb, tmp)) != CRYPT_OK)                                           { goto error; }
@@ -160,14 +169,14 @@ int rsa_exptmod(const unsigned char *in,   unsigned long inlen,
 
       #ifdef LTC_RSA_CRT_HARDENING
       if (!no_crt) {
-         if ((err = mp_exptmod(tmp, key->e, key->N, tmpa)) != CRYPT_OK)                              { goto error; }
+         if ((err = rsa_exptmod_ctx(tmp, key->e, key->N, key->mont_N, tmpa)) != CRYPT_OK)            { goto error; }
          if ((err = mp_read_unsigned_bin(tmpb, (unsigned char *)in, (int)inlen)) != CRYPT_OK)        { goto error; }
          if (mp_cmp(tmpa, tmpb) != LTC_MP_EQ)                                     { err = CRYPT_ERROR; goto error; }
       }
       #endif
    } else {
       /* exptmod it */
-      if ((err = mp_exptmod(tmp, key->e, key->N, tmp)) != CRYPT_OK)                                { goto error; }
+      if ((err = rsa_exptmod_ctx(tmp, key->e, key->N, key->mont_N, tmp)) != CRYPT_OK)              { goto error; }
    }
 
    /* read it back */
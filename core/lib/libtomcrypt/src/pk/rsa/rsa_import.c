@@ -68,6 +68,7 @@ int rsa_import(const unsigned char *in, unsigned long inlen, rsa_key *key)
                             &key->dP, &key->qP, &key->p, &key->q, NULL)) != CRYPT_OK) {
       return err;
    }
+   key->mont_N = key->mont_p = key->mont_q = NULL;
 
    /* see if the OpenSSL DER format RSA public key will work */
    tmpbuf_len = MAX_RSA_SIZE * 8;
@@ -122,6 +122,7 @@ int rsa_make_key(prng_state *prng, int wprng, int size, long e, rsa_key *key)
 
    /* set key type (in this case it's CRT optimized) */
    key->type = PK_PRIVATE;
+   key->mont_N = key->mont_p = key->mont_q = NULL;
 
    /* return ok and free temps */
    err       = CRYPT_OK;
@@ -17,6 +17,7 @@ srcs-$(_CFG_CORE_LTC_CCM) += ccm.c
 srcs-$(_CFG_CORE_LTC_GCM) += gcm.c
 srcs-$(_CFG_CORE_LTC_DSA) += dsa.c
 srcs-$(_CFG_CORE_LTC_ECC) += ecc.c
+srcs-$(_CFG_CORE_LTC_ECC_P256) += ecc_p256.c
 srcs-$(_CFG_CORE_LTC_RSA) += rsa.c
 srcs-$(_CFG_CORE_LTC_DH) += dh.c
 srcs-$(_CFG_CORE_LTC_AES) += aes.c
@@ -126,6 +126,10 @@ static void ltc_init(void)
 {
 #if defined(_CFG_CORE_LTC_ACIPHER)
 	init_mp_tomcrypt();
+#endif
+#if defined(_CFG_CORE_LTC_ECC_FIXED_BASE)
+	if (ltc_ecc_fixed_base_init() != CRYPT_OK)
+		IMSG("ECC fixed base tables incomplete, using generic path");
 #endif
 	tee_ltc_reg_algs();
 }
@@ -5,8 +5,10 @@
 
 #include <kernel/panic.h>
 #include <kernel/refcount.h>
+#include <mm/core_memprot.h>
 #include <mm/file.h>
 #include <mm/fobj.h>
+#include <mm/tee_mm.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/queue.h>
@@ -18,6 +20,25 @@ struct file_slice_elem {
 	SLIST_ENTRY(file_slice_elem) link;
 };
 
+/*
+ * struct file_reloc_elem - relocated copy of a writable segment
+ * @key:	Key identifying the relocation, see file_add_reloc()
+ * @va:		Address the segment was relocated for
+ * @size:	Size of the segment
+ * @mm:		TA memory holding the relocated segment
+ * @link:	Linked list element
+ */
+struct file_reloc_elem {
+	uint8_t key[FILE_TAG_SIZE];
+	vaddr_t va;
+	size_t size;
+	tee_mm_entry_t *mm;
+	TAILQ_ENTRY(file_reloc_elem) link;
+};
+
+/* Max number of relocated segments kept per file */
+#define FILE_MAX_RELOCS		8
+
 /*
  * struct file - file resources
  * @tag:	Tag or hash uniquely identifying a file
@@ -26,6 +47,12 @@ struct file_slice_elem {
  * @link:	Linked list element
  * @num_slices:	Number of elements in the @slices array below
  * @slices:	Array of file slices holding the fobjs of this file
+ * @reloc_head:	Relocated writable segments, most recently added first
+ * @num_relocs:	Number of elements in @reloc_head
+ * @num_pages:	Number of pages held by the slices and relocated segments
+ * @verified:	True once a load of the file has been fully verified
+ * @cached:	True if the file is unused but kept in the file cache
+ * @cache_link:	Linked list element in the file cache
  *
  * A file is constructed of slices which may be shared in different
  * mappings/contexts. There may be holes in the file for ranges of the file
@@ -38,10 +65,34 @@ struct file {
 	TAILQ_ENTRY(file) link;
 	struct mutex mu;
 	SLIST_HEAD(, file_slice_elem) slice_head;
+	TAILQ_HEAD(file_reloc_head, file_reloc_elem) reloc_head;
+	size_t num_relocs;
+	size_t num_pages;
+	bool verified;
+	bool cached;
+	TAILQ_ENTRY(file) cache_link;
 };
 
+TAILQ_HEAD(file_head, file);
+
+/*
+ * When the last reference to a file is dropped the file, with its
+ * verified read-only slices, is kept in the file cache as long as the
+ * cache holds less than CFG_CORE_FILE_CACHE_SIZE bytes. The cache is
+ * ordered with the least recently used file first. Cached files are still
+ * in @file_head with a reference counter of 0 so file_get_by_tag() can
+ * find and revive them.
+ *
+ * Everything here is protected by @file_mu.
+ */
+#define FILE_CACHE_PAGES	(CFG_CORE_FILE_CACHE_SIZE / SMALL_PAGE_SIZE)
+
 static struct mutex file_mu = MUTEX_INITIALIZER;
-static TAILQ_HEAD(, file) file_head = TAILQ_HEAD_INITIALIZER(file_head);
+static struct file_head file_head = TAILQ_HEAD_INITIALIZER(file_head);
+static struct file_head file_cache_head =
+	TAILQ_HEAD_INITIALIZER(file_cache_head);
+static size_t file_cache_pages;
+static struct file_cache_stats file_cache_stats;
 
 static int file_tag_cmp(const struct file *f, const uint8_t *tag,
 			unsigned int taglen)
@@ -63,10 +114,22 @@ static struct file *file_find_tag_unlocked(const uint8_t *tag,
 	return NULL;
 }
 
+static void reloc_free(struct file *f, struct file_reloc_elem *fre)
+{
+	TAILQ_REMOVE(&f->reloc_head, fre, link);
+	f->num_relocs--;
+	f->num_pages -= tee_mm_get_bytes(fre->mm) / SMALL_PAGE_SIZE;
+	tee_mm_free(fre->mm);
+	free(fre);
+}
+
 static void file_free(struct file *f)
 {
 	mutex_destroy(&f->mu);
 
+	while (!TAILQ_EMPTY(&f->reloc_head))
+		reloc_free(f, TAILQ_FIRST(&f->reloc_head));
+
 	while (!SLIST_EMPTY(&f->slice_head)) {
 		struct file_slice_elem *fse = SLIST_FIRST(&f->slice_head);
 
@@ -102,6 +165,7 @@ TEE_Result file_add_slice(struct file *f, struct fobj *fobj,
 
 	fse->slice.page_offset = page_offset;
 	SLIST_INSERT_HEAD(&f->slice_head, fse, link);
+	f->num_pages += fobj->num_pages;
 
 	return TEE_SUCCESS;
 }
@@ -147,6 +211,13 @@ struct file *file_get_by_tag(const uint8_t *tag, unsigned int taglen)
 	f = file_find_tag_unlocked(tag, taglen);
 	if (f && refcount_inc(&f->refc))
 		goto out;
+	if (f && f->cached) {
+		TAILQ_REMOVE(&file_cache_head, f, cache_link);
+		file_cache_pages -= f->num_pages;
+		f->cached = false;
+		refcount_set(&f->refc, 1);
+		goto out;
+	}
 
 	f = calloc(1, sizeof(*f));
 	if (!f)
@@ -156,6 +227,7 @@ struct file *file_get_by_tag(const uint8_t *tag, unsigned int taglen)
 	refcount_set(&f->refc, 1);
 	mutex_init(&f->mu);
 	SLIST_INIT(&f->slice_head);
+	TAILQ_INIT(&f->reloc_head);
 	TAILQ_INSERT_HEAD(&file_head, f, link);
 
 out:
@@ -164,16 +236,203 @@ out:
 	return f;
 }
 
+/* Removes and returns the least recently used file of the cache */
+static struct file *file_cache_pop(void)
+{
+	struct file *f = TAILQ_FIRST(&file_cache_head);
+
+	if (f) {
+		TAILQ_REMOVE(&file_cache_head, f, cache_link);
+		TAILQ_REMOVE(&file_head, f, link);
+		file_cache_pages -= f->num_pages;
+		f->cached = false;
+		file_cache_stats.evictions++;
+	}
+
+	return f;
+}
+
+static bool file_cache_may_keep(struct file *f)
+{
+	struct file *f2 = NULL;
+
+	/*
+	 * Slices are added while the file is loaded, before the digest of
+	 * the whole file has been checked. Only keep files where that
+	 * check has passed.
+	 */
+	if (!f->verified || !f->num_pages || f->num_pages > FILE_CACHE_PAGES)
+		return false;
+
+	/*
+	 * file_get_by_tag() may have replaced this file with a new one
+	 * while the reference counter was 0 but the file not yet cached.
+	 */
+	TAILQ_FOREACH(f2, &file_head, link)
+		if (f2 != f && !file_tag_cmp(f2, f->tag, f->taglen))
+			return false;
+
+	return true;
+}
+
 void file_put(struct file *f)
 {
-	if (f && refcount_dec(&f->refc)) {
-		mutex_lock(&file_mu);
+	struct file_head victims = TAILQ_HEAD_INITIALIZER(victims);
+	struct file *victim = NULL;
+
+	if (!f || !refcount_dec(&f->refc))
+		return;
+
+	mutex_lock(&file_mu);
+	if (file_cache_may_keep(f)) {
+		while (file_cache_pages + f->num_pages > FILE_CACHE_PAGES) {
+			victim = file_cache_pop();
+			TAILQ_INSERT_TAIL(&victims, victim, cache_link);
+		}
+		TAILQ_INSERT_TAIL(&file_cache_head, f, cache_link);
+		file_cache_pages += f->num_pages;
+		f->cached = true;
+	} else {
 		TAILQ_REMOVE(&file_head, f, link);
-		mutex_unlock(&file_mu);
+		TAILQ_INSERT_TAIL(&victims, f, cache_link);
+	}
+	mutex_unlock(&file_mu);
+
+	while (!TAILQ_EMPTY(&victims)) {
+		victim = TAILQ_FIRST(&victims);
+		TAILQ_REMOVE(&victims, victim, cache_link);
+		file_free(victim);
+	}
+}
+
+bool file_cache_evict(void)
+{
+	struct file *f = NULL;
+
+	mutex_lock(&file_mu);
+	f = file_cache_pop();
+	mutex_unlock(&file_mu);
+
+	if (!f)
+		return false;
+
+	file_free(f);
+	return true;
+}
 
-		file_free(f);
+void file_cache_add_load_time(bool warm, uint32_t ms)
+{
+	mutex_lock(&file_mu);
+	if (warm) {
+		file_cache_stats.warm_loads++;
+		file_cache_stats.warm_load_ms += ms;
+	} else {
+		file_cache_stats.cold_loads++;
+		file_cache_stats.cold_load_ms += ms;
 	}
+	mutex_unlock(&file_mu);
+}
+
+void file_cache_get_stats(struct file_cache_stats *stats)
+{
+	mutex_lock(&file_mu);
+	*stats = file_cache_stats;
+	stats->cached_bytes = file_cache_pages * SMALL_PAGE_SIZE;
+	mutex_unlock(&file_mu);
+}
+
+const uint8_t *file_get_tag(struct file *f, unsigned int *taglen)
+{
+	*taglen = f->taglen;
+	return f->tag;
+}
+
+static void *reloc_va(struct file_reloc_elem *fre)
+{
+	return phys_to_virt(tee_mm_get_smem(fre->mm), MEM_AREA_TA_RAM);
+}
+
+static struct file_reloc_elem *find_reloc(struct file *f, const uint8_t *key,
+					  vaddr_t va, size_t size)
+{
+	struct file_reloc_elem *fre = NULL;
+
+	TAILQ_FOREACH(fre, &f->reloc_head, link)
+		if (fre->va == va && fre->size == size &&
+		    !memcmp(fre->key, key, sizeof(fre->key)))
+			return fre;
+
+	return NULL;
+}
+
+TEE_Result file_add_reloc(struct file *f, const uint8_t *key, vaddr_t va,
+			  const void *data, size_t size)
+{
+	struct file_reloc_elem *fre = NULL;
+	void *dst = NULL;
+
+	assert(f->mu.state);
+
+	if (find_reloc(f, key, va, size))
+		return TEE_SUCCESS;
+
+	fre = calloc(1, sizeof(*fre));
+	if (!fre)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	fre->mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+	while (!fre->mm && file_cache_evict())
+		fre->mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+	if (!fre->mm) {
+		free(fre);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	dst = reloc_va(fre);
+	if (!dst) {
+		tee_mm_free(fre->mm);
+		free(fre);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	memcpy(dst, data, size);
+	memcpy(fre->key, key, sizeof(fre->key));
+	fre->va = va;
+	fre->size = size;
+
+	if (f->num_relocs == FILE_MAX_RELOCS)
+		reloc_free(f, TAILQ_LAST(&f->reloc_head, file_reloc_head));
+	TAILQ_INSERT_HEAD(&f->reloc_head, fre, link);
+	f->num_relocs++;
+	f->num_pages += tee_mm_get_bytes(fre->mm) / SMALL_PAGE_SIZE;
+
+	return TEE_SUCCESS;
+}
+
+const void *file_find_reloc(struct file *f, const uint8_t *key, vaddr_t va,
+			    size_t size)
+{
+	struct file_reloc_elem *fre = NULL;
+
+	assert(f->mu.state);
+
+	fre = find_reloc(f, key, va, size);
+	if (!fre)
+		return NULL;
+
+	return reloc_va(fre);
+}
+
+void file_set_verified(struct file *f)
+{
+	assert(f->mu.state);
+
+	f->verified = true;
+}
+
+bool file_is_populated(struct file *f)
+{
+	assert(f->mu.state);
 
+	return !SLIST_EMPTY(&f->slice_head);
 }
 
 struct file_slice *file_find_slice(struct file *f, unsigned int page_offset)
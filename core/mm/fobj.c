@@ -8,7 +8,9 @@
 #include <kernel/panic.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
+#include <mm/file.h>
 #include <mm/fobj.h>
+#include <mm/mobj.h>
 #include <mm/tee_mm.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,6 +18,23 @@
 #include <types_ext.h>
 #include <util.h>
 
+/*
+ * Allocates TA memory, releasing the pooled bounce buffers and then
+ * evicting unused files from the file cache until the allocation succeeds
+ * or the cache is empty.
+ */
+static tee_mm_entry_t *alloc_ta_ram(size_t size)
+{
+	tee_mm_entry_t *mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+
+	if (!mm && mobj_bounce_evict())
+		mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+	while (!mm && file_cache_evict())
+		mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+
+	return mm;
+}
+
 #ifdef CFG_WITH_PAGER
 
 #define RWP_AE_KEY_BITS		256
@@ -85,7 +104,7 @@ struct fobj *fobj_rw_paged_alloc(unsigned int num_pages)
 
 	if (MUL_OVERFLOW(num_pages, SMALL_PAGE_SIZE, &size))
 		goto err;
-	mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+	mm = alloc_ta_ram(size);
 	if (!mm)
 		goto err;
 	rwp->store = phys_to_virt(tee_mm_get_smem(mm), MEM_AREA_TA_RAM);
@@ -343,7 +362,7 @@ struct fobj *fobj_sec_mem_alloc(unsigned int num_pages)
 	if (MUL_OVERFLOW(num_pages, SMALL_PAGE_SIZE, &size))
 		goto err;
 
-	f->mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+	f->mm = alloc_ta_ram(size);
 	if (!f->mm)
 		goto err;
 
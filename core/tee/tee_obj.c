@@ -16,26 +16,45 @@
 
 void tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o)
 {
+	bool locked = user_ta_lock(utc);
+
 	TAILQ_INSERT_TAIL(&utc->objects, o, link);
+	/* Nobody else knows about the object yet, this can't fail */
+	user_ta_claim(utc, &o->claim);
+
+	if (locked)
+		user_ta_unlock(utc);
 }
 
 TEE_Result tee_obj_get(struct user_ta_ctx *utc, uint32_t obj_id,
 		       struct tee_obj **obj)
 {
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	bool locked = user_ta_lock(utc);
 	struct tee_obj *o;
 
 	TAILQ_FOREACH(o, &utc->objects, link) {
 		if (obj_id == (vaddr_t)o) {
-			*obj = o;
-			return TEE_SUCCESS;
+			res = user_ta_claim(utc, &o->claim);
+			if (res == TEE_SUCCESS)
+				*obj = o;
+			break;
 		}
 	}
-	return TEE_ERROR_BAD_PARAMETERS;
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
 }
 
 void tee_obj_close(struct user_ta_ctx *utc, struct tee_obj *o)
 {
+	bool locked = user_ta_lock(utc);
+
 	TAILQ_REMOVE(&utc->objects, o, link);
+	if (locked)
+		user_ta_unlock(utc);
 
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT)) {
 		o->pobj->fops->close(&o->fh);
@@ -494,6 +494,117 @@ out:
 	return res;
 }
 
+/*
+ * Gets the size of the value of @prop, the properties with a
+ * get_prop_func return TEE_ERROR_SHORT_BUFFER with the size when given
+ * an empty buffer.
+ */
+static TEE_Result get_prop_len(struct tee_ta_session *sess,
+			       const struct tee_props *prop, size_t *len)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!prop->get_prop_func) {
+		*len = prop->len;
+		return TEE_SUCCESS;
+	}
+
+	*len = 0;
+	res = prop->get_prop_func(sess, NULL, len);
+	if (res == TEE_ERROR_SHORT_BUFFER || res == TEE_SUCCESS)
+		return TEE_SUCCESS;
+	return res;
+}
+
+/*
+ * prop_set is part of TEE_PROPSET_xxx
+ * buf receives one struct utee_property per property, see utee_types.h
+ */
+TEE_Result syscall_get_property_set(unsigned long prop_set, void *buf,
+				    uint32_t *blen)
+{
+	struct tee_ta_session *sess = NULL;
+	const struct tee_props *prop = NULL;
+	struct utee_property up = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *ubuf = buf;
+	bool short_buf = false;
+	uint32_t klen = 0;
+	size_t vlen = 0;
+	size_t pos = 0;
+	size_t sz = 0;
+	size_t n = 0;
+
+	res = tee_ta_get_current_session(&sess);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = tee_svc_copy_from_user(&klen, blen, sizeof(klen));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	for (n = 0; ; n++) {
+		prop = get_prop_struct(prop_set, n);
+		if (!prop)
+			break;
+
+		res = get_prop_len(sess, prop, &vlen);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		up = (struct utee_property){
+			.type = prop->prop_type,
+			.name_len = strlen(prop->name) + 1,
+			.value_len = vlen,
+		};
+		sz = sizeof(up) + up.name_len + up.value_len;
+
+		/* Only the size is computed once the buffer is too small */
+		if (pos + sz > klen)
+			short_buf = true;
+		if (!short_buf) {
+			res = tee_svc_copy_to_user(ubuf + pos, &up,
+						   sizeof(up));
+			if (res != TEE_SUCCESS)
+				return res;
+			res = tee_svc_copy_to_user(ubuf + pos + sizeof(up),
+						   prop->name, up.name_len);
+			if (res != TEE_SUCCESS)
+				return res;
+
+			pos += sizeof(up) + up.name_len;
+			if (prop->get_prop_func) {
+				res = prop->get_prop_func(sess, ubuf + pos,
+							  &vlen);
+				if (!res && vlen != up.value_len)
+					res = TEE_ERROR_BAD_STATE;
+			} else {
+				res = tee_svc_copy_to_user(ubuf + pos,
+							   prop->data,
+							   prop->len);
+			}
+			if (res != TEE_SUCCESS)
+				return res;
+			pos += up.value_len;
+		} else {
+			pos += sz;
+		}
+		pos = ROUNDUP(pos, UTEE_PROPERTY_ALIGN);
+	}
+
+	if (pos > UINT32_MAX)
+		return TEE_ERROR_OVERFLOW;
+
+	klen = pos;
+	res = tee_svc_copy_to_user(blen, &klen, sizeof(*blen));
+	if (res != TEE_SUCCESS)
+		return res;
+	if (short_buf)
+		return TEE_ERROR_SHORT_BUFFER;
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result utee_param_to_param(struct user_ta_ctx *utc,
 				      struct tee_ta_param *p,
 				      struct utee_params *up)
@@ -541,7 +652,7 @@ static TEE_Result alloc_temp_sec_mem(size_t size, struct mobj **mobj,
 #ifdef CFG_PAGED_USER_TA
 	*mobj = mobj_seccpy_shm_alloc(size);
 #else
-	*mobj = mobj_mm_alloc(mobj_sec_ddr, size, &tee_mm_sec_ddr);
+	*mobj = mobj_bounce_alloc(size);
 #endif
 	if (!*mobj)
 		return TEE_ERROR_GENERIC;
@@ -550,11 +661,135 @@ static TEE_Result alloc_temp_sec_mem(size_t size, struct mobj **mobj,
 	return TEE_SUCCESS;
 }
 
+static void free_temp_sec_mem(struct mobj *mobj)
+{
+#ifdef CFG_PAGED_USER_TA
+	mobj_free_wipe(mobj);
+#else
+	mobj_bounce_free(mobj);
+#endif
+}
+
+/*
+ * Memrefs with fewer full pages are cheaper to copy than to share
+ */
+#define MEMREF_SHARE_MIN_PAGES	4
+
+/*
+ * A memref in TA private RAM whose full pages are mapped in the called TA
+ * for the duration of the call. The unaligned head and tail fragments are
+ * copied to private pages since the rest of their pages must not be
+ * exposed.
+ */
+struct memref_share {
+	struct mobj *mobj;
+	vaddr_t uva;		/* Address of the memref in the calling TA */
+	size_t head_len;
+	size_t tail_offs;	/* Offset of the tail fragment in the memref */
+	size_t tail_len;
+};
+
+#ifdef CFG_TA_SHARE_PRIVATE_MEMREF
+static TEE_Result share_memref(struct user_ta_ctx *utc, uint32_t type,
+			       struct param_mem *mem, struct memref_share *shr)
+{
+	vaddr_t b = mem->offs;
+	vaddr_t e = b + mem->size;
+	vaddr_t mid_b = ROUNDUP(b, SMALL_PAGE_SIZE);
+	vaddr_t mid_e = ROUNDDOWN(e, SMALL_PAGE_SIZE);
+	size_t offs = b & SMALL_PAGE_MASK;
+	struct mobj *src = NULL;
+	size_t src_offs = 0;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (mid_e < mid_b ||
+	    (mid_e - mid_b) / SMALL_PAGE_SIZE < MEMREF_SHARE_MIN_PAGES)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	/* Paged memory can't be mapped in another TA */
+	if (tee_mmu_vbuf_to_mobj_offs(utc, (void *)mid_b, mid_e - mid_b,
+				      &src, &src_offs) ||
+	    mobj_is_paged(src))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	shr->uva = b;
+	shr->head_len = mid_b - b;
+	shr->tail_offs = mid_e - b;
+	shr->tail_len = e - mid_e;
+	shr->mobj = mobj_ta_share_alloc(src, src_offs,
+					(mid_e - mid_b) / SMALL_PAGE_SIZE,
+					shr->head_len, shr->tail_len,
+					type == TEE_PARAM_TYPE_MEMREF_INPUT);
+	if (!shr->mobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	if (type != TEE_PARAM_TYPE_MEMREF_OUTPUT && shr->head_len) {
+		res = tee_svc_copy_from_user(mobj_get_va(shr->mobj, offs),
+					     (void *)b, shr->head_len);
+		if (res)
+			return res;
+	}
+	if (type != TEE_PARAM_TYPE_MEMREF_OUTPUT && shr->tail_len) {
+		res = tee_svc_copy_from_user(mobj_get_va(shr->mobj,
+							 offs + shr->tail_offs),
+					     (void *)mid_e, shr->tail_len);
+		if (res)
+			return res;
+	}
+
+	mem->mobj = shr->mobj;
+	mem->offs = offs;
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result share_memref(struct user_ta_ctx *utc __unused,
+			       uint32_t type __unused,
+			       struct param_mem *mem __unused,
+			       struct memref_share *shr __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+static TEE_Result update_memref_share(struct memref_share *shr, size_t size)
+{
+	size_t offs = shr->uva & SMALL_PAGE_MASK;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (shr->head_len && size) {
+		res = tee_svc_copy_to_user((void *)shr->uva,
+					   mobj_get_va(shr->mobj, offs),
+					   MIN(shr->head_len, size));
+		if (res)
+			return res;
+	}
+	if (!shr->tail_len || size <= shr->tail_offs)
+		return TEE_SUCCESS;
+
+	return tee_svc_copy_to_user((void *)(shr->uva + shr->tail_offs),
+				    mobj_get_va(shr->mobj,
+						offs + shr->tail_offs),
+				    MIN(shr->tail_len, size - shr->tail_offs));
+}
+
+static void free_memref_shares(struct memref_share shares[TEE_NUM_PARAMS])
+{
+	size_t n = 0;
+
+	for (n = 0; n < TEE_NUM_PARAMS; n++)
+		mobj_free(shares[n].mobj);
+}
+
 /*
  * TA invokes some TA with parameter.
  * If some parameters are memory references:
  * - either the memref is inside TA private RAM: TA is not allowed to expose
- *   its private RAM: use a temporary memory buffer and copy the data.
+ *   its private RAM:
+ *   - if large enough and the called TA is known to be a user TA, its
+ *     full pages are shared with the called TA, the head and tail
+ *     fragments are copied to private pages.
+ *   - else use a temporary memory buffer and copy the data.
  * - or the memref is not in the TA private RAM:
  *   - if the memref was mapped to the TA, TA is allowed to expose it.
  *   - if so, converts memref virtual address into a physical address.
@@ -565,7 +800,8 @@ static TEE_Result tee_svc_copy_param(struct tee_ta_session *sess,
 				     struct tee_ta_param *param,
 				     void *tmp_buf_va[TEE_NUM_PARAMS],
 				     size_t tmp_buf_size[TEE_NUM_PARAMS],
-				     struct mobj **mobj_tmp)
+				     struct mobj **mobj_tmp,
+				     struct memref_share shares[TEE_NUM_PARAMS])
 {
 	size_t n;
 	TEE_Result res;
@@ -576,6 +812,7 @@ static TEE_Result tee_svc_copy_param(struct tee_ta_session *sess,
 	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
 	void *va;
 	size_t dst_offs;
+	bool can_share = false;
 
 	/* fill 'param' input struct with caller params description buffer */
 	if (!callee_params) {
@@ -596,6 +833,12 @@ static TEE_Result tee_svc_copy_param(struct tee_ta_session *sess,
 		return TEE_SUCCESS;
 	}
 
+	/*
+	 * Only a user TA can map a shared memref, when opening a session
+	 * the called TA isn't known yet so the data is copied instead.
+	 */
+	can_share = called_sess && is_user_ta_ctx(called_sess->ctx);
+
 	/* All mobj in param are of type MOJB_TYPE_VIRT */
 
 	for (n = 0; n < TEE_NUM_PARAMS; n++) {
@@ -615,6 +858,15 @@ static TEE_Result tee_svc_copy_param(struct tee_ta_session *sess,
 			}
 			/* uTA cannot expose its private memory */
 			if (tee_mmu_is_vbuf_inside_ta_private(utc, va, s)) {
+				res = TEE_ERROR_NOT_SUPPORTED;
+				if (can_share)
+					res = share_memref(utc,
+					   TEE_PARAM_TYPE_GET(param->types, n),
+					   &param->u[n].mem, shares + n);
+				if (res == TEE_SUCCESS)
+					break;
+				if (res != TEE_ERROR_NOT_SUPPORTED)
+					return res;
 
 				s = ROUNDUP(s, sizeof(uint32_t));
 				if (ADD_OVERFLOW(req_mem, s, &req_mem))
@@ -697,6 +949,7 @@ static TEE_Result tee_svc_update_out_param(
 		struct tee_ta_param *param,
 		void *tmp_buf_va[TEE_NUM_PARAMS],
 		size_t tmp_buf_size[TEE_NUM_PARAMS],
+		struct memref_share shares[TEE_NUM_PARAMS],
 		struct utee_params *usr_param)
 {
 	size_t n;
@@ -731,6 +984,15 @@ static TEE_Result tee_svc_update_out_param(
 						return res;
 				}
 			}
+			/* Only the fragments of a shared memref are copied */
+			if (shares[n].mobj &&
+			    param->u[n].mem.size <= vals[n * 2 + 1]) {
+				TEE_Result res = update_memref_share(shares + n,
+							param->u[n].mem.size);
+
+				if (res != TEE_SUCCESS)
+					return res;
+			}
 			usr_param->vals[n * 2 + 1] = param->u[n].mem.size;
 			break;
 
@@ -764,6 +1026,7 @@ TEE_Result syscall_open_ta_session(const TEE_UUID *dest,
 	TEE_Identity *clnt_id = malloc(sizeof(TEE_Identity));
 	void *tmp_buf_va[TEE_NUM_PARAMS] = { NULL };
 	size_t tmp_buf_size[TEE_NUM_PARAMS] = { 0 };
+	struct memref_share shares[TEE_NUM_PARAMS] = { };
 	struct user_ta_ctx *utc;
 
 	if (uuid == NULL || param == NULL || clnt_id == NULL) {
@@ -786,7 +1049,7 @@ TEE_Result syscall_open_ta_session(const TEE_UUID *dest,
 	memcpy(&clnt_id->uuid, &sess->ctx->uuid, sizeof(TEE_UUID));
 
 	res = tee_svc_copy_param(sess, NULL, usr_param, param, tmp_buf_va,
-				 tmp_buf_size, &mobj_param);
+				 tmp_buf_size, &mobj_param, shares);
 	if (res != TEE_SUCCESS)
 		goto function_exit;
 
@@ -797,10 +1060,11 @@ TEE_Result syscall_open_ta_session(const TEE_UUID *dest,
 		goto function_exit;
 
 	res = tee_svc_update_out_param(param, tmp_buf_va, tmp_buf_size,
-				       usr_param);
+				       shares, usr_param);
 
 function_exit:
-	mobj_free_wipe(mobj_param);
+	free_temp_sec_mem(mobj_param);
+	free_memref_shares(shares);
 	if (res == TEE_SUCCESS)
 		tee_svc_copy_to_user(ta_sess, &s->id, sizeof(s->id));
 	tee_svc_copy_to_user(ret_orig, &ret_o, sizeof(ret_o));
@@ -846,6 +1110,7 @@ TEE_Result syscall_invoke_ta_command(unsigned long ta_sess,
 	struct mobj *mobj_param = NULL;
 	void *tmp_buf_va[TEE_NUM_PARAMS] = { NULL };
 	size_t tmp_buf_size[TEE_NUM_PARAMS] = { };
+	struct memref_share shares[TEE_NUM_PARAMS] = { };
 	struct user_ta_ctx *utc;
 
 	res = tee_ta_get_current_session(&sess);
@@ -862,7 +1127,7 @@ TEE_Result syscall_invoke_ta_command(unsigned long ta_sess,
 	memcpy(&clnt_id.uuid, &sess->ctx->uuid, sizeof(TEE_UUID));
 
 	res = tee_svc_copy_param(sess, called_sess, usr_param, &param,
-				 tmp_buf_va, tmp_buf_size, &mobj_param);
+				 tmp_buf_va, tmp_buf_size, &mobj_param, shares);
 	if (res != TEE_SUCCESS)
 		goto function_exit;
 
@@ -872,7 +1137,7 @@ TEE_Result syscall_invoke_ta_command(unsigned long ta_sess,
 		goto function_exit;
 
 	res2 = tee_svc_update_out_param(&param, tmp_buf_va, tmp_buf_size,
-					usr_param);
+					shares, usr_param);
 	if (res2 != TEE_SUCCESS) {
 		/*
 		 * Spec for TEE_InvokeTACommand() says:
@@ -891,7 +1156,8 @@ TEE_Result syscall_invoke_ta_command(unsigned long ta_sess,
 
 function_exit:
 	tee_ta_put_session(called_sess);
-	mobj_free_wipe(mobj_param);
+	free_temp_sec_mem(mobj_param);
+	free_memref_shares(shares);
 	if (ret_orig)
 		tee_svc_copy_to_user(ret_orig, &ret_o, sizeof(ret_o));
 	return res;
@@ -40,6 +40,7 @@ struct tee_cryp_state {
 	vaddr_t key2;
 	void *ctx;
 	tee_cryp_ctx_finalize_func_t ctx_finalize;
+	struct user_ta_claim claim;
 };
 
 struct tee_cryp_obj_secret {
@@ -995,6 +996,9 @@ void tee_obj_attr_free(struct tee_obj *o)
 	if (!tp)
 		return;
 
+	if (o->info.objectType == TEE_TYPE_RSA_KEYPAIR)
+		crypto_acipher_free_rsa_precomp(o->attr);
+
 	for (n = 0; n < tp->num_type_attrs; n++) {
 		const struct tee_cryp_obj_type_attrs *ta = tp->type_attrs + n;
 
@@ -1013,6 +1017,9 @@ void tee_obj_attr_clear(struct tee_obj *o)
 	if (!tp)
 		return;
 
+	if (o->info.objectType == TEE_TYPE_RSA_KEYPAIR)
+		crypto_acipher_free_rsa_precomp(o->attr);
+
 	for (n = 0; n < tp->num_type_attrs; n++) {
 		const struct tee_cryp_obj_type_attrs *ta = tp->type_attrs + n;
 
@@ -1889,26 +1896,38 @@ static TEE_Result tee_svc_cryp_get_state(struct tee_ta_session *sess,
 {
 	struct tee_cryp_state *s;
 	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	bool locked = user_ta_lock(utc);
 
 	TAILQ_FOREACH(s, &utc->cryp_states, link) {
 		if (state_id == (vaddr_t)s) {
-			*state = s;
-			return TEE_SUCCESS;
+			res = user_ta_claim(utc, &s->claim);
+			if (res == TEE_SUCCESS)
+				*state = s;
+			break;
 		}
 	}
-	return TEE_ERROR_BAD_PARAMETERS;
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
 }
 
 static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
 {
 	struct tee_obj *o;
+	bool locked = false;
 
 	if (tee_obj_get(utc, cs->key1, &o) == TEE_SUCCESS)
 		tee_obj_close(utc, o);
 	if (tee_obj_get(utc, cs->key2, &o) == TEE_SUCCESS)
 		tee_obj_close(utc, o);
 
+	locked = user_ta_lock(utc);
 	TAILQ_REMOVE(&utc->cryp_states, cs, link);
+	if (locked)
+		user_ta_unlock(utc);
 	if (cs->ctx_finalize != NULL)
 		cs->ctx_finalize(cs->ctx, cs->algo);
 
@@ -2023,6 +2042,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	struct tee_obj *o1 = NULL;
 	struct tee_obj *o2 = NULL;
 	struct user_ta_ctx *utc;
+	bool locked = false;
 
 	res = tee_ta_get_current_session(&sess);
 	if (res != TEE_SUCCESS)
@@ -2053,7 +2073,12 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	cs = calloc(1, sizeof(struct tee_cryp_state));
 	if (!cs)
 		return TEE_ERROR_OUT_OF_MEMORY;
+	locked = user_ta_lock(utc);
 	TAILQ_INSERT_TAIL(&utc->cryp_states, cs, link);
+	/* Nobody else knows about the state yet, this can't fail */
+	user_ta_claim(utc, &cs->claim);
+	if (locked)
+		user_ta_unlock(utc);
 	cs->algo = algo;
 	cs->mode = mode;
 
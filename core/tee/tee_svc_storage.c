@@ -58,30 +58,44 @@ struct tee_storage_enum {
 	TAILQ_ENTRY(tee_storage_enum) link;
 	struct tee_fs_dir *dir;
 	const struct tee_file_operations *fops;
+	struct user_ta_claim claim;
 };
 
 static TEE_Result tee_svc_storage_get_enum(struct user_ta_ctx *utc,
 					   uint32_t enum_id,
 					   struct tee_storage_enum **e_out)
 {
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	bool locked = user_ta_lock(utc);
 	struct tee_storage_enum *e;
 
 	TAILQ_FOREACH(e, &utc->storage_enums, link) {
 		if (enum_id == (vaddr_t)e) {
-			*e_out = e;
-			return TEE_SUCCESS;
+			res = user_ta_claim(utc, &e->claim);
+			if (res == TEE_SUCCESS)
+				*e_out = e;
+			break;
 		}
 	}
-	return TEE_ERROR_BAD_PARAMETERS;
+
+	if (locked)
+		user_ta_unlock(utc);
+
+	return res;
 }
 
 static TEE_Result tee_svc_close_enum(struct user_ta_ctx *utc,
 				     struct tee_storage_enum *e)
 {
+	bool locked = false;
+
 	if (e == NULL || utc == NULL)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	locked = user_ta_lock(utc);
 	TAILQ_REMOVE(&utc->storage_enums, e, link);
+	if (locked)
+		user_ta_unlock(utc);
 
 	if (e->fops)
 		e->fops->closedir(e->dir);
@@ -601,6 +615,7 @@ TEE_Result syscall_storage_alloc_enum(uint32_t *obj_enum)
 	struct tee_ta_session *sess;
 	TEE_Result res;
 	struct user_ta_ctx *utc;
+	bool locked = false;
 
 	if (obj_enum == NULL)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -610,13 +625,16 @@ TEE_Result syscall_storage_alloc_enum(uint32_t *obj_enum)
 		return res;
 	utc = to_user_ta_ctx(sess->ctx);
 
-	e = malloc(sizeof(struct tee_storage_enum));
+	e = calloc(1, sizeof(struct tee_storage_enum));
 	if (e == NULL)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
-	e->dir = NULL;
-	e->fops = NULL;
+	locked = user_ta_lock(utc);
 	TAILQ_INSERT_TAIL(&utc->storage_enums, e, link);
+	/* Nobody else knows about the enumerator yet, this can't fail */
+	user_ta_claim(utc, &e->claim);
+	if (locked)
+		user_ta_unlock(utc);
 
 	return tee_svc_copy_kaddr_to_uref(obj_enum, e);
 }
@@ -5,6 +5,7 @@
 
 #include <assert.h>
 #include <printk.h>
+#include <string.h>
 #include <sys/queue.h>
 #include <types_ext.h>
 #include <util.h>
@@ -13,12 +14,25 @@
 #include "ftrace.h"
 #include "ta_elf.h"
 
-#define MIN_FTRACE_BUF_SIZE	1024
+#define MIN_FTRACE_RECS		16
 #define MAX_HEADER_STRLEN	128
+#define MAX_LINE_STRLEN		(FTRACE_RETFUNC_DEPTH + 64)
 
 static struct __ftrace_info *finfo;
 static struct ftrace_buf *fbuf;
 
+static uint32_t read_cntfrq(void)
+{
+	uint32_t val = 0;
+
+#ifdef __aarch64__
+	asm volatile("mrs %0, cntfrq_el0" : "=r" (val));
+#else
+	asm volatile("mrc p15, 0, %0, c14, c0, 0" : "=r" (val));
+#endif
+	return val;
+}
+
 bool ftrace_init(void)
 {
 	struct ta_elf *elf = TAILQ_FIRST(&main_elf_queue);
@@ -26,6 +40,8 @@ bool ftrace_init(void)
 	vaddr_t val = 0;
 	int count = 0;
 	size_t fbuf_size = 0;
+	size_t buf_off = 0;
+	size_t num_recs = 0;
 
 	res = ta_elf_resolve_sym("__ftrace_info", &val);
 	if (res)
@@ -39,38 +55,84 @@ bool ftrace_init(void)
 			 &fbuf_size))
 		return false;
 
-	if (fbuf_size < MIN_FTRACE_BUF_SIZE) {
+	buf_off = ROUNDUP(sizeof(struct ftrace_buf) + MAX_HEADER_STRLEN,
+			  sizeof(uint64_t));
+	if (fbuf_size < buf_off + MIN_FTRACE_RECS * sizeof(struct ftrace_rec)) {
 		DMSG("ftrace buffer too small");
 		return false;
 	}
 
+	/* The records are indexed with a mask */
+	num_recs = (fbuf_size - buf_off) / sizeof(struct ftrace_rec);
+	while (!IS_POWER_OF_TWO(num_recs))
+		num_recs &= num_recs - 1;
+
 	fbuf = (struct ftrace_buf *)finfo->buf_start.ptr64;
 	fbuf->head_off = sizeof(struct ftrace_buf);
 	count = snprintk((char *)fbuf + fbuf->head_off, MAX_HEADER_STRLEN,
-			 "Function graph for TA: %pUl @ %lx\n",
-			 (void *)&elf->uuid, elf->load_addr);
+			 "Function graph for TA: %pUl @ %lx (%"PRIu32" Hz)\n",
+			 (void *)&elf->uuid, elf->load_addr, read_cntfrq());
 	assert(count < MAX_HEADER_STRLEN);
 
 	fbuf->ret_func_ptr = finfo->ret_ptr.ptr64;
 	fbuf->ret_idx = 0;
 	fbuf->lr_idx = 0;
-	fbuf->buf_off = fbuf->head_off + count;
-	fbuf->curr_size = 0;
-	fbuf->max_size = fbuf_size - sizeof(struct ftrace_buf) - count;
+	fbuf->rec_count = 0;
+	fbuf->max_recs = num_recs;
+#ifdef CFG_TA_FTRACE_RING
+	fbuf->flags = FTRACE_BUF_FLAG_RING;
+#else
+	fbuf->flags = 0;
+#endif
+	fbuf->buf_off = buf_off;
 
 	return true;
 }
 
+/*
+ * Each record is printed as one line of the function graph, prefixed
+ * with its timestamp:
+ * <counter> | <indent>0x<func>() {	for an entry
+ * <counter> | <indent>} 0x<func>()	for an exit
+ */
+static void print_rec(void *pctx,
+		      void (*copy_func)(void *pctx, void *b, size_t bl),
+		      struct ftrace_rec *rec)
+{
+	char line[MAX_LINE_STRLEN] = { };
+	int count = 0;
+
+	if (rec->is_exit)
+		count = snprintk(line, sizeof(line),
+				 "%20"PRIu64" | %*s} 0x%"PRIx64"()\n", rec->ts,
+				 (int)rec->depth, "", rec->pc);
+	else
+		count = snprintk(line, sizeof(line),
+				 "%20"PRIu64" | %*s0x%"PRIx64"() {\n", rec->ts,
+				 (int)rec->depth, "", rec->pc);
+	assert(count > 0 && (size_t)count < sizeof(line));
+	copy_func(pctx, line, count);
+}
+
 void ftrace_copy_buf(void *pctx, void (*copy_func)(void *pctx, void *b,
 						   size_t bl))
 {
 	if (fbuf) {
 		struct ta_elf *elf = TAILQ_FIRST(&main_elf_queue);
-		size_t dump_size = fbuf->buf_off - fbuf->head_off +
-				   fbuf->curr_size;
+		struct ftrace_rec *recs = (struct ftrace_rec *)
+					  ((char *)fbuf + fbuf->buf_off);
+		char *hdr = (char *)fbuf + fbuf->head_off;
+		uint64_t n = 0;
 
 		assert(elf && elf->is_main);
-		copy_func(pctx, (char *)fbuf + fbuf->head_off, dump_size);
+		copy_func(pctx, hdr, strnlen(hdr, MAX_HEADER_STRLEN));
+
+		/* In ring mode only the last max_recs records are left */
+		if (fbuf->rec_count > fbuf->max_recs)
+			n = fbuf->rec_count - fbuf->max_recs;
+		for (; n < fbuf->rec_count; n++)
+			print_rec(pctx, copy_func,
+				  recs + (n & (fbuf->max_recs - 1)));
 	}
 }
 
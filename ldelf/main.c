@@ -21,6 +21,43 @@
 static size_t mpool_size = 2 * SMALL_PAGE_SIZE;
 static vaddr_t mpool_base;
 
+#if TRACE_LEVEL >= TRACE_DEBUG
+static uint32_t time_ms(void)
+{
+	TEE_Time t = { };
+
+	if (utee_get_time(UTEE_TIME_CAT_SYSTEM, &t))
+		return 0;
+	return t.seconds * 1000 + t.millis;
+}
+
+static void print_load_stats(uint32_t start_ms, uint32_t reloc_ms)
+{
+	struct ta_elf_sym_stats stats = { };
+	struct ta_elf *elf = NULL;
+	size_t num_elfs = 0;
+
+	TAILQ_FOREACH(elf, &main_elf_queue, link)
+		num_elfs++;
+	ta_elf_get_sym_stats(&stats);
+
+	DMSG("Loaded %zu ELFs in %"PRIu32" ms, relocated in %"PRIu32" ms",
+	     num_elfs, reloc_ms - start_ms, time_ms() - reloc_ms);
+	DMSG("Symbol lookups %zu cache hits %zu bloom rejects %zu",
+	     stats.lookups, stats.cache_hits, stats.bloom_rejects);
+}
+#else
+static uint32_t time_ms(void)
+{
+	return 0;
+}
+
+static void print_load_stats(uint32_t start_ms __unused,
+			     uint32_t reloc_ms __unused)
+{
+}
+#endif
+
 static void __printf(2, 0) print_to_console(void *pctx __unused,
 					    const char *fmt, va_list ap)
 {
@@ -113,6 +150,8 @@ void ldelf(struct ldelf_arg *arg)
 {
 	TEE_Result res = TEE_SUCCESS;
 	struct ta_elf *elf = NULL;
+	uint32_t start_ms = time_ms();
+	uint32_t reloc_ms = 0;
 
 	DMSG("Loading TA %pUl", (void *)&arg->uuid);
 	res = sys_map_zi(mpool_size, 0, &mpool_base, 0, 0);
@@ -134,10 +173,12 @@ void ldelf(struct ldelf_arg *arg)
 	TAILQ_FOREACH(elf, &main_elf_queue, link)
 		ta_elf_load_dependency(elf, arg->is_32bit);
 
+	reloc_ms = time_ms();
 	TAILQ_FOREACH(elf, &main_elf_queue, link) {
 		ta_elf_relocate(elf);
 		ta_elf_finalize_mappings(elf);
 	}
+	print_load_stats(start_ms, reloc_ms);
 
 	arg->ftrace_entry = 0;
 #ifdef CFG_TA_FTRACE_SUPPORT
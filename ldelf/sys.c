@@ -125,6 +125,21 @@ TEE_Result sys_open_ta_bin(const TEE_UUID *uuid, uint32_t *handle)
 	return res;
 }
 
+TEE_Result sys_prefetch_ta_bins(const TEE_UUID *uuids, size_t num_uuids)
+{
+	struct utee_params params = {
+		.types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					 TEE_PARAM_TYPE_NONE,
+					 TEE_PARAM_TYPE_NONE,
+					 TEE_PARAM_TYPE_NONE),
+	};
+
+	params.vals[0] = (vaddr_t)uuids;
+	params.vals[1] = num_uuids * sizeof(*uuids);
+
+	return invoke_sys_ta(PTA_SYSTEM_PREFETCH_TA_BINARIES, &params);
+}
+
 TEE_Result sys_close_ta_bin(uint32_t handle)
 {
 	struct utee_params params = {
@@ -233,3 +248,36 @@ TEE_Result sys_remap(vaddr_t old_va, vaddr_t *new_va, size_t num_bytes,
 		*new_va = reg_pair_to_64(params.vals[4], params.vals[5]);
 	return res;
 }
+
+static TEE_Result reloc_cache_cmd(uint32_t cmd, const uint64_t *addrs,
+				  size_t num_addrs, const uint64_t *segs,
+				  size_t num_segs)
+{
+	struct utee_params params = {
+		.types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					 TEE_PARAM_TYPE_MEMREF_INPUT,
+					 TEE_PARAM_TYPE_NONE,
+					 TEE_PARAM_TYPE_NONE),
+	};
+
+	params.vals[0] = (vaddr_t)addrs;
+	params.vals[1] = num_addrs * sizeof(*addrs);
+	params.vals[2] = (vaddr_t)segs;
+	params.vals[3] = num_segs * 2 * sizeof(*segs);
+
+	return invoke_sys_ta(cmd, &params);
+}
+
+TEE_Result sys_reloc_cache_lookup(const uint64_t *addrs, size_t num_addrs,
+				  const uint64_t *segs, size_t num_segs)
+{
+	return reloc_cache_cmd(PTA_SYSTEM_RELOC_CACHE_LOOKUP, addrs, num_addrs,
+			       segs, num_segs);
+}
+
+TEE_Result sys_reloc_cache_add(const uint64_t *addrs, size_t num_addrs,
+			       const uint64_t *segs, size_t num_segs)
+{
+	return reloc_cache_cmd(PTA_SYSTEM_RELOC_CACHE_ADD, addrs, num_addrs,
+			       segs, num_segs);
+}
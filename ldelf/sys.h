@@ -38,6 +38,7 @@ TEE_Result sys_map_zi(size_t num_bytes, uint32_t flags, vaddr_t *va,
 TEE_Result sys_unmap(vaddr_t va, size_t num_bytes);
 TEE_Result sys_open_ta_bin(const TEE_UUID *uuid, uint32_t *handle);
 TEE_Result sys_close_ta_bin(uint32_t handle);
+TEE_Result sys_prefetch_ta_bins(const TEE_UUID *uuids, size_t num_uuids);
 TEE_Result sys_map_ta_bin(vaddr_t *va, size_t num_bytes, uint32_t flags,
 			  uint32_t handle, size_t offs, size_t pad_begin,
 			  size_t pad_end);
@@ -46,5 +47,9 @@ TEE_Result sys_copy_from_ta_bin(void *dst, size_t num_bytes, uint32_t handle,
 TEE_Result sys_set_prot(vaddr_t va, size_t num_bytes, uint32_t flags);
 TEE_Result sys_remap(vaddr_t old_va, vaddr_t *new_va, size_t num_bytes,
 		     size_t pad_begin, size_t pad_end);
+TEE_Result sys_reloc_cache_lookup(const uint64_t *addrs, size_t num_addrs,
+				  const uint64_t *segs, size_t num_segs);
+TEE_Result sys_reloc_cache_add(const uint64_t *addrs, size_t num_addrs,
+			       const uint64_t *segs, size_t num_segs);
 
 #endif /*SYS_H*/
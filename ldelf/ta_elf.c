@@ -143,10 +143,10 @@ static void save_hashtab_from_segment(struct ta_elf *elf, unsigned int type,
 
 	for (n = 0; n < num_dyns; n++) {
 		read_dyn(elf, addr, n, &tag, &val);
-		if (tag == DT_HASH) {
+		if (tag == DT_HASH)
 			elf->hashtab = (void *)(val + elf->load_addr);
-			break;
-		}
+		else if (tag == DT_GNU_HASH)
+			elf->gnu_hashtab = (void *)(val + elf->load_addr);
 	}
 }
 
@@ -169,7 +169,7 @@ static void save_hashtab(struct ta_elf *elf)
 						  phdr[n].p_vaddr,
 						  phdr[n].p_memsz);
 	}
-	assert(elf->hashtab);
+	assert(elf->hashtab || elf->gnu_hashtab);
 }
 
 static void e32_save_symtab(struct ta_elf *elf, size_t tab_idx)
@@ -790,8 +790,44 @@ static void add_deps_from_segment(struct ta_elf *elf, unsigned int type,
 	}
 }
 
+/*
+ * Tell the system PTA about the dependencies queued after @last so the
+ * TA stores can start fetching them concurrently. They're still opened,
+ * verified and mapped one by one in queue order afterwards.
+ */
+static void prefetch_dependencies(struct ta_elf *last)
+{
+	TEE_UUID *uuids = NULL;
+	struct ta_elf *elf = last;
+	size_t num = 0;
+	size_t n = 0;
+
+	while ((elf = TAILQ_NEXT(elf, link)))
+		num++;
+	/* Nothing to overlap with a single dependency */
+	if (num < 2)
+		return;
+	num = MIN(num, (size_t)PTA_SYSTEM_PREFETCH_MAX_UUIDS);
+
+	uuids = malloc(num * sizeof(*uuids));
+	if (!uuids)
+		return;
+
+	elf = last;
+	for (n = 0; n < num; n++) {
+		elf = TAILQ_NEXT(elf, link);
+		uuids[n] = elf->uuid;
+	}
+
+	/* Only a hint, the core may not support it */
+	if (sys_prefetch_ta_bins(uuids, num))
+		DMSG("sys_prefetch_ta_bins failed");
+	free(uuids);
+}
+
 static void add_dependencies(struct ta_elf *elf)
 {
+	struct ta_elf *last = TAILQ_LAST(&main_elf_queue, ta_elf_queue);
 	size_t n = 0;
 
 	if (elf->is_32bit) {
@@ -807,6 +843,8 @@ static void add_dependencies(struct ta_elf *elf)
 			add_deps_from_segment(elf, phdr[n].p_type,
 					      phdr[n].p_vaddr, phdr[n].p_memsz);
 	}
+
+	prefetch_dependencies(last);
 }
 
 static void copy_section_headers(struct ta_elf *elf)
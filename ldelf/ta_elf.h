@@ -55,8 +55,13 @@ struct ta_elf {
 	const char *dynstr;
 	size_t dynstr_size;
 
-	/* DT_HASH hash table for faster resolution of external symbols */
+	/*
+	 * DT_HASH and DT_GNU_HASH hash tables for faster resolution of
+	 * external symbols, at least one of them is present. DT_GNU_HASH
+	 * is used when available.
+	 */
 	void *hashtab;
+	void *gnu_hashtab;
 
 	struct segment_head segs;
 
@@ -96,6 +101,19 @@ static inline void ta_elf_stack_trace_a64(uint64_t fp __unused,
 					  uint64_t pc __unused) { }
 #endif /*CFG_UNWIND*/
 
+/*
+ * struct ta_elf_sym_stats - statistics of external symbol resolution
+ * @lookups:		Number of calls to ta_elf_resolve_sym()
+ * @cache_hits:		Number of lookups served by the resolved-symbol cache
+ * @bloom_rejects:	Number of ELFs skipped by the DT_GNU_HASH bloom filter
+ */
+struct ta_elf_sym_stats {
+	size_t lookups;
+	size_t cache_hits;
+	size_t bloom_rejects;
+};
+
 TEE_Result ta_elf_resolve_sym(const char *name, vaddr_t *val);
+void ta_elf_get_sym_stats(struct ta_elf_sym_stats *stats);
 
 #endif /*TA_ELF_H*/
@@ -7,6 +7,7 @@
 #include <elf32.h>
 #include <elf64.h>
 #include <elf_common.h>
+#include <malloc.h>
 #include <string.h>
 #include <tee_api_types.h>
 #include <util.h>
@@ -14,6 +15,23 @@
 #include "sys.h"
 #include "ta_elf.h"
 
+/*
+ * Symbols already resolved are remembered in a small direct mapped cache
+ * indexed with the GNU hash of the name. The cache is only used once all
+ * ELFs are loaded, that is, while relocating, so a cached value is always
+ * the one a full lookup would have returned.
+ */
+#define SYM_CACHE_SIZE		256
+
+struct sym_cache_entry {
+	const char *name;
+	uint32_t hash;
+	vaddr_t val;
+};
+
+static struct sym_cache_entry sym_cache[SYM_CACHE_SIZE];
+static struct ta_elf_sym_stats sym_stats;
+
 static uint32_t elf_hash(const char *name)
 {
 	const unsigned char *p = (const unsigned char *)name;
@@ -30,6 +48,16 @@ static uint32_t elf_hash(const char *name)
 	return h;
 }
 
+static uint32_t gnu_hash(const char *name)
+{
+	const unsigned char *p = (const unsigned char *)name;
+	uint32_t h = 5381;
+
+	while (*p)
+		h = (h << 5) + h + *p++;
+	return h;
+}
+
 static bool __resolve_sym(struct ta_elf *elf, unsigned int bind,
 			  size_t st_shndx, size_t st_name, size_t st_value,
 			  const char *name, vaddr_t *val)
@@ -50,51 +78,162 @@ static bool __resolve_sym(struct ta_elf *elf, unsigned int bind,
 	return true;
 }
 
+static bool resolve_sym_idx(struct ta_elf *elf, size_t n, const char *name,
+			    vaddr_t *val)
+{
+	if (n >= elf->num_dynsyms)
+		err(TEE_ERROR_BAD_FORMAT, "Symbol index out of range");
+
+	if (elf->is_32bit) {
+		Elf32_Sym *sym = elf->dynsymtab;
+
+		return __resolve_sym(elf, ELF32_ST_BIND(sym[n].st_info),
+				     sym[n].st_shndx, sym[n].st_name,
+				     sym[n].st_value, name, val);
+	} else {
+		Elf64_Sym *sym = elf->dynsymtab;
+
+		return __resolve_sym(elf, ELF64_ST_BIND(sym[n].st_info),
+				     sym[n].st_shndx, sym[n].st_name,
+				     sym[n].st_value, name, val);
+	}
+}
+
+static bool resolve_sym_hash(struct ta_elf *elf, uint32_t hash,
+			     const char *name, vaddr_t *val)
+{
+	/*
+	 * Using uint32_t here for convenience because both Elf64_Word
+	 * and Elf32_Word are 32-bit types
+	 */
+	uint32_t *hashtab = elf->hashtab;
+	uint32_t nbuckets = hashtab[0];
+	uint32_t nchains = hashtab[1];
+	uint32_t *bucket = &hashtab[2];
+	uint32_t *chain = &bucket[nbuckets];
+	size_t n = 0;
+
+	for (n = bucket[hash % nbuckets]; n; n = chain[n]) {
+		assert(n < nchains);
+		if (resolve_sym_idx(elf, n, name, val))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * The DT_GNU_HASH table is laid out as:
+ * uint32_t nbuckets;
+ * uint32_t symoffset;
+ * uint32_t bloom_size;
+ * uint32_t bloom_shift;
+ * Elf32_Addr/Elf64_Addr bloom[bloom_size];
+ * uint32_t buckets[nbuckets];
+ * uint32_t chain[];
+ *
+ * The bloom filter rejects most names not defined by the ELF without
+ * touching the buckets. Chain values are the hashes of the symbols with
+ * the lowest bit set on the last symbol of a bucket.
+ */
+static bool resolve_sym_gnu_hash(struct ta_elf *elf, uint32_t hash,
+				 const char *name, vaddr_t *val)
+{
+	uint32_t *hashtab = elf->gnu_hashtab;
+	uint32_t nbuckets = hashtab[0];
+	uint32_t symoffset = hashtab[1];
+	uint32_t bloom_size = hashtab[2];
+	uint32_t bloom_shift = hashtab[3];
+	uint32_t *bucket = NULL;
+	uint32_t *chain = NULL;
+	uint32_t h2 = 0;
+	size_t n = 0;
+
+	if (!nbuckets || !bloom_size)
+		return false;
+
+	if (elf->is_32bit) {
+		uint32_t *bloom = hashtab + 4;
+		uint32_t word = bloom[(hash / 32) % bloom_size];
+		uint32_t mask = BIT32(hash % 32) |
+				BIT32((hash >> bloom_shift) % 32);
+
+		if ((word & mask) != mask)
+			goto bloom_reject;
+		bucket = (uint32_t *)(bloom + bloom_size);
+	} else {
+		uint64_t *bloom = (uint64_t *)(hashtab + 4);
+		uint64_t word = bloom[(hash / 64) % bloom_size];
+		uint64_t mask = BIT64(hash % 64) |
+				BIT64((hash >> bloom_shift) % 64);
+
+		if ((word & mask) != mask)
+			goto bloom_reject;
+		bucket = (uint32_t *)(bloom + bloom_size);
+	}
+	chain = bucket + nbuckets;
+
+	n = bucket[hash % nbuckets];
+	if (n < symoffset)
+		return false;
+
+	while (true) {
+		if (n >= elf->num_dynsyms)
+			err(TEE_ERROR_BAD_FORMAT, "Symbol index out of range");
+		h2 = chain[n - symoffset];
+		if ((hash | 1) == (h2 | 1) &&
+		    resolve_sym_idx(elf, n, name, val))
+			return true;
+		if (h2 & 1)
+			return false;
+		n++;
+	}
+
+bloom_reject:
+	sym_stats.bloom_rejects++;
+	return false;
+}
+
 TEE_Result ta_elf_resolve_sym(const char *name, vaddr_t *val)
 {
-	uint32_t hash = elf_hash(name);
+	uint32_t ghash = gnu_hash(name);
+	struct sym_cache_entry *ce = sym_cache + ghash % SYM_CACHE_SIZE;
 	struct ta_elf *elf = NULL;
-	size_t n = 0;
+	uint32_t hash = 0;
+	bool have_hash = false;
+
+	sym_stats.lookups++;
+	if (ce->name && ce->hash == ghash && !strcmp(ce->name, name)) {
+		sym_stats.cache_hits++;
+		*val = ce->val;
+		return TEE_SUCCESS;
+	}
 
 	TAILQ_FOREACH(elf, &main_elf_queue, link) {
-		/*
-		 * Using uint32_t here for convenience because both Elf64_Word
-		 * and Elf32_Word are 32-bit types
-		 */
-		uint32_t *hashtab = elf->hashtab;
-		uint32_t nbuckets = hashtab[0];
-		uint32_t nchains = hashtab[1];
-		uint32_t *bucket = &hashtab[2];
-		uint32_t *chain = &bucket[nbuckets];
-
-		if (elf->is_32bit) {
-			Elf32_Sym *sym = elf->dynsymtab;
-
-			for (n = bucket[hash % nbuckets]; n; n = chain[n]) {
-				assert(n < nchains);
-				if (__resolve_sym(elf,
-						  ELF32_ST_BIND(sym[n].st_info),
-						  sym[n].st_shndx,
-						  sym[n].st_name,
-						  sym[n].st_value, name, val))
-					return TEE_SUCCESS;
-			}
+		if (elf->gnu_hashtab) {
+			if (resolve_sym_gnu_hash(elf, ghash, name, val))
+				goto found;
 		} else {
-			Elf64_Sym *sym = elf->dynsymtab;
-
-			for (n = bucket[hash % nbuckets]; n; n = chain[n]) {
-				assert(n < nchains);
-				if (__resolve_sym(elf,
-						  ELF64_ST_BIND(sym[n].st_info),
-						  sym[n].st_shndx,
-						  sym[n].st_name,
-						  sym[n].st_value, name, val))
-					return TEE_SUCCESS;
+			if (!have_hash) {
+				hash = elf_hash(name);
+				have_hash = true;
 			}
+			if (resolve_sym_hash(elf, hash, name, val))
+				goto found;
 		}
 	}
 
 	return TEE_ERROR_ITEM_NOT_FOUND;
+found:
+	ce->name = name;
+	ce->hash = ghash;
+	ce->val = *val;
+	return TEE_SUCCESS;
+}
+
+void ta_elf_get_sym_stats(struct ta_elf_sym_stats *stats)
+{
+	*stats = sym_stats;
 }
 
 static void resolve_sym(const char *name, vaddr_t *val)
@@ -349,10 +488,129 @@ static void e64_relocate(struct ta_elf *elf __unused,
 }
 #endif /*ARM64*/
 
+#ifdef CFG_TA_RELOC_CACHE
+/*
+ * struct reloc_cache_args - arguments to sys_reloc_cache_*()
+ * @addrs:	Load address of the ELF followed by all other ELFs
+ * @num_addrs:	Number of elements in @addrs
+ * @segs:	Page aligned address and size pairs of the writable segments
+ * @num_segs:	Number of pairs in @segs
+ */
+struct reloc_cache_args {
+	uint64_t *addrs;
+	size_t num_addrs;
+	uint64_t *segs;
+	size_t num_segs;
+};
+
+static bool get_reloc_cache_args(struct ta_elf *elf,
+				 struct reloc_cache_args *args)
+{
+	struct segment *seg = NULL;
+	struct ta_elf *e = NULL;
+	size_t n = 0;
+
+	if (elf->is_legacy)
+		return false;
+
+	TAILQ_FOREACH(e, &main_elf_queue, link)
+		args->num_addrs++;
+	TAILQ_FOREACH(seg, &elf->segs, link)
+		if (seg->flags & PF_W)
+			args->num_segs++;
+	if (!args->num_segs)
+		return false;
+
+	args->addrs = calloc(args->num_addrs, sizeof(*args->addrs));
+	args->segs = calloc(args->num_segs * 2, sizeof(*args->segs));
+	if (!args->addrs || !args->segs) {
+		free(args->addrs);
+		free(args->segs);
+		*args = (struct reloc_cache_args){ };
+		return false;
+	}
+
+	args->addrs[0] = elf->load_addr;
+	n = 1;
+	TAILQ_FOREACH(e, &main_elf_queue, link)
+		if (e != elf)
+			args->addrs[n++] = e->load_addr;
+
+	n = 0;
+	TAILQ_FOREACH(seg, &elf->segs, link) {
+		vaddr_t va = elf->load_addr + seg->vaddr;
+
+		if (!(seg->flags & PF_W))
+			continue;
+		args->segs[n * 2] = ROUNDDOWN(va, SMALL_PAGE_SIZE);
+		args->segs[n * 2 + 1] = ROUNDUP(va + seg->memsz,
+						SMALL_PAGE_SIZE) -
+					args->segs[n * 2];
+		n++;
+	}
+
+	return true;
+}
+
+/*
+ * Restores the writable segments of the ELF from the relocation cache.
+ * Returns true if found, else the ELF must be relocated and @args is
+ * kept for reloc_cache_add().
+ */
+static bool reloc_cache_lookup(struct ta_elf *elf,
+			       struct reloc_cache_args *args)
+{
+	if (!get_reloc_cache_args(elf, args))
+		return false;
+
+	if (sys_reloc_cache_lookup(args->addrs, args->num_addrs, args->segs,
+				   args->num_segs))
+		return false;
+
+	free(args->addrs);
+	free(args->segs);
+	return true;
+}
+
+static void reloc_cache_add(struct reloc_cache_args *args)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!args->num_segs)
+		return;
+
+	/* Failing to add to the cache isn't fatal */
+	res = sys_reloc_cache_add(args->addrs, args->num_addrs, args->segs,
+				  args->num_segs);
+	if (res)
+		DMSG("sys_reloc_cache_add: %#"PRIx32, res);
+
+	free(args->addrs);
+	free(args->segs);
+}
+#else
+struct reloc_cache_args {
+};
+
+static bool reloc_cache_lookup(struct ta_elf *elf __unused,
+			       struct reloc_cache_args *args __unused)
+{
+	return false;
+}
+
+static void reloc_cache_add(struct reloc_cache_args *args __unused)
+{
+}
+#endif /*CFG_TA_RELOC_CACHE*/
+
 void ta_elf_relocate(struct ta_elf *elf)
 {
+	struct reloc_cache_args cache_args = { };
 	size_t n = 0;
 
+	if (reloc_cache_lookup(elf, &cache_args))
+		return;
+
 	if (elf->is_32bit) {
 		Elf32_Shdr *shdr = elf->shdr;
 
@@ -367,4 +625,6 @@ void ta_elf_relocate(struct ta_elf *elf)
 				e64_relocate(elf, n);
 
 	}
+
+	reloc_cache_add(&cache_args);
 }
@@ -1850,8 +1850,11 @@ int mbedtls_mpi_exp_mod( mbedtls_mpi *X, const mbedtls_mpi *A,
     else
         memcpy( &RR, _RR, sizeof( mbedtls_mpi ) );
 
-    W = mempool_alloc( mbedtls_mpi_mempool,
-                       sizeof( mbedtls_mpi ) * array_size_W );
+    if( mbedtls_mpi_mempool )
+        W = mempool_alloc( mbedtls_mpi_mempool,
+                           sizeof( mbedtls_mpi ) * array_size_W );
+    else
+        W = mbedtls_calloc( array_size_W, sizeof( mbedtls_mpi ) );
     if( W == NULL ) {
         ret = MBEDTLS_ERR_MPI_ALLOC_FAILED;
         goto cleanup;
@@ -1994,7 +1997,10 @@ cleanup:
     if( W )
         for( i = 0; i < array_size_W; i++ )
             mbedtls_mpi_free( W + i );
-    mempool_free( mbedtls_mpi_mempool , W );
+    if( mbedtls_mpi_mempool )
+        mempool_free( mbedtls_mpi_mempool , W );
+    else
+        mbedtls_free( W );
 
     mbedtls_mpi_free( &T ); mbedtls_mpi_free( &Apos );
 
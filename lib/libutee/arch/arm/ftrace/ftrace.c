@@ -11,88 +11,67 @@
  */
 
 #include <setjmp.h>
+#include <stdbool.h>
 #include <user_ta_header.h>
 #include <utee_syscalls.h>
 #include "ftrace.h"
 
-static const char hex_str[] = "0123456789abcdef";
-
-/*
- * This API shifts/moves ftrace buffer to create space for new dump
- * in case the buffer size falls short of actual dump.
- */
-static void __noprof fbuf_shift(struct ftrace_buf *fbuf, size_t size)
+static uint64_t __noprof read_cntpct(void)
 {
-	char *dst = (char *)fbuf + fbuf->buf_off;
-	const char *src = (char *)fbuf + fbuf->buf_off + size;
-	size_t n = 0;
-
-	fbuf->curr_size -= size;
-
-	for (n = 0; n < fbuf->curr_size; n++)
-		dst[n] = src[n];
+	uint64_t val = 0;
+
+#ifdef __aarch64__
+	asm volatile("mrs %0, cntpct_el0" : "=r" (val));
+#else
+	asm volatile("mrrc p15, 0, %Q0, %R0, c14" : "=r" (val));
+#endif
+	return val;
 }
 
-static size_t __noprof to_func_enter_fmt(char *buf, uint32_t ret_idx,
-					 unsigned long pc)
+/*
+ * Records the entry or exit of the function @pc at the current call
+ * depth. When the buffer is full the oldest record is overwritten in ring
+ * mode, else the record is dropped.
+ */
+static void __noprof add_rec(struct ftrace_buf *fbuf, unsigned long pc,
+			     bool is_exit)
 {
-	char *str = buf;
-	uint32_t addr_size = 2 * sizeof(unsigned long);
-	uint32_t i = 0;
-
-	for (i = 0; i < ret_idx; i++)
-		*str++ = ' ';
-
-	*str++ = '0';
-	*str++ = 'x';
+	struct ftrace_rec *rec = NULL;
 
-	for (i = 0; i < addr_size; i++)
-		*str++ = hex_str[(pc >> 4 * (addr_size - i - 1)) & 0xf];
-
-	*str++ = '(';
-	*str++ = ')';
-	*str++ = ' ';
-	*str++ = '{';
-	*str++ = '\n';
-	*str = '\0';
+	if (fbuf->rec_count >= fbuf->max_recs &&
+	    !(fbuf->flags & FTRACE_BUF_FLAG_RING))
+		return;
 
-	return str - buf;
+	rec = (struct ftrace_rec *)((char *)fbuf + fbuf->buf_off) +
+	      (fbuf->rec_count & (fbuf->max_recs - 1));
+	rec->ts = read_cntpct();
+	rec->pc = pc;
+	rec->depth = fbuf->ret_idx;
+	rec->is_exit = is_exit;
+	fbuf->rec_count++;
 }
 
 void __noprof ftrace_enter(unsigned long pc, unsigned long *lr)
 {
 	struct ftrace_buf *fbuf = NULL;
-	size_t dump_size = 0;
 
 	fbuf = &__ftrace_buf_start;
 
-	if (!fbuf->buf_off || !fbuf->max_size)
+	if (!fbuf->buf_off || !fbuf->max_recs)
 		return;
 
-	dump_size = fbuf->ret_idx + (2 * sizeof(unsigned long)) + 8;
-
 	/*
-	 * Check if we have enough space in ftrace buffer. If not then just
-	 * remove oldest dump under the assumption that its the least
-	 * interesting data.
+	 * This scenario isn't expected as function call depth
+	 * shouldn't be more than FTRACE_RETFUNC_DEPTH.
 	 */
-	if ((fbuf->curr_size + dump_size) > fbuf->max_size)
-		fbuf_shift(fbuf, dump_size);
-
-	fbuf->curr_size += to_func_enter_fmt((char *)fbuf + fbuf->buf_off +
-					     fbuf->curr_size, fbuf->ret_idx,
-					     pc);
-
-	if (fbuf->ret_idx < FTRACE_RETFUNC_DEPTH) {
-		fbuf->ret_stack[fbuf->ret_idx] = *lr;
-		fbuf->ret_idx++;
-	} else {
-		/*
-		 * This scenario isn't expected as function call depth
-		 * shouldn't be more than FTRACE_RETFUNC_DEPTH.
-		 */
+	if (fbuf->ret_idx >= FTRACE_RETFUNC_DEPTH)
 		utee_panic(0);
-	}
+
+	add_rec(fbuf, pc, false);
+
+	fbuf->ret_stack[fbuf->ret_idx] = *lr;
+	fbuf->func_stack[fbuf->ret_idx] = pc;
+	fbuf->ret_idx++;
 
 	*lr = (unsigned long)&__ftrace_return;
 }
@@ -100,9 +79,6 @@ void __noprof ftrace_enter(unsigned long pc, unsigned long *lr)
 unsigned long __noprof ftrace_return(void)
 {
 	struct ftrace_buf *fbuf = NULL;
-	size_t dump_size = 0;
-	char *curr_buf = NULL;
-	uint32_t i = 0;
 
 	fbuf = &__ftrace_buf_start;
 
@@ -112,34 +88,7 @@ unsigned long __noprof ftrace_return(void)
 	else
 		return 0;
 
-	curr_buf = (char *)fbuf + fbuf->buf_off + fbuf->curr_size;
-
-	/*
-	 * Check for '{' symbol as it represents if it is an exit from current
-	 * or nested function. If exit is from current function, than exit dump
-	 * via ';' symbol else exit dump via '}' symbol.
-	 */
-	if (*(curr_buf - 2) == '{') {
-		*(curr_buf - 3) = ';';
-		*(curr_buf - 2) = '\n';
-		*(curr_buf - 1) = '\0';
-		fbuf->curr_size -= 1;
-	} else {
-		dump_size = fbuf->ret_idx + 3;
-		if ((fbuf->curr_size + dump_size) > fbuf->max_size)
-			fbuf_shift(fbuf, dump_size);
-
-		curr_buf = (char *)fbuf + fbuf->buf_off + fbuf->curr_size;
-
-		for (i = 0; i < fbuf->ret_idx; i++)
-			*curr_buf++ = ' ';
-
-		*curr_buf++ = '}';
-		*curr_buf++ = '\n';
-		*curr_buf = '\0';
-
-		fbuf->curr_size += dump_size - 1;
-	}
+	add_rec(fbuf, fbuf->func_stack[fbuf->ret_idx], true);
 
 	return fbuf->ret_stack[fbuf->ret_idx];
 }
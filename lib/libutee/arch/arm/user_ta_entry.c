@@ -2,6 +2,7 @@
 /*
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
+#include <atomic.h>
 #include <compiler.h>
 #include <stdbool.h>
 #include <string.h>
@@ -19,6 +20,7 @@
 struct ta_session {
 	uint32_t session_id;
 	void *session_ctx;
+	struct prop_cache *prop_cache;
 	TAILQ_ENTRY(ta_session) link;
 };
 
@@ -27,6 +29,15 @@ static TAILQ_HEAD(ta_sessions, ta_session) ta_sessions =
 
 static bool init_done;
 
+/*
+ * Protects ta_sessions if the TA executes sessions concurrently, user mode
+ * can't sleep so it's a spinlock.
+ */
+static unsigned int ta_sessions_lock;
+
+/* Session being entered, unknown if sessions are executed concurrently */
+static struct ta_session *cur_session;
+
 /* From user_ta_header.c, built within TA */
 extern uint8_t ta_heap[];
 extern const size_t ta_heap_size;
@@ -50,9 +61,26 @@ static void uninit_instance(void)
 	TA_DestroyEntryPoint();
 }
 
+static void lock_sessions(void)
+{
+	unsigned int unlocked = 0;
+
+	while (!atomic_cas_uint(&ta_sessions_lock, &unlocked, 1))
+		unlocked = 0;
+}
+
+static void unlock_sessions(void)
+{
+	__atomic_store_n(&ta_sessions_lock, 0, __ATOMIC_RELEASE);
+}
+
 static void ta_header_save_params(uint32_t param_types,
 				  TEE_Param params[TEE_NUM_PARAMS])
 {
+	/* Can't tell which of the concurrent invocations they'd belong to */
+	if (ta_head.flags & TA_FLAG_CONCURRENT)
+		return;
+
 	ta_param_types = param_types;
 
 	if (params)
@@ -61,15 +89,31 @@ static void ta_header_save_params(uint32_t param_types,
 		memset(ta_params, 0, sizeof(ta_params));
 }
 
+static void set_cur_session(struct ta_session *session)
+{
+	if (!(ta_head.flags & TA_FLAG_CONCURRENT))
+		cur_session = session;
+}
+
+struct prop_cache **__utee_session_prop_cache(void)
+{
+	if (!cur_session)
+		return NULL;
+	return &cur_session->prop_cache;
+}
+
 static struct ta_session *ta_header_get_session(uint32_t session_id)
 {
 	struct ta_session *itr;
 
+	lock_sessions();
 	TAILQ_FOREACH(itr, &ta_sessions, link) {
 		if (itr->session_id == session_id)
-			return itr;
+			break;
 	}
-	return NULL;
+	unlock_sessions();
+
+	return itr;
 }
 
 static TEE_Result ta_header_add_session(uint32_t session_id)
@@ -80,6 +124,10 @@ static TEE_Result ta_header_add_session(uint32_t session_id)
 	if (itr)
 		return TEE_SUCCESS;
 
+	/*
+	 * The first session is opened before the instance can execute
+	 * sessions concurrently.
+	 */
 	if (!init_done) {
 		init_done = true;
 		res = init_instance();
@@ -93,7 +141,10 @@ static TEE_Result ta_header_add_session(uint32_t session_id)
 		return TEE_ERROR_OUT_OF_MEMORY;
 	itr->session_id = session_id;
 	itr->session_ctx = 0;
+	itr->prop_cache = NULL;
+	lock_sessions();
 	TAILQ_INSERT_TAIL(&ta_sessions, itr, link);
+	unlock_sessions();
 
 	return TEE_SUCCESS;
 }
@@ -102,21 +153,30 @@ static void ta_header_remove_session(uint32_t session_id)
 {
 	struct ta_session *itr;
 	bool keep_alive;
+	bool empty;
 
+	lock_sessions();
 	TAILQ_FOREACH(itr, &ta_sessions, link) {
 		if (itr->session_id == session_id) {
 			TAILQ_REMOVE(&ta_sessions, itr, link);
-			TEE_Free(itr);
-
-			keep_alive =
-				(ta_head.flags & TA_FLAG_SINGLE_INSTANCE) &&
-				(ta_head.flags & TA_FLAG_INSTANCE_KEEP_ALIVE);
-			if (TAILQ_EMPTY(&ta_sessions) && !keep_alive)
-				uninit_instance();
-
-			return;
+			break;
 		}
 	}
+	empty = TAILQ_EMPTY(&ta_sessions);
+	unlock_sessions();
+
+	if (!itr)
+		return;
+
+	if (itr == cur_session)
+		cur_session = NULL;
+	__utee_free_prop_cache(itr->prop_cache);
+	TEE_Free(itr);
+
+	keep_alive = (ta_head.flags & TA_FLAG_SINGLE_INSTANCE) &&
+		     (ta_head.flags & TA_FLAG_INSTANCE_KEEP_ALIVE);
+	if (empty && !keep_alive)
+		uninit_instance();
 }
 
 static void to_utee_params(struct utee_params *up, uint32_t param_types,
@@ -198,6 +258,7 @@ static TEE_Result entry_open_session(unsigned long session_id,
 
 	from_utee_params(params, &param_types, up);
 	ta_header_save_params(param_types, params);
+	set_cur_session(session);
 
 	res = TA_OpenSessionEntryPoint(param_types, params,
 				       &session->session_ctx);
@@ -216,6 +277,7 @@ static TEE_Result entry_close_session(unsigned long session_id)
 	if (!session)
 		return TEE_ERROR_BAD_STATE;
 
+	set_cur_session(session);
 	TA_CloseSessionEntryPoint(session->session_ctx);
 
 	ta_header_remove_session(session_id);
@@ -235,6 +297,7 @@ static TEE_Result entry_invoke_command(unsigned long session_id,
 
 	from_utee_params(params, &param_types, up);
 	ta_header_save_params(param_types, params);
+	set_cur_session(session);
 
 	res = TA_InvokeCommandEntryPoint(session->session_ctx, cmd_id,
 					 param_types, params);
@@ -264,6 +327,7 @@ TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 		break;
 	}
 	ta_header_save_params(0, NULL);
+	set_cur_session(NULL);
 
 	return res;
 }
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2019, agent
+ */
+
+#ifndef __PTA_CORE_PROF_H
+#define __PTA_CORE_PROF_H
+
+#include <stdint.h>
+
+/*
+ * Interface to the core profiling pseudo-TA, which samples the program
+ * counter of the TEE core and collects syscall latencies.
+ */
+
+#define PTA_CORE_PROF_UUID { 0x122a7cc3, 0xfd5f, 0x4130, { \
+			     0xac, 0xfd, 0xf0, 0xfc, 0xbb, 0x05, 0x1c, 0xf2 } }
+
+/*
+ * Start sampling the program counter with the secure physical timer, the
+ * samples of a previous run are cleared. Each CPU starts sampling the next
+ * time it enters secure world with a standard call.
+ *
+ * [in]     value[0].a: Sampling period in microseconds
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED if not available on this platform.
+ */
+#define PTA_CORE_PROF_PC_START		0
+
+/*
+ * Stop sampling the program counter
+ */
+#define PTA_CORE_PROF_PC_STOP		1
+
+/*
+ * Get the program counter histogram
+ *
+ * [out]    memref[0]: struct core_prof_pc_hdr followed by num_buckets
+ *		       uint32_t sample counts, bucket n counts the samples
+ *		       in [start_va + (n << bucket_shift),
+ *		       start_va + ((n + 1) << bucket_shift)).
+ *		       If too small, TEE_ERROR_SHORT_BUFFER is returned
+ *		       with the required size.
+ */
+#define PTA_CORE_PROF_PC_GET		2
+
+/*
+ * Get the syscall latency histograms
+ *
+ * [out]    memref[0]: struct core_prof_syscall_hdr followed by
+ *		       num_syscalls struct core_prof_syscall indexed with
+ *		       the syscall number (TEE_SCN_*). If too small,
+ *		       TEE_ERROR_SHORT_BUFFER is returned with the required
+ *		       size.
+ * [in]     value[1].a: If non-zero, reset the histograms once copied
+ */
+#define PTA_CORE_PROF_SYSCALL_GET	3
+
+struct core_prof_pc_hdr {
+	uint64_t start_va;
+	uint32_t bucket_shift;
+	uint32_t num_buckets;
+	uint32_t user_samples;	/* Samples in a user TA */
+	uint32_t ns_samples;	/* Samples in normal world */
+	uint32_t other_samples;	/* Samples outside of the histogram */
+	uint32_t pad;
+};
+
+#define CORE_PROF_SYSCALL_BUCKETS	24
+
+struct core_prof_syscall {
+	uint32_t count;
+	uint32_t pad;
+	uint64_t total;		/* Sum of latencies in counter ticks */
+	uint64_t max;		/* Maximal latency in counter ticks */
+	/*
+	 * buckets[0] counts latencies below 2 ticks, buckets[n] latencies
+	 * in [2^n, 2^(n+1)) ticks and the last bucket all longer ones
+	 */
+	uint32_t buckets[CORE_PROF_SYSCALL_BUCKETS];
+};
+
+struct core_prof_syscall_hdr {
+	uint64_t freq;		/* Counter frequency in Hz */
+	uint32_t num_syscalls;
+	uint32_t pad;
+};
+
+#endif /* __PTA_CORE_PROF_H */
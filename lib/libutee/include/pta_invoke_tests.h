@@ -73,5 +73,28 @@
  */
 #define PTA_INVOKE_TESTS_CMD_LOCKDEP		8
 
+/*
+ * Measures ECC key generation, ECDSA sign and verify throughput
+ *
+ * [in]  value[0].a	Curve, TEE_ECC_CURVE_NIST_*
+ * [in]  value[0].b	Number of iterations of each operation
+ * [out] value[1].a	Key generations per second
+ * [out] value[1].b	Signatures per second
+ * [out] value[2].a	Verifications per second
+ */
+#define PTA_INVOKE_TESTS_CMD_ECC_BENCH		9
+
+/*
+ * Returns the sum of the two value parameters, meant to measure the round
+ * trip latency of a minimal invoke. The parameters are those passed with
+ * OPTEE_SMC_CALL_INVOKE_WITH_REGS so the same command can be timed with
+ * either calling convention.
+ *
+ * [in/out] value[0].a	Added to value[1].a
+ * [in/out] value[0].b	Added to value[1].b
+ * [in]     value[1]
+ */
+#define PTA_INVOKE_TESTS_CMD_ECHO		10
+
 #endif /*__PTA_INVOKE_TESTS_H*/
 
@@ -160,4 +160,44 @@
  */
 #define PTA_SYSTEM_REMAP		9
 
+/*
+ * Relocated writable segments cache
+ *
+ * The writable segments of an ELF are private to each TA instance and
+ * relocated by ldelf when loaded. When all the ELFs of a TA are loaded
+ * from the same binaries at the same addresses as in an earlier load, the
+ * relocated writable segments are identical too. ldelf can then restore
+ * them from the cache instead of relocating again.
+ *
+ * Only available while the TA is loaded by ldelf and only if
+ * CFG_TA_RELOC_CACHE=y, else TEE_ERROR_ACCESS_DENIED or
+ * TEE_ERROR_NOT_SUPPORTED is returned.
+ *
+ * [in]     memref[0]:	Array of uint64_t with the load addresses of all
+ *			the ELFs of the TA, starting with the relocated ELF
+ * [in]     memref[1]:	Array of uint64_t pairs with address and size of
+ *			each writable segment of the relocated ELF, page
+ *			aligned
+ *
+ * PTA_SYSTEM_RELOC_CACHE_LOOKUP returns TEE_ERROR_ITEM_NOT_FOUND if the
+ * segments aren't cached, else they are restored.
+ * PTA_SYSTEM_RELOC_CACHE_ADD saves the relocated segments.
+ */
+#define PTA_SYSTEM_RELOC_CACHE_LOOKUP	10
+#define PTA_SYSTEM_RELOC_CACHE_ADD	11
+
+/*
+ * Prefetch TA binaries
+ *
+ * Hint that the TA binaries in the list are about to be opened with
+ * PTA_SYSTEM_OPEN_TA_BINARY. The TA stores may start fetching them
+ * concurrently in the background, before they are opened one by one.
+ *
+ * [in]     memref[0]:	Array of TEE_UUID of the TA binaries, at most
+ *			PTA_SYSTEM_PREFETCH_MAX_UUIDS
+ */
+#define PTA_SYSTEM_PREFETCH_TA_BINARIES	12
+
+#define PTA_SYSTEM_PREFETCH_MAX_UUIDS	32
+
 #endif /* __PTA_SYSTEM_H */
@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2019, agent
+ */
+
+#ifndef __PTA_TRACE_RING_H
+#define __PTA_TRACE_RING_H
+
+#include <stdint.h>
+
+/*
+ * Interface to the trace ring pseudo-TA, which controls the per-CPU
+ * binary event rings of the TEE core and exports their content. See
+ * scripts/trace_ring_decode.py to convert a dump into a viewable trace.
+ */
+
+#define PTA_TRACE_RING_UUID { 0x38df2cbb, 0x2524, 0x4965, { \
+			      0x80, 0x2b, 0x6e, 0x61, 0xf7, 0xda, 0x5a, 0xd1 } }
+
+/*
+ * Start recording events. The rings are statically allocated in the TEE
+ * core, CFG_CORE_TRACE_RING_EVENTS struct trace_ring_event per CPU, so
+ * their memory is reserved whether recording is started or not. They keep
+ * the events recorded before a previous stop.
+ */
+#define PTA_TRACE_RING_START		0
+
+/*
+ * Stop recording events
+ */
+#define PTA_TRACE_RING_STOP		1
+
+/*
+ * Copy the rings into a buffer. Recording should be stopped first or
+ * events written during the copy may be torn.
+ *
+ * [out]    memref[0]: struct trace_ring_hdr followed by one
+ *		       struct trace_ring_cpu per CPU, each followed by
+ *		       trace_ring_hdr::num_events struct trace_ring_event.
+ *		       If too small, TEE_ERROR_SHORT_BUFFER is returned
+ *		       with the required size.
+ */
+#define PTA_TRACE_RING_DUMP		2
+
+/* Event IDs, the _BEGIN and _END events of a pair differ in bit 0 only */
+#define TRACE_RING_SMC_BEGIN		0x02	/* arg: OPTEE_MSG_CMD_* */
+#define TRACE_RING_SMC_END		0x03
+#define TRACE_RING_RPC_BEGIN		0x04	/* arg: OPTEE_RPC_CMD_* */
+#define TRACE_RING_RPC_END		0x05
+#define TRACE_RING_PAGER_FAULT_BEGIN	0x06	/* arg: faulting page number */
+#define TRACE_RING_PAGER_FAULT_END	0x07
+#define TRACE_RING_WAIT_BEGIN		0x08	/* arg: lower bits of lock */
+#define TRACE_RING_WAIT_END		0x09
+#define TRACE_RING_SYSCALL_BEGIN	0x0a	/* arg: TEE_SCN_* */
+#define TRACE_RING_SYSCALL_END		0x0b
+
+#define TRACE_RING_MAGIC		0x5254504f	/* "OPTR" */
+#define TRACE_RING_VERSION		1
+
+/* Thread of an event recorded outside of any thread */
+#define TRACE_RING_NO_THREAD		0xffff
+
+struct trace_ring_event {
+	uint64_t ts;		/* Counter value, CNTPCT */
+	uint16_t id;
+	uint16_t thread;
+	uint32_t arg;
+};
+
+struct trace_ring_cpu {
+	uint64_t head;		/* Number of events ever written */
+};
+
+struct trace_ring_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_cpus;
+	uint32_t num_events;	/* Per CPU, a power of 2 */
+	uint64_t freq;		/* Counter frequency in Hz */
+};
+
+#endif /* __PTA_TRACE_RING_H */
@@ -19,8 +19,8 @@
 #define TA_FLAG_REMAP_SUPPORT		0	 /* Deprecated, was (1 << 6) */
 #define TA_FLAG_CACHE_MAINTENANCE	(1 << 7) /* use cache flush syscall */
 	/*
-	 * TA instance can execute multiple sessions concurrently
-	 * (pseudo-TAs only).
+	 * TA instance can execute multiple sessions concurrently, user
+	 * TAs must also have TA_FLAG_MULTI_SESSION.
 	 */
 #define TA_FLAG_CONCURRENT		(1 << 8)
 #define TA_FLAG_DEVICE_ENUM		(1 << 9) /* device enumeration */
@@ -50,15 +50,31 @@ struct __ftrace_info {
 	union compat_ptr ret_ptr;
 };
 
+/*
+ * One function entry or exit, @ts is the physical counter (CNTPCT) value
+ * and @depth the call depth of the function.
+ */
+struct ftrace_rec {
+	uint64_t ts;
+	uint64_t pc;		/* Address of the function */
+	uint32_t depth;
+	uint32_t is_exit;
+};
+
+/* Overwrite the oldest records instead of stopping when full */
+#define FTRACE_BUF_FLAG_RING	BIT32(0)
+
 struct ftrace_buf {
 	uint64_t ret_func_ptr;	/* __ftrace_return pointer */
 	uint64_t ret_stack[FTRACE_RETFUNC_DEPTH]; /* Return stack */
+	uint64_t func_stack[FTRACE_RETFUNC_DEPTH]; /* Traced functions */
 	uint32_t ret_idx;	/* Return stack index */
 	uint32_t lr_idx;	/* lr index used for stack unwinding */
-	uint32_t curr_size;	/* Size of ftrace buffer */
-	uint32_t max_size;	/* Max allowed size of ftrace buffer */
+	uint64_t rec_count;	/* Number of records ever written */
+	uint32_t max_recs;	/* Number of records, a power of 2 */
+	uint32_t flags;		/* FTRACE_BUF_FLAG_* */
 	uint32_t head_off;	/* Ftrace buffer header offset */
-	uint32_t buf_off;	/* Ftrace buffer offset */
+	uint32_t buf_off;	/* Offset of the struct ftrace_rec array */
 };
 
 /* Defined by the linker script */
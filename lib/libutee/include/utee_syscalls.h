@@ -45,6 +45,12 @@ TEE_Result utee_get_property_name_to_index(unsigned long prop_set,
 					   const void *name,
 					   unsigned long name_len,
 					   uint32_t *index);
+/*
+ * Returns all properties of prop_set provided by the TEE core as an array
+ * of struct utee_property, buf may be NULL if *blen is 0
+ */
+TEE_Result utee_get_property_set(unsigned long prop_set, void *buf,
+				 uint32_t *blen);
 
 
 /* sess has type TEE_TASessionHandle */
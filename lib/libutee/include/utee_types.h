@@ -47,4 +47,19 @@ struct utee_attribute {
 	uint32_t attribute_id;
 };
 
+/*
+ * Property returned by utee_get_property_set(). The name, zero terminated,
+ * and the value follow directly, the next property starts at the next
+ * UTEE_PROPERTY_ALIGN aligned offset. The properties are returned in the
+ * order of the indexes used by utee_get_property().
+ */
+struct utee_property {
+	uint32_t type;		/* enum user_ta_prop_type */
+	uint32_t name_len;	/* Including the terminating zero */
+	uint32_t value_len;
+	uint32_t pad;
+};
+
+#define UTEE_PROPERTY_ALIGN	8
+
 #endif /* UTEE_TYPES_H */
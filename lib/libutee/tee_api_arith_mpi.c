@@ -6,15 +6,20 @@
 #include <mbedtls/bignum.h>
 #include <mempool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <tee_api.h>
 #include <tee_arith_internal.h>
+#include <user_ta_header.h>
 #include <utee_defines.h>
 #include <utee_syscalls.h>
 #include <util.h>
 
 #define MPI_MEMPOOL_SIZE	(12 * 1024)
 
+/* From user_ta_header.c, built within TA */
+extern struct ta_head ta_head;
+
 static void __noreturn api_panic(const char *func, int line, const char *msg)
 {
 	printf("Panic function %s, line %d: %s\n", func, line, msg);
@@ -44,6 +49,13 @@ void _TEE_MathAPI_Init(void)
 {
 	static uint8_t data[MPI_MEMPOOL_SIZE] __aligned(MEMPOOL_ALIGN);
 
+	/*
+	 * The pool is used in a stack like fashion by one thread at a
+	 * time, sessions executing concurrently use the heap instead.
+	 */
+	if (ta_head.flags & TA_FLAG_CONCURRENT)
+		return;
+
 	mbedtls_mpi_mempool = mempool_alloc_pool(data, sizeof(data), NULL);
 	if (!mbedtls_mpi_mempool)
 		API_PANIC("Failed to initialize memory pool");
@@ -437,7 +449,10 @@ void TEE_BigIntMul(TEE_BigInt *dest, const TEE_BigInt *op1,
 	TEE_BigInt zero[TEE_BigIntSizeInU32(1)] = { 0 };
 	TEE_BigInt *tmp = NULL;
 
-	tmp = mempool_alloc(mbedtls_mpi_mempool, sizeof(uint32_t) * s);
+	if (mbedtls_mpi_mempool)
+		tmp = mempool_alloc(mbedtls_mpi_mempool, sizeof(uint32_t) * s);
+	else
+		tmp = malloc(sizeof(uint32_t) * s);
 	if (!tmp)
 		TEE_Panic(TEE_ERROR_OUT_OF_MEMORY);
 
@@ -448,7 +463,10 @@ void TEE_BigIntMul(TEE_BigInt *dest, const TEE_BigInt *op1,
 
 	TEE_BigIntAdd(dest, tmp, zero);
 
-	mempool_free(mbedtls_mpi_mempool, tmp);
+	if (mbedtls_mpi_mempool)
+		mempool_free(mbedtls_mpi_mempool, tmp);
+	else
+		free(tmp);
 }
 
 void TEE_BigIntSquare(TEE_BigInt *dest, const TEE_BigInt *op)
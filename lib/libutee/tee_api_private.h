@@ -15,6 +15,15 @@ void __utee_from_attr(struct utee_attribute *ua, const TEE_Attribute *attrs,
 TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 			struct utee_params *up, unsigned long cmd_id);
 
+struct prop_cache;
+
+/*
+ * Returns where the TEE_PROPSET_CURRENT_CLIENT properties of the session
+ * being entered are cached, or NULL if the session isn't known.
+ */
+struct prop_cache **__utee_session_prop_cache(void);
+void __utee_free_prop_cache(struct prop_cache *pc);
+
 
 #if defined(CFG_TA_GPROF_SUPPORT)
 void __utee_gprof_init(void);
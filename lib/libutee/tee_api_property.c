@@ -19,6 +19,7 @@
 
 #include "string_ext.h"
 #include "base64.h"
+#include "tee_api_private.h"
 
 #define PROP_STR_MAX    80
 
@@ -123,6 +124,219 @@ static TEE_Result propget_get_ext_prop(const struct user_ta_property *ep,
 	return TEE_SUCCESS;
 }
 
+/*
+ * The properties provided by the TEE core are fetched with one syscall the
+ * first time a property of a set is needed. The TA and TEE implementation
+ * sets are cached for the lifetime of the TA instance,
+ * TEE_PROPSET_CURRENT_CLIENT for the lifetime of the session. All
+ * properties of a cached set, including those provided by libutee, are
+ * looked up by name through a hashed index.
+ */
+struct prop_cache {
+	const struct user_ta_property *eps;
+	size_t eps_len;
+	const struct utee_property **props;	/* Provided by the TEE core */
+	size_t num_props;
+	uint32_t *index;	/* Open addressing, property number + 1 */
+	size_t index_mask;
+	void *buf;		/* From utee_get_property_set() */
+};
+
+static struct prop_cache *ta_prop_cache;
+static struct prop_cache *tee_prop_cache;
+
+static uint32_t prop_hash(const char *name)
+{
+	uint32_t h = 2166136261; /* FNV-1a */
+
+	while (*name)
+		h = (h ^ (uint8_t)*name++) * 16777619;
+
+	return h;
+}
+
+static const char *prop_cache_name(struct prop_cache *pc, size_t n)
+{
+	if (n < pc->eps_len)
+		return pc->eps[n].name;
+	return (const char *)(pc->props[n - pc->eps_len] + 1);
+}
+
+static void prop_cache_add_index(struct prop_cache *pc, size_t n)
+{
+	size_t i = prop_hash(prop_cache_name(pc, n));
+
+	/* A duplicate name is found after the first one, like in a scan */
+	while (pc->index[i & pc->index_mask])
+		i++;
+	pc->index[i & pc->index_mask] = n + 1;
+}
+
+static bool prop_cache_find(struct prop_cache *pc, const char *name,
+			    size_t *n)
+{
+	size_t i = prop_hash(name);
+	uint32_t v = 0;
+
+	while (true) {
+		v = pc->index[i & pc->index_mask];
+		if (!v)
+			return false;
+		if (!strcmp(name, prop_cache_name(pc, v - 1))) {
+			*n = v - 1;
+			return true;
+		}
+		i++;
+	}
+}
+
+static void *get_property_set(TEE_PropSetHandle h, uint32_t *blen)
+{
+	TEE_Result res = TEE_SUCCESS;
+	void *buf = NULL;
+
+	*blen = 0;
+	while (true) {
+		res = utee_get_property_set((unsigned long)h, buf, blen);
+		if (res != TEE_ERROR_SHORT_BUFFER)
+			break;
+		free(buf);
+		buf = malloc(*blen);
+		if (!buf)
+			return NULL;
+	}
+
+	if (res != TEE_SUCCESS) {
+		free(buf);
+		return NULL;
+	}
+
+	/* Distinguishes an empty set from an error */
+	if (!buf)
+		buf = malloc(1);
+	return buf;
+}
+
+static struct prop_cache *prop_cache_alloc(TEE_PropSetHandle h)
+{
+	const struct user_ta_property *eps = NULL;
+	const struct utee_property *up = NULL;
+	struct prop_cache *pc = NULL;
+	size_t index_size = 1;
+	size_t num_props = 0;
+	size_t eps_len = 0;
+	uint32_t blen = 0;
+	uint8_t *buf = NULL;
+	size_t pos = 0;
+	size_t n = 0;
+
+	if (propset_get(h, &eps, &eps_len))
+		return NULL;
+
+	buf = get_property_set(h, &blen);
+	if (!buf)
+		return NULL;
+
+	for (pos = 0; pos < blen; num_props++) {
+		up = (const void *)(buf + pos);
+		pos = ROUNDUP(pos + sizeof(*up) + up->name_len + up->value_len,
+			      UTEE_PROPERTY_ALIGN);
+	}
+
+	while (index_size < 2 * (eps_len + num_props))
+		index_size *= 2;
+
+	pc = calloc(1, sizeof(*pc) + num_props * sizeof(*pc->props) +
+		       index_size * sizeof(*pc->index));
+	if (!pc) {
+		free(buf);
+		return NULL;
+	}
+
+	pc->eps = eps;
+	pc->eps_len = eps_len;
+	pc->props = (void *)(pc + 1);
+	pc->num_props = num_props;
+	pc->index = (void *)(pc->props + num_props);
+	pc->index_mask = index_size - 1;
+	pc->buf = buf;
+
+	for (pos = 0, n = 0; n < num_props; n++) {
+		up = (const void *)(buf + pos);
+		pc->props[n] = up;
+		pos = ROUNDUP(pos + sizeof(*up) + up->name_len + up->value_len,
+			      UTEE_PROPERTY_ALIGN);
+	}
+
+	for (n = 0; n < eps_len + num_props; n++)
+		prop_cache_add_index(pc, n);
+
+	return pc;
+}
+
+void __utee_free_prop_cache(struct prop_cache *pc)
+{
+	if (pc) {
+		free(pc->buf);
+		free(pc);
+	}
+}
+
+/* Returns NULL if the set isn't cached, the caller then uses syscalls */
+static struct prop_cache *get_prop_cache(TEE_PropSetHandle h)
+{
+	struct prop_cache **slot = NULL;
+	struct prop_cache *old = NULL;
+	struct prop_cache *pc = NULL;
+
+	if (h == TEE_PROPSET_CURRENT_TA)
+		slot = &ta_prop_cache;
+	else if (h == TEE_PROPSET_TEE_IMPLEMENTATION)
+		slot = &tee_prop_cache;
+	else if (h == TEE_PROPSET_CURRENT_CLIENT)
+		slot = __utee_session_prop_cache();
+	if (!slot)
+		return NULL;
+
+	pc = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+	if (pc)
+		return pc;
+
+	pc = prop_cache_alloc(h);
+	if (!pc)
+		return NULL;
+
+	/* Another thread of a concurrent TA may have been first */
+	if (!__atomic_compare_exchange_n(slot, &old, pc, false,
+					 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		__utee_free_prop_cache(pc);
+		return old;
+	}
+
+	return pc;
+}
+
+static TEE_Result prop_cache_get_value(struct prop_cache *pc, size_t n,
+				       enum user_ta_prop_type *type,
+				       void *buf, uint32_t *len)
+{
+	const struct utee_property *up = NULL;
+
+	if (n < pc->eps_len)
+		return propget_get_ext_prop(pc->eps + n, type, buf, len);
+
+	up = pc->props[n - pc->eps_len];
+	*type = up->type;
+	if (*len < up->value_len) {
+		*len = up->value_len;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	*len = up->value_len;
+	memcpy(buf, (const char *)(up + 1) + up->name_len, up->value_len);
+	return TEE_SUCCESS;
+}
+
 static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 				       enum user_ta_prop_type *type,
 				       void *buf, uint32_t *len)
@@ -132,11 +346,19 @@ static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 	size_t eps_len;
 	uint32_t prop_type;
 	uint32_t index;
+	struct prop_cache *pc = NULL;
 
 	if (h == TEE_PROPSET_CURRENT_TA || h == TEE_PROPSET_CURRENT_CLIENT ||
 	    h == TEE_PROPSET_TEE_IMPLEMENTATION) {
 		size_t n;
 
+		pc = get_prop_cache(h);
+		if (pc) {
+			if (!prop_cache_find(pc, name, &n))
+				return TEE_ERROR_ITEM_NOT_FOUND;
+			return prop_cache_get_value(pc, n, type, buf, len);
+		}
+
 		res = propset_get(h, &eps, &eps_len);
 		if (res != TEE_SUCCESS)
 			return res;
@@ -161,6 +383,13 @@ static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 		if (idx == PROP_ENUMERATOR_NOT_STARTED)
 			return TEE_ERROR_ITEM_NOT_FOUND;
 
+		pc = get_prop_cache(pe->prop_set);
+		if (pc) {
+			if (idx >= pc->eps_len + pc->num_props)
+				return TEE_ERROR_BAD_PARAMETERS;
+			return prop_cache_get_value(pc, idx, type, buf, len);
+		}
+
 		res = propset_get(pe->prop_set, &eps, &eps_len);
 		if (res != TEE_SUCCESS)
 			return res;
@@ -483,6 +712,7 @@ TEE_Result TEE_GetPropertyName(TEE_PropSetHandle enumerator,
 	size_t eps_len;
 	const char *str;
 	size_t bufferlen;
+	struct prop_cache *pc = NULL;
 
 	if (!pe || !name || !name_len) {
 		res = TEE_ERROR_BAD_PARAMETERS;
@@ -494,8 +724,17 @@ TEE_Result TEE_GetPropertyName(TEE_PropSetHandle enumerator,
 	if (res != TEE_SUCCESS)
 		goto err;
 
-	if (pe->idx < eps_len) {
-		str = eps[pe->idx].name;
+	pc = get_prop_cache(pe->prop_set);
+	if (pc && pe->idx >= pc->eps_len + pc->num_props) {
+		res = TEE_ERROR_ITEM_NOT_FOUND;
+		goto err;
+	}
+
+	if (pe->idx < eps_len || pc) {
+		if (pc)
+			str = prop_cache_name(pc, pe->idx);
+		else
+			str = eps[pe->idx].name;
 		bufferlen = strlcpy(name, str, *name_len) + 1;
 		if (bufferlen > *name_len)
 			res = TEE_ERROR_SHORT_BUFFER;
@@ -523,6 +762,7 @@ TEE_Result TEE_GetNextProperty(TEE_PropSetHandle enumerator)
 	uint32_t next_idx;
 	const struct user_ta_property *eps;
 	size_t eps_len;
+	struct prop_cache *pc = NULL;
 
 	if (!pe) {
 		res = TEE_ERROR_BAD_PARAMETERS;
@@ -538,10 +778,16 @@ TEE_Result TEE_GetNextProperty(TEE_PropSetHandle enumerator)
 	if (res != TEE_SUCCESS)
 		goto out;
 
+	pc = get_prop_cache(pe->prop_set);
+
 	next_idx = pe->idx + 1;
 	pe->idx = next_idx;
 	if (next_idx < eps_len)
 		res = TEE_SUCCESS;
+	else if (pc && next_idx < pc->eps_len + pc->num_props)
+		res = TEE_SUCCESS;
+	else if (pc)
+		res = TEE_ERROR_ITEM_NOT_FOUND;
 	else
 		res = utee_get_property((unsigned long)pe->prop_set,
 					next_idx - eps_len,
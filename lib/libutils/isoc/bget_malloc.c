@@ -77,6 +77,7 @@
 #define BufStats    1
 #endif
 
+#include <atomic.h>
 #include <compiler.h>
 #include <malloc.h>
 #include <stdbool.h>
@@ -140,9 +141,7 @@ struct malloc_ctx {
 #ifdef BufStats
 	struct malloc_stats mstats;
 #endif
-#ifdef __KERNEL__
 	unsigned int spinlock;
-#endif
 };
 
 #ifdef __KERNEL__
@@ -159,14 +158,25 @@ static void malloc_unlock(struct malloc_ctx *ctx, uint32_t exceptions)
 
 #else  /* __KERNEL__ */
 
-static uint32_t malloc_lock(struct malloc_ctx *ctx __unused)
+/*
+ * A TA executing sessions concurrently (TA_FLAG_CONCURRENT) may allocate
+ * from several threads at once. User mode can't mask interrupts so this
+ * is a plain spinlock.
+ */
+static uint32_t malloc_lock(struct malloc_ctx *ctx)
 {
+	unsigned int unlocked = 0;
+
+	while (!atomic_cas_uint(&ctx->spinlock, &unlocked, 1))
+		unlocked = 0;
+
 	return 0;
 }
 
-static void malloc_unlock(struct malloc_ctx *ctx __unused,
+static void malloc_unlock(struct malloc_ctx *ctx,
 			  uint32_t exceptions __unused)
 {
+	__atomic_store_n(&ctx->spinlock, 0, __ATOMIC_RELEASE);
 }
 
 #endif	/* __KERNEL__ */
@@ -91,6 +91,12 @@ CFG_MSG_LONG_PREFIX_MASK ?= 0x1a
 # Otherwise, you need to implement hw_get_random_byte() for your platform
 CFG_WITH_SOFTWARE_PRNG ?= y
 
+# With the software PRNG, size in bytes of the per-CPU buffers of random
+# bytes generated in advance. Small crypto_rng_read() requests (up to a
+# quarter of the buffer) are served from them without taking the global
+# PRNG lock. 0 disables the buffers.
+CFG_CORE_RNG_CPU_BUF_SIZE ?= 256
+
 # Number of threads
 CFG_NUM_THREADS ?= 2
 
@@ -222,6 +228,12 @@ CFG_TA_ASLR ?= n
 CFG_TA_ASLR_MIN_OFFSET_PAGES ?= 0
 CFG_TA_ASLR_MAX_OFFSET_PAGES ?= 128
 
+# Keep the relocated writable segments of TA ELFs with the shared read-only
+# segments. When a TA is loaded with all its ELFs at the same addresses as
+# before, ldelf restores them instead of relocating again. This is of little
+# use with CFG_TA_ASLR=y since the addresses rarely match.
+CFG_TA_RELOC_CACHE ?= n
+
 # Load user TAs from the REE filesystem via tee-supplicant
 CFG_REE_FS_TA ?= y
 
@@ -235,6 +247,11 @@ CFG_REE_FS_TA ?= y
 CFG_REE_FS_TA_BUFFERED ?= $(CFG_REE_FS_TA)
 $(eval $(call cfg-depends-all,CFG_REE_FS_TA_BUFFERED,CFG_REE_FS_TA))
 
+# Size of the non-secure shared memory buffer used to load TA binaries from
+# the REE filesystem. Larger TA binaries are streamed through the buffer one
+# chunk at a time. 0 loads the whole binary into one buffer.
+CFG_REE_FS_TA_CHUNK_SIZE ?= 0x40000
+
 # Support for loading user TAs from a special section in the TEE binary.
 # Such TAs are available even before tee-supplicant is available (hence their
 # name), but note that many services exported to TAs may need tee-supplicant,
@@ -265,6 +282,17 @@ ifeq ($(CFG_EARLY_TA),y)
 $(call force,CFG_ZLIB,y)
 endif
 
+# When a TA invokes another TA with a memref in its private memory, map the
+# full pages of large memrefs in the called TA for the duration of the call
+# instead of copying them, read-only for input memrefs. Only the unaligned
+# head and tail of the memref are copied. Paged TA memory is still copied.
+CFG_TA_SHARE_PRIVATE_MEMREF ?= y
+
+# Maximal size in bytes of the pool recycling the temporary secure buffers
+# used to copy memrefs between TAs, 0 disables the pool. Released when TA
+# memory runs short. Not used with CFG_PAGED_USER_TA.
+CFG_TA_BOUNCE_POOL_SIZE ?= 131072
+
 # Enable paging, requires SRAM, can't be enabled by default
 CFG_WITH_PAGER ?= n
 
@@ -276,6 +304,42 @@ CFG_WITH_PAGER ?= n
 # Expect a significant performance impact when enabling this.
 CFG_LOCKDEP ?= n
 
+# Maximal time in microseconds a thread spins on a contended mutex while
+# the owner is running on another CPU before it sleeps in normal world,
+# which costs a sleep and a wakeup RPC. 0 disables spinning.
+CFG_CORE_MUTEX_SPIN_US ?= 10
+
+# Lock contention profiler: records for each mutex call site and each
+# spinlock the number of acquisitions and contended acquisitions, the total
+# and maximal wait and hold times. Read locks have no hold time and
+# spinlocks no call site. The statistics are retrieved with the stats
+# pseudo TA (STATS_CMD_LOCK_STATS), at most CFG_LOCK_STAT_ENTRIES sites
+# are recorded. Expect a significant performance impact when enabling this.
+CFG_LOCK_STAT ?= n
+CFG_LOCK_STAT_ENTRIES ?= 256
+ifeq ($(CFG_LOCK_STAT),y)
+$(call force,CFG_MUTEX_DEBUG,y)
+endif
+
+# Record core events (SMC, RPC, pager faults, waits on locks and syscalls)
+# in per-CPU binary rings of CFG_CORE_TRACE_RING_EVENTS entries (a power
+# of 2) each. Recording is controlled and the rings are retrieved with the
+# trace ring pseudo TA, scripts/trace_ring_decode.py converts a dump into
+# Chrome trace or perf script format. The rings are static, taking
+# 16 bytes per event and CPU even while not recording. Exposes the timing
+# of secure world events to normal world, for development only.
+CFG_CORE_TRACE_RING ?= n
+CFG_CORE_TRACE_RING_EVENTS ?= 1024
+
+# Sample the program counter of the TEE core (arm64 only) with the secure
+# physical timer, interrupt CFG_CORE_PROF_TIMER_IT, and collect per syscall
+# latency histograms. Both are retrieved with the core profiling pseudo TA.
+# The secure physical timer must not be used by anything else on the
+# platform (plat-synquacer forces this off). Exposes the timing of secure
+# world to normal world, for development only.
+CFG_CORE_PROF ?= n
+CFG_CORE_PROF_TIMER_IT ?= 29
+
 # BestFit algorithm in bget reduces the fragmentation of the heap when running
 # with the pager enabled or lockdep
 CFG_CORE_BGET_BESTFIT ?= $(call cfg-one-enabled, CFG_WITH_PAGER CFG_LOCKDEP)
@@ -283,6 +347,24 @@ CFG_CORE_BGET_BESTFIT ?= $(call cfg-one-enabled, CFG_WITH_PAGER CFG_LOCKDEP)
 # Use the pager for user TAs
 CFG_PAGED_USER_TA ?= $(CFG_WITH_PAGER)
 
+# Let user TAs with TA_FLAG_CONCURRENT and TA_FLAG_MULTI_SESSION execute
+# several sessions at the same time in the same instance, each thread with
+# its own user stack. A handle used by a syscall of one session is busy
+# for the other sessions until that syscall returns. The flag is ignored
+# for user TAs if disabled.
+ifeq ($(CFG_PAGED_USER_TA),y)
+$(call force,CFG_TA_CONCURRENT,n,not supported with CFG_PAGED_USER_TA)
+else
+CFG_TA_CONCURRENT ?= y
+endif
+
+# Number of bytes of read-only TA segments kept in memory after the last
+# session of a TA is closed. A TA loaded again while still in this cache
+# reuses the already verified pages instead of copying them again. Cached
+# TAs are evicted in least recently used order, or when TA memory runs
+# out. 0 disables the cache.
+CFG_CORE_FILE_CACHE_SIZE ?= 0x100000
+
 # Enable support for detected undefined behavior in C
 # Uses a lot of memory, can't be enabled by default
 CFG_CORE_SANITIZE_UNDEFINED ?= n
@@ -354,9 +436,18 @@ CFG_TA_GPROF_SUPPORT ?= n
 # When this option is enabled, OP-TEE can execute Trusted Applications
 # instrumented with GCC's -pg flag and will output function tracing
 # information in ftrace.out format to /tmp/ftrace-<ta_uuid>.out (path is
-# defined in tee-supplicant)
+# defined in tee-supplicant). The core lets user mode read the physical
+# counter (CNTKCTL.PL0PCTEN) for the timestamps. CNTKCTL isn't banked
+# between the worlds, the OP-TEE secure monitor saves and restores it on
+# ARM32, while on ARM64 the EL3 firmware (TF-A) is expected to do it.
 CFG_TA_FTRACE_SUPPORT ?= n
 
+# TA function tracing buffer mode. Each function entry and exit is recorded
+# with a counter timestamp. When the buffer (CFG_FTRACE_BUF_SIZE in the TA)
+# is full the oldest records are overwritten with y, keeping the most recent
+# window, else tracing stops, keeping the start of the execution.
+CFG_TA_FTRACE_RING ?= y
+
 # Enable to compile user TA libraries with profiling (-pg).
 # Depends on CFG_TA_GPROF_SUPPORT or CFG_TA_FTRACE_SUPPORT.
 CFG_ULIBS_MCOUNT ?= n
@@ -430,6 +521,15 @@ CFG_CORE_DYN_SHM ?= y
 # memory area).
 CFG_CORE_RESERVED_SHM ?= y
 
+# Enable the message queue in shared memory, normal world posts commands
+# there without holding a thread and they're processed in batches by
+# OPTEE_MSG_CMD_PROCESS_QUEUE calls.
+CFG_CORE_MSG_QUEUE ?= y
+
+# Enable OPTEE_SMC_CALL_INVOKE_WITH_REGS, invoking a command with a few
+# value parameters passed in registers instead of a struct optee_msg_arg.
+CFG_CORE_INVOKE_WITH_REGS ?= y
+
 # Enables support for larger physical addresses, that is, it will define
 # paddr_t as a 64-bit type.
 CFG_CORE_LARGE_PHYS_ADDR ?= n
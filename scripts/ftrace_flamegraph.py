@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2019, agent
+#
+# Computes the inclusive and exclusive time of each function in a TA
+# function graph (/tmp/ftrace-<ta_uuid>.out), preferably symbolized first
+# with scripts/symbolize.py. The default output is the folded stacks
+# format of flamegraph.pl (https://github.com/brendangregg/FlameGraph),
+# weighted with the exclusive time in microseconds:
+#
+#   $ scripts/symbolize.py -d <ta_uuid>.elf < /tmp/ftrace-<ta_uuid>.out | \
+#     scripts/ftrace_flamegraph.py | flamegraph.pl > ta.svg
+
+import argparse
+import re
+import sys
+
+HEADER_RE = re.compile(r'Function graph for TA: .* \((?P<freq>[0-9]+) Hz\)')
+REC_RE = re.compile(r'^\s*(?P<ts>[0-9]+) \| (?P<indent> *)(?P<func>.*)$')
+
+
+def get_args():
+    parser = argparse.ArgumentParser(description='Converts a TA function '
+                                     'graph into folded stacks or per '
+                                     'function timings')
+    parser.add_argument('graph', nargs='?', type=argparse.FileType('r'),
+                        default=sys.stdin, help='function graph (default: '
+                        'stdin)')
+    parser.add_argument('-s', '--stats', action='store_true',
+                        help='print the number of calls, inclusive and '
+                        'exclusive time of each function instead')
+    return parser.parse_args()
+
+
+def read_recs(f):
+    freq = 0
+    recs = []
+    for line in f:
+        m = HEADER_RE.search(line)
+        if m:
+            freq = int(m.group('freq'))
+            continue
+        m = REC_RE.match(line)
+        if not m:
+            continue
+        func = m.group('func').strip()
+        is_exit = func.startswith('}')
+        if is_exit:
+            func = func[1:].strip()
+        elif func.endswith('{'):
+            func = func[:-1].strip()
+        else:
+            continue
+        if func.endswith('()'):
+            func = func[:-2]
+        recs.append((int(m.group('ts')), len(m.group('indent')), func,
+                     is_exit))
+    if not freq:
+        sys.exit('Function graph header with counter frequency not found')
+    return recs, freq
+
+
+def add_missing_entries(recs):
+    # With a wrapped ring buffer the oldest entries may be lost, add them
+    # back at the start of the window for the exits without an entry.
+    stack = []
+    missing = []
+    for ts, depth, func, is_exit in recs:
+        if not is_exit:
+            stack.append(depth)
+        elif stack and stack[-1] == depth:
+            stack.pop()
+        else:
+            missing.append((depth, func))
+    if not recs or not missing:
+        return recs
+    start = recs[0][0]
+    return [(start, d, f, False) for d, f in reversed(missing)] + recs
+
+
+def process(recs):
+    # Each frame is [func, entry ts, time spent in callees]
+    stack = []
+    folded = {}
+    stats = {}
+
+    def pop(ts):
+        func, start, child = stack.pop()
+        incl = ts - start
+        path = ';'.join([s[0] for s in stack] + [func])
+        folded[path] = folded.get(path, 0) + incl - child
+        st = stats.setdefault(func, [0, 0, 0])
+        st[0] += 1
+        st[1] += incl
+        st[2] += incl - child
+        if stack:
+            stack[-1][2] += incl
+
+    for ts, depth, func, is_exit in recs:
+        if is_exit:
+            if stack:
+                pop(ts)
+        else:
+            stack.append([func, ts, 0])
+    # Functions still running when the buffer was dumped
+    while stack and recs:
+        pop(recs[-1][0])
+
+    return folded, stats
+
+
+def main():
+    args = get_args()
+    recs, freq = read_recs(args.graph)
+    folded, stats = process(add_missing_entries(recs))
+    scale = 1000000.0 / freq
+
+    if args.stats:
+        print('{:>8} {:>14} {:>14}  {}'.format('calls', 'incl (us)',
+                                               'excl (us)', 'function'))
+        for func, st in sorted(stats.items(), key=lambda x: -x[1][2]):
+            print('{:8} {:14.3f} {:14.3f}  {}'.format(st[0], st[1] * scale,
+                                                      st[2] * scale, func))
+    else:
+        for path, t in sorted(folded.items()):
+            print('{} {}'.format(path, int(round(t * scale))))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2019, agent
+#
+# Converts a dump of the TEE core trace rings (PTA_TRACE_RING_DUMP, see
+# lib/libutee/include/pta_trace_ring.h) into Chrome trace JSON, viewable
+# with chrome://tracing or Perfetto, or into perf script like text.
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+TRACE_RING_MAGIC = 0x5254504f
+TRACE_RING_VERSION = 1
+TRACE_RING_NO_THREAD = 0xffff
+
+HDR_FMT = '<IIIIQ'
+CPU_FMT = '<Q'
+EVENT_FMT = '<QHHI'
+
+# Event ID without bit 0 -> name, bit 0 set means end of the pair
+EVENT_NAMES = {
+    0x02: 'smc',
+    0x04: 'rpc',
+    0x06: 'pager_fault',
+    0x08: 'wait',
+    0x0a: 'syscall',
+}
+
+MSG_CMDS = ['open_session', 'invoke_command', 'close_session', 'cancel',
+            'register_shm', 'unregister_shm']
+
+RPC_CMDS = {0: 'load_ta', 1: 'rpmb', 2: 'fs', 3: 'get_time',
+            4: 'wait_queue', 5: 'suspend', 6: 'shm_alloc', 7: 'shm_free',
+            9: 'gprof', 10: 'socket', 11: 'ftrace', 12: 'generic',
+            13: 'prefetch_ta', 20: 'bench_reg'}
+
+# Chrome trace thread IDs of the CPUs, above any OP-TEE thread ID
+CPU_TID_BASE = 0x10000
+
+SCN_RE = re.compile(r'#define\s+TEE_SCN_(?P<name>\w+)\s+(?P<nr>\d+)')
+
+
+def get_args():
+    default_scn = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                               '..', 'lib', 'libutee', 'include',
+                               'tee_syscall_numbers.h')
+    parser = argparse.ArgumentParser(description='Decodes a dump of the '
+                                     'OP-TEE core trace rings')
+    parser.add_argument('dump', type=argparse.FileType('rb'),
+                        help='binary dump from PTA_TRACE_RING_DUMP')
+    parser.add_argument('-f', '--format', choices=['chrome', 'perf'],
+                        default='chrome', help='output format (default: '
+                        'chrome)')
+    parser.add_argument('-o', '--output', type=argparse.FileType('w'),
+                        default=sys.stdout, help='output file (default: '
+                        'stdout)')
+    parser.add_argument('-s', '--syscalls', default=default_scn,
+                        help='tee_syscall_numbers.h used to name syscalls')
+    return parser.parse_args()
+
+
+def read_syscall_names(path):
+    names = {}
+    try:
+        with open(path) as f:
+            for line in f:
+                m = SCN_RE.match(line)
+                if m and m.group('name') != 'MAX':
+                    names[int(m.group('nr'))] = m.group('name').lower()
+    except IOError:
+        pass
+    return names
+
+
+def read_events(data):
+    magic, version, num_cpus, num_events, freq = \
+        struct.unpack_from(HDR_FMT, data)
+    if magic != TRACE_RING_MAGIC or version != TRACE_RING_VERSION:
+        sys.exit('Not a trace ring dump (version {})'.format(
+                 TRACE_RING_VERSION))
+    if not freq:
+        sys.exit('Invalid counter frequency')
+
+    events = []
+    offs = struct.calcsize(HDR_FMT)
+    ev_size = struct.calcsize(EVENT_FMT)
+    for cpu in range(num_cpus):
+        head, = struct.unpack_from(CPU_FMT, data, offs)
+        offs += struct.calcsize(CPU_FMT)
+        count = min(head, num_events)
+        for n in range(head - count, head):
+            idx = n & (num_events - 1)
+            ts, ev_id, thread, arg = \
+                struct.unpack_from(EVENT_FMT, data, offs + idx * ev_size)
+            events.append((ts, cpu, ev_id, thread, arg))
+        offs += num_events * ev_size
+
+    events.sort()
+    return events, freq
+
+
+def arg_name(base, arg, syscalls):
+    if base == 0x02 and arg < len(MSG_CMDS):
+        return MSG_CMDS[arg]
+    if base == 0x04:
+        return RPC_CMDS.get(arg, str(arg))
+    if base == 0x0a:
+        return syscalls.get(arg, str(arg))
+    return '{:#x}'.format(arg)
+
+
+def decode(events, freq, syscalls):
+    t0 = events[0][0] if events else 0
+    for ts, cpu, ev_id, thread, arg in events:
+        base = ev_id & ~1
+        name = EVENT_NAMES.get(base, 'event_{:#x}'.format(base))
+        us = (ts - t0) * 1000000.0 / freq
+        # Events outside of a thread are shown per CPU
+        if thread == TRACE_RING_NO_THREAD:
+            tid = CPU_TID_BASE + cpu
+        else:
+            tid = thread
+        yield us, cpu, tid, name, not (ev_id & 1), \
+            arg_name(base, arg, syscalls)
+
+
+def tid_name(tid):
+    if tid >= CPU_TID_BASE:
+        return 'cpu{}'.format(tid - CPU_TID_BASE)
+    return 'thread{}'.format(tid)
+
+
+def output_chrome(out, decoded):
+    trace = []
+    tids = set()
+    for us, cpu, tid, name, begin, arg in decoded:
+        if tid not in tids:
+            tids.add(tid)
+            trace.append({'name': 'thread_name', 'ph': 'M', 'pid': 0,
+                          'tid': tid, 'args': {'name': tid_name(tid)}})
+        trace.append({'name': name, 'cat': 'optee', 'ph': 'B' if begin
+                      else 'E', 'ts': us, 'pid': 0, 'tid': tid,
+                      'args': {'cpu': cpu, 'arg': arg}})
+    json.dump({'traceEvents': trace, 'displayTimeUnit': 'ns'}, out)
+
+
+def output_perf(out, decoded):
+    for us, cpu, tid, name, begin, arg in decoded:
+        out.write('{:>16} [{:03d}] {:.6f}: optee:{}_{}: arg={}\n'.format(
+                  tid_name(tid), cpu, us / 1000000.0, name,
+                  'begin' if begin else 'end', arg))
+
+
+def main():
+    args = get_args()
+    events, freq = read_events(args.dump.read())
+    decoded = decode(events, freq, read_syscall_names(args.syscalls))
+    if args.format == 'chrome':
+        output_chrome(args.output, decoded)
+    else:
+        output_perf(args.output, decoded)
+
+
+if __name__ == '__main__':
+    main()
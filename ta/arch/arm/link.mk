@@ -21,6 +21,7 @@ link-ldflags += -Map=$(link-out-dir$(sm))/$(user-ta-uuid).map
 link-ldflags += --sort-section=alignment
 link-ldflags += -z max-page-size=4096 # OP-TEE always uses 4K alignment
 link-ldflags += --as-needed # Do not add dependency on unused shlib
+link-ldflags += --hash-style=both # DT_GNU_HASH for ldelf, DT_HASH for old loaders
 link-ldflags += $(link-ldflags$(sm))
 
 ifeq ($(CFG_TA_FTRACE_SUPPORT),y)
@@ -20,6 +20,7 @@ cleanfiles += $(link-out-dir)/$(shlibuuid).ta
 shlink-ldflags  = $(LDFLAGS)
 shlink-ldflags += -shared -z max-page-size=4096
 shlink-ldflags += --as-needed # Do not add dependency on unused shlib
+shlink-ldflags += --hash-style=both # DT_GNU_HASH for ldelf, DT_HASH for old loaders
 
 shlink-ldadd  = $(LDADD)
 shlink-ldadd += $(addprefix -L,$(libdirs))
@@ -68,6 +68,15 @@ void __noreturn __ta_entry(unsigned long func, unsigned long session_id,
  */
 #define TA_FRAMEWORK_STACK_SIZE 2048
 
+/*
+ * The TEE arithmetical API implemented with libmpa keeps its temporary
+ * variables in a single memory pool which can't be shared by sessions
+ * executing concurrently.
+ */
+#if (TA_FLAGS & TA_FLAG_CONCURRENT) && !defined(CFG_TA_MBEDTLS_MPI)
+#error TA_FLAG_CONCURRENT requires CFG_TA_MBEDTLS_MPI=y
+#endif
+
 const struct ta_head ta_head __section(".ta_head") = {
 	/* UUID, unique to each TA */
 	.uuid = TA_UUID,